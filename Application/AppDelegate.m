@@ -16,10 +16,14 @@
 	self = [super init];
 
 	if (self) {
+		// the renderer sets the screen of the first run in sweep mode, so it goes before the view
+		id<MTLDevice> device = MTLCreateSystemDefaultDevice();
+		_renderer = [[MetalRenderer alloc] initWithMTLDevice:device];
+
 		NSScreen *screen = [NSScreen mainScreen];
 		const size_t retina = screen.backingScaleFactor == 2.f ? 1 : 0;
 		const NSRect rect = NSMakeRect(0, 0, param.image_w >> retina, param.image_h >> retina);
-		MTKView *view = [[MTKView alloc] initWithFrame:rect device:MTLCreateSystemDefaultDevice()];
+		MTKView *view = [[MTKView alloc] initWithFrame:rect device:device];
 
 		// Keep drawing at a const (vsync) rate, if possible
 		view.enableSetNeedsDisplay = NO;
@@ -33,8 +37,6 @@
 #endif
 		view.colorPixelFormat = MTLPixelFormatR8Unorm;
 
-		_renderer = [[MetalRenderer alloc] initWithMTLDevice:view.device];
-
 		// Largely unnecessary, still confirm the view size with the renderer
 		[_renderer mtkView:view drawableSizeWillChange:view.drawableSize];
 		view.delegate = _renderer;
@@ -1,6 +1,7 @@
 #import <Cocoa/Cocoa.h>
 #import "AppDelegate.h"
 #import "param.h"
+#import "offline.h"
 
 int main(int argc, const char * argv[])
 {
@@ -8,9 +9,40 @@ int main(int argc, const char * argv[])
 	param.image_h = 1440;
 	param.image_hz = 60;
 	param.frames = -1U;
+	param.seek = 0.f;
 	param.frame_msk = -1U;
 	param.group_w = -1U;
 	param.group_h = -1U;
+	param.sampler = SAMPLER_WHITE;
+	param.mode = MODE_REALTIME;
+	param.ref_frames = 0;
+	param.window = 0.f;
+	param.span = 0.f;
+	param.instant_count = 0;
+	param.combo_count = 0;
+	param.sweep.screen_count = 0;
+	param.sweep.group_count = 0;
+	param.sweep.rng_count = 0;
+	param.sweep.frames_count = 0;
+	param.sweep_out = "sweep";
+	param.trace_out = 0;
+	param.build_threads = 0;
+	param.bench_frames = 0;
+	param.bench_thread_count = 0;
+	param.stress_kind = STRESS_UNIFORM;
+	param.stress_voxels = 0;
+	param.stress_motion = 0.f;
+	param.microbench_reps = 0;
+	param.cpu_isa = CPU_ISA_AUTO;
+	param.tile_w = 0;
+	param.tile_h = 0;
+	param.tune_span = 0.f;
+	param.tune_cache = "autotune.txt";
+	param.res_min = 1.f;
+	param.res_max = 1.f;
+	param.ao_refresh = 0.f;
+	param.context_count = 0;
+	param.context_frames = 0;
 
 	// read render setup from CLI
 	const int result_cli = parseCLI(argc, argv);
@@ -18,6 +50,18 @@ int main(int argc, const char * argv[])
 	if (0 != result_cli)
 		return result_cli;
 
+	// offline modes need no window, and no GPU
+	if (MODE_REALTIME != param.mode && MODE_SWEEP != param.mode && MODE_AUTOTUNE != param.mode)
+		return offline_main();
+
+	// autotune the CPU shapes ahead of the GPU ones
+	if (MODE_AUTOTUNE == param.mode) {
+		const int result_cpu = offline_main();
+
+		if (0 != result_cpu)
+			return result_cpu;
+	}
+
 	@autoreleasepool {
 		NSApplication *application = [NSApplication sharedApplication];
 		[application setActivationPolicy:NSApplicationActivationPolicyRegular];
@@ -0,0 +1,1031 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "offline.h"
+#include "param.h"
+#include "cpukernel.h"
+#include "cpubench.h"
+#include "perfcount.h"
+#include "tune.h"
+#include "timer.h"
+#include "stream.hpp"
+
+// verify iostream-free status
+#if _GLIBCXX_IOSTREAM
+#error rogue iostream acquired
+#endif
+
+namespace { // anonymous
+
+// source buffers of a frame, of the sizes requested by content_init
+class FrameBuffers {
+	void* buffer[buffer_designation_count];
+
+public:
+	FrameBuffers() {
+		std::fill(buffer, buffer + buffer_designation_count, nullptr);
+	}
+
+	~FrameBuffers() {
+		for (size_t i = 0; i < buffer_designation_count; ++i)
+			std::free(buffer[i]);
+	}
+
+	// note: practically all buffers of content require 16-byte alignment; since this is
+	// guaranteed by 64-bit malloc, we don't do anything WRT alignment here /32-bit caveat
+	bool init(const content_init_arg& arg) {
+		for (size_t i = 0; i < buffer_designation_count; ++i)
+			if (nullptr == (buffer[i] = std::malloc(arg.buffer_size[i])))
+				return false;
+
+		return true;
+	}
+
+	content_frame_arg get_arg() const {
+		content_frame_arg arg;
+
+		for (size_t i = 0; i < buffer_designation_count; ++i)
+			arg.buffer[i] = buffer[i];
+
+		return arg;
+	}
+};
+
+// tile shape of CPU rendering: width, height
+struct Tile {
+	uint32_t w;
+	uint32_t h;
+};
+
+const Tile default_tile = { 8, 16 };
+
+// key of the CPU entries of the tuning cache: CPU model, thread count and kernel ISA
+void get_cpu_machine(
+	char (& machine)[256]) {
+
+	char model[192];
+	tune_cpu_model(model, sizeof(model));
+
+	std::snprintf(machine, sizeof(machine), "%s, %u threads, %s", model,
+		std::max(std::thread::hardware_concurrency(), 1U), cpukernel_isa_name(cpukernel_isa(param.cpu_isa)));
+}
+
+// tile shape of a frame geometry: that of the CLI, else that of the tuning cache, else the default; the cache is
+// looked up once per geometry in a row
+Tile get_tile(
+	const uint32_t dimx,
+	const uint32_t dimy) {
+
+	if (param.tile_w)
+		return Tile{ param.tile_w, param.tile_h };
+
+	static uint32_t last_dim[2];
+	static Tile last_tile;
+
+	if (last_dim[0] != dimx || last_dim[1] != dimy) {
+		char machine[256];
+		get_cpu_machine(machine);
+
+		uint32_t shape[2];
+		last_tile = 0 == tune_cache_get(TUNE_CPU, machine, dimx, dimy, shape) ? Tile{ shape[0], shape[1] } : default_tile;
+		last_dim[0] = dimx;
+		last_dim[1] = dimy;
+	}
+
+	return last_tile;
+}
+
+void accumulate(
+	cpukernel_stats& sum,
+	const cpukernel_stats& stats) {
+
+	sum.ray_count += stats.ray_count;
+	sum.test_count += stats.test_count;
+	sum.skip_count += stats.skip_count;
+	sum.node_count += stats.node_count;
+	sum.cull_count += stats.cull_count;
+	sum.tile_cull_count += stats.tile_cull_count;
+	sum.ao_cache_count += stats.ao_cache_count;
+}
+
+// render a frame on the CPU, in bands of tile rows handed out to all hardware threads, through the AO cache, if any;
+// add the counts of the kernel to stats, if any
+void render(
+	const content_frame_arg& arg,
+	uint8_t* const dst,
+	const uint32_t dimx,
+	const uint32_t dimy,
+	const Tile tile,
+	cpukernel_aocache* const cache = nullptr,
+	cpukernel_stats* const stats = nullptr) {
+
+	const uint32_t thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+	const uint32_t isa = cpukernel_isa(param.cpu_isa);
+	std::atomic< uint32_t > next(0);
+	std::vector< cpukernel_stats > tally(thread_count, cpukernel_stats());
+
+	const auto worker = [&](const uint32_t i) {
+		for (uint32_t y; (y = next.fetch_add(tile.h)) < dimy;)
+			cpukernel(&arg, dst, dimx, dimy, y, std::min(y + tile.h, dimy), tile.w, cache, isa, &tally[i]);
+	};
+
+	std::vector< std::thread > thread;
+
+	for (uint32_t i = 1; i < thread_count; ++i)
+		thread.emplace_back(worker, i);
+
+	worker(0);
+
+	for (auto& t : thread)
+		t.join();
+
+	if (stats)
+		for (const cpukernel_stats& t : tally)
+			accumulate(*stats, t);
+}
+
+// render a frame on the CPU, in tiles of the shape of its geometry
+void render(
+	const content_frame_arg& arg,
+	uint8_t* const dst,
+	const uint32_t dimx,
+	const uint32_t dimy,
+	cpukernel_aocache* const cache = nullptr,
+	cpukernel_stats* const stats = nullptr) {
+
+	render(arg, dst, dimx, dimy, get_tile(dimx, dimy), cache, stats);
+}
+
+// AO cache of CPU rendering, as per param.ao_refresh; none for a refresh of 0
+class AOCache {
+	cpukernel_aocache* cache;
+
+public:
+	AOCache()
+	: cache(nullptr) {
+	}
+
+	~AOCache() {
+		cpukernel_aocache_release(cache);
+	}
+
+	bool init() {
+		if (0.f == param.ao_refresh)
+			return true;
+
+		return nullptr != (cache = cpukernel_aocache_create(param.ao_refresh));
+	}
+
+	// take the cache to the given content frame; return the cache to render the frame through
+	cpukernel_aocache* update(const content_frame_arg& arg) {
+		if (cache)
+			cpukernel_aocache_update(cache, &arg);
+
+		return cache;
+	}
+};
+
+// luma of an output frame, normalized
+const float luma_scale = 1.f / 255;
+
+// render the reference of the live content frame: the mean of ref_frames unmasked white-noise frames, of frame ids
+// from first_id on
+void render_reference(
+	const content_frame_arg& arg,
+	const uint32_t first_id,
+	const uint32_t dimx,
+	const uint32_t dimy,
+	std::vector< uint8_t >& luma,
+	std::vector< float >& reference) {
+
+	const size_t pixel_count = size_t(dimx) * dimy;
+	const uint32_t sampler = param.sampler;
+	const uint32_t frame_msk = param.frame_msk;
+
+	param.sampler = SAMPLER_WHITE;
+	param.frame_msk = -1U;
+
+	std::fill(reference.begin(), reference.begin() + pixel_count, 0.f);
+
+	for (uint32_t i = 0; i < param.ref_frames; ++i) {
+		content_resample(arg, first_id + i);
+		render(arg, luma.data(), dimx, dimy);
+
+		for (size_t p = 0; p < pixel_count; ++p)
+			reference[p] += luma[p];
+	}
+
+	for (size_t p = 0; p < pixel_count; ++p)
+		reference[p] *= luma_scale / param.ref_frames;
+
+	param.sampler = sampler;
+	param.frame_msk = frame_msk;
+}
+
+// viewer integration of a sequence of 1-spp frames: running mean of all frames (box window), and exponential
+// average of the given time constant at the given Hz (exponential window)
+class Integrator {
+	std::vector< float > box;
+	std::vector< float > expo;
+	float alpha;
+	uint32_t frames;
+
+public:
+	Integrator(
+		const size_t pixel_count,
+		const float window,
+		const uint32_t hz)
+	: box(pixel_count)
+	, expo(pixel_count)
+	, alpha(1.f - std::exp(-1.f / (window * hz)))
+	, frames(0) {
+	}
+
+	void add(const std::vector< uint8_t >& luma) {
+		const float w_box = 1.f / ++frames;
+		const float w_exp = 1 < frames ? alpha : 1.f;
+
+		for (size_t p = 0; p < box.size(); ++p) {
+			box[p] += (luma[p] * luma_scale - box[p]) * w_box;
+			expo[p] += (luma[p] * luma_scale - expo[p]) * w_exp;
+		}
+	}
+
+	const std::vector< float >& get_box() const {
+		return box;
+	}
+
+	const std::vector< float >& get_exp() const {
+		return expo;
+	}
+};
+
+double rmse(
+	const std::vector< float >& a,
+	const std::vector< float >& b) {
+
+	double err = 0.0;
+
+	for (size_t p = 0; p < a.size(); ++p)
+		err += (a[p] - b[p]) * (a[p] - b[p]);
+
+	return std::sqrt(err / a.size());
+}
+
+// separable gaussian blur of sigma 1.5 over 11 taps, clamp to edge
+void blur(
+	const std::vector< float >& src,
+	std::vector< float >& dst,
+	std::vector< float >& tmp,
+	const uint32_t dimx,
+	const uint32_t dimy) {
+
+	const int radius = 5;
+	float kernel[radius * 2 + 1];
+	float sum = 0.f;
+
+	for (int i = -radius; i <= radius; ++i)
+		sum += kernel[i + radius] = std::exp(i * i * (-.5f / (1.5f * 1.5f)));
+
+	for (int i = 0; i <= radius * 2; ++i)
+		kernel[i] /= sum;
+
+	for (int y = 0; y < int(dimy); ++y)
+		for (int x = 0; x < int(dimx); ++x) {
+			float acc = 0.f;
+
+			for (int i = -radius; i <= radius; ++i)
+				acc += kernel[i + radius] * src[y * dimx + std::min(std::max(x + i, 0), int(dimx) - 1)];
+
+			tmp[y * dimx + x] = acc;
+		}
+
+	for (int y = 0; y < int(dimy); ++y)
+		for (int x = 0; x < int(dimx); ++x) {
+			float acc = 0.f;
+
+			for (int i = -radius; i <= radius; ++i)
+				acc += kernel[i + radius] * tmp[std::min(std::max(y + i, 0), int(dimy) - 1) * dimx + x];
+
+			dst[y * dimx + x] = acc;
+		}
+}
+
+// mean SSIM of two luma images, see Zhou Wang et al, "Image quality assessment: from error visibility to
+// structural similarity", 2004
+double ssim(
+	const std::vector< float >& a,
+	const std::vector< float >& b,
+	const uint32_t dimx,
+	const uint32_t dimy) {
+
+	const size_t pixel_count = a.size();
+	const float c1 = .01f * .01f;
+	const float c2 = .03f * .03f;
+
+	std::vector< float > tmp(pixel_count);
+	std::vector< float > prod(pixel_count);
+	std::vector< float > mu_a(pixel_count);
+	std::vector< float > mu_b(pixel_count);
+	std::vector< float > aa(pixel_count);
+	std::vector< float > bb(pixel_count);
+	std::vector< float > ab(pixel_count);
+
+	blur(a, mu_a, tmp, dimx, dimy);
+	blur(b, mu_b, tmp, dimx, dimy);
+
+	for (size_t p = 0; p < pixel_count; ++p)
+		prod[p] = a[p] * a[p];
+
+	blur(prod, aa, tmp, dimx, dimy);
+
+	for (size_t p = 0; p < pixel_count; ++p)
+		prod[p] = b[p] * b[p];
+
+	blur(prod, bb, tmp, dimx, dimy);
+
+	for (size_t p = 0; p < pixel_count; ++p)
+		prod[p] = a[p] * b[p];
+
+	blur(prod, ab, tmp, dimx, dimy);
+
+	double sum = 0.0;
+
+	for (size_t p = 0; p < pixel_count; ++p) {
+		const float var_a = aa[p] - mu_a[p] * mu_a[p];
+		const float var_b = bb[p] - mu_b[p] * mu_b[p];
+		const float cov = ab[p] - mu_a[p] * mu_b[p];
+
+		sum += (2.f * mu_a[p] * mu_b[p] + c1) * (2.f * cov + c2) /
+			((mu_a[p] * mu_a[p] + mu_b[p] * mu_b[p] + c1) * (var_a + var_b + c2));
+	}
+
+	return sum / pixel_count;
+}
+
+// open hardware counters, if asked for, after content_init, for the threads content starts to count too
+void open_counters(
+	PerfCounters& counters) {
+
+	if (0 == (param.flags & FLAG_PERF))
+		return;
+
+	const uint32_t count = counters.open();
+
+	if (perf_counter_count != count)
+		stream::cerr << "warning: " << count << " of " << unsigned(perf_counter_count) << " hardware counters available\n";
+}
+
+void accumulate(
+	PerfSample& sum,
+	const PerfSample& sample) {
+
+	for (size_t i = 0; i < perf_counter_count; ++i)
+		sum.value[i] += sample.value[i];
+}
+
+// put a comma and a counter value, or nothing for a counter not available
+void put_counter(
+	const double value) {
+
+	stream::cout << ',';
+
+	if (!std::isnan(value))
+		stream::cout << value;
+}
+
+// put ipc and per-million-rays misses of a traversal sample
+void put_traversal_counters(
+	const PerfSample& sample,
+	const uint64_t rays) {
+
+	const double mrays = std::max(double(rays), 1.0) * 1e-6;
+
+	put_counter(sample.value[PERF_INSTRUCTIONS] / sample.value[PERF_CYCLES]);
+	put_counter(sample.value[PERF_L1D_MISSES] / mrays);
+	put_counter(sample.value[PERF_LLC_MISSES] / mrays);
+	put_counter(sample.value[PERF_BRANCH_MISSES] / mrays);
+}
+
+const char traversal_counter_columns[] = ",ipc,l1d_misses_per_mray,llc_misses_per_mray,branch_misses_per_mray";
+
+// converge mode: render frames of the scene frozen at the seek time, and report the RMS error of their box-window
+// and exponential-window averages vs a reference of param.ref_frames white-noise frames of the scene; as frames
+// are taken to run at param.image_hz, this tells the time it takes a sampler to reach a given error
+int converge(void)
+{
+	const uint32_t image_w = param.image_w;
+	const uint32_t image_h = param.image_h;
+	const uint32_t frames  = -1U != param.frames ? param.frames : param.image_hz;
+	const size_t pixel_count = size_t(image_w) * image_h;
+	const bool perf = param.flags & FLAG_PERF;
+
+	content_init_arg init_arg;
+	const int result_init = content_init(&init_arg);
+
+	if (0 != result_init)
+		return result_init;
+
+	PerfCounters counters;
+	open_counters(counters);
+
+	FrameBuffers buffers;
+
+	if (!buffers.init(init_arg)) {
+		stream::cerr << "error allocating frame buffers\n";
+		return -1;
+	}
+
+	const content_frame_arg arg = buffers.get_arg();
+
+	// the one and only content frame; all frames henceforth are re-samplings of it
+	const int result_frame = content_frame(arg, 0);
+
+	if (0 != result_frame)
+		return result_frame;
+
+	std::vector< uint8_t > luma(pixel_count);
+	std::vector< float > reference(pixel_count);
+
+	// reference frame ids follow those of the measured frames
+	render_reference(arg, frames, image_w, image_h, luma, reference);
+
+	Integrator integrator(pixel_count, param.window, param.image_hz);
+	AOCache cache;
+
+	if (!cache.init()) {
+		stream::cerr << "error allocating AO cache\n";
+		return -1;
+	}
+
+	stream::cout << "frame,time,rmse_box,rmse_exp";
+
+	if (perf)
+		stream::cout << ",cycles,instructions" << traversal_counter_columns;
+
+	stream::cout << '\n';
+
+	for (uint32_t f = 0; f < frames; ++f) {
+		content_resample(arg, f);
+
+		PerfSample sample;
+		cpukernel_stats stats = {};
+		counters.start();
+
+		render(arg, luma.data(), image_w, image_h, cache.update(arg), &stats);
+
+		counters.stop(sample);
+		integrator.add(luma);
+
+		stream::cout << f << ',' << (f + 1.0) / param.image_hz << ',' <<
+			rmse(integrator.get_box(), reference) << ',' <<
+			rmse(integrator.get_exp(), reference);
+
+		if (perf) {
+			put_counter(sample.value[PERF_CYCLES]);
+			put_counter(sample.value[PERF_INSTRUCTIONS]);
+			put_traversal_counters(sample, stats.ray_count);
+		}
+
+		stream::cout << '\n';
+	}
+
+	return content_deinit();
+}
+
+// spps mode: for each timeline instant, for each resolution x Hz combo, render a reference of the scene frozen at
+// the instant, then the 1-spp frames a viewer would see over param.span seconds at the combo Hz; report the RMSE and
+// SSIM of their box-window and exponential-window averages vs the reference, against the sampling cost, i.e. the
+// samples-per-pixel-per-second, the samples per second, and the CPU time per frame
+int spps(void)
+{
+	if (0 == param.instant_count) {
+		param.instant[0] = param.seek;
+		param.instant_count = 1;
+	}
+
+	if (0 == param.combo_count) {
+		param.combo[0][0] = param.image_w;
+		param.combo[0][1] = param.image_h;
+		param.combo[0][2] = param.image_hz;
+		param.combo_count = 1;
+	}
+
+	size_t max_pixel_count = 0;
+
+	for (uint32_t i = 0; i < param.combo_count; ++i)
+		max_pixel_count = std::max(max_pixel_count, size_t(param.combo[i][0]) * param.combo[i][1]);
+
+	// start the timeline at the first instant
+	param.seek = param.instant[0];
+
+	const bool perf = param.flags & FLAG_PERF;
+
+	content_init_arg init_arg;
+	const int result_init = content_init(&init_arg);
+
+	if (0 != result_init)
+		return result_init;
+
+	PerfCounters counters;
+	open_counters(counters);
+
+	FrameBuffers buffers;
+
+	if (!buffers.init(init_arg)) {
+		stream::cerr << "error allocating frame buffers\n";
+		return -1;
+	}
+
+	const content_frame_arg arg = buffers.get_arg();
+
+	std::vector< uint8_t > luma(max_pixel_count);
+	std::vector< float > reference(max_pixel_count);
+
+	stream::cout << "instant,scene,width,height,hz,frames,spp_per_pixel_per_second,samples_per_second,cpu_ms_per_frame,"
+		"voxel_tests_per_ray,mailbox_skip_rate,node_tests_per_ray,pixel_cull_rate,tile_cull_rate,ao_cache_rate,rmse_box,ssim_box,rmse_exp,ssim_exp";
+
+	if (perf)
+		stream::cout << ",build_cycles,build_instructions,build_llc_misses,cycles_per_frame,instructions_per_frame" << traversal_counter_columns;
+
+	stream::cout << '\n';
+
+	for (uint32_t i = 0; i < param.instant_count; ++i) {
+		if (i) {
+			const int result_seek = content_seek(param.instant[i] - param.instant[i - 1]);
+
+			if (0 != result_seek)
+				return result_seek;
+		}
+
+		for (uint32_t j = 0; j < param.combo_count; ++j) {
+			const uint32_t image_w  = param.combo[j][0];
+			const uint32_t image_h  = param.combo[j][1];
+			const uint32_t image_hz = param.combo[j][2];
+			const uint32_t frames = std::max(uint32_t(param.span * image_hz + .5f), 1U);
+			const size_t pixel_count = size_t(image_w) * image_h;
+
+			param.image_w = image_w;
+			param.image_h = image_h;
+			param.image_hz = image_hz;
+
+			// content frame of the instant at the combo aspect; frame 0 does not advance the timeline
+			PerfSample build;
+			counters.start();
+
+			const int result_frame = content_frame(arg, 0);
+
+			counters.stop(build);
+
+			if (0 != result_frame)
+				return result_frame;
+
+			luma.resize(pixel_count);
+			reference.resize(pixel_count);
+			render_reference(arg, frames, image_w, image_h, luma, reference);
+
+			Integrator integrator(pixel_count, param.window, image_hz);
+			uint64_t render_time = 0;
+			PerfSample traversal = {};
+
+			// the viewer of each combo starts of a cold AO cache
+			AOCache cache;
+
+			if (!cache.init()) {
+				stream::cerr << "error allocating AO cache\n";
+				return -1;
+			}
+
+			cpukernel_stats stats = {};
+
+			for (uint32_t f = 0; f < frames; ++f) {
+				content_resample(arg, f);
+
+				PerfSample sample;
+				counters.start();
+
+				const uint64_t t0 = timer_ns();
+				render(arg, luma.data(), image_w, image_h, cache.update(arg), &stats);
+				render_time += timer_ns() - t0;
+
+				counters.stop(sample);
+				accumulate(traversal, sample);
+
+				integrator.add(luma);
+			}
+
+			// voxel and node tests, voxel tests skipped, per ray traced; pixels culled by the screen rect and by tile, and
+			// shaded from the AO cache, per pixel rendered
+			const double tests = double(stats.test_count + stats.skip_count);
+
+			stream::cout << param.instant[i] << ',' << content_scene() + 1 << ',' << image_w << ',' << image_h << ',' << image_hz << ',' << frames << ',' <<
+				image_hz << ',' << double(pixel_count) * image_hz << ',' << render_time * 1e-6 / frames << ',' <<
+				stats.test_count / std::max(double(stats.ray_count), 1.0) << ',' << stats.skip_count / std::max(tests, 1.0) << ',' <<
+				stats.node_count / std::max(double(stats.ray_count), 1.0) << ',' <<
+				stats.cull_count / (double(pixel_count) * frames) << ',' << stats.tile_cull_count / (double(pixel_count) * frames) << ',' <<
+				stats.ao_cache_count / (double(pixel_count) * frames) << ',' <<
+				rmse(integrator.get_box(), reference) << ',' << ssim(integrator.get_box(), reference, image_w, image_h) << ',' <<
+				rmse(integrator.get_exp(), reference) << ',' << ssim(integrator.get_exp(), reference, image_w, image_h);
+
+			if (perf) {
+				put_counter(build.value[PERF_CYCLES]);
+				put_counter(build.value[PERF_INSTRUCTIONS]);
+				put_counter(build.value[PERF_LLC_MISSES]);
+				put_counter(traversal.value[PERF_CYCLES] / frames);
+				put_counter(traversal.value[PERF_INSTRUCTIONS] / frames);
+				put_traversal_counters(traversal, stats.ray_count);
+			}
+
+			stream::cout << '\n';
+		}
+	}
+
+	return content_deinit();
+}
+
+// microbench mode: for each timeline instant, capture the primary rays of the screen frame, at most
+// microbench_max_rays of them, the AO rays of their hits, and the tests their traversals take; then time each
+// variant of each traversal primitive over the capture param.microbench_reps times, and report the ns per op of
+// the fastest run, the speedup vs the baseline variant of the primitive, and whether their results agree
+enum {
+	microbench_max_rays = 1 << 16,
+	microbench_max_tests = 1 << 20
+};
+
+int microbench(void)
+{
+	if (0 == param.instant_count) {
+		param.instant[0] = param.seek;
+		param.instant_count = 1;
+	}
+
+	// start the timeline at the first instant
+	param.seek = param.instant[0];
+
+	content_init_arg init_arg;
+	const int result_init = content_init(&init_arg);
+
+	if (0 != result_init)
+		return result_init;
+
+	FrameBuffers buffers;
+
+	if (!buffers.init(init_arg)) {
+		stream::cerr << "error allocating frame buffers\n";
+		return -1;
+	}
+
+	const content_frame_arg arg = buffers.get_arg();
+	const uint32_t case_count = cpubench_case_count();
+
+	stream::cout << "instant,scene,primitive,variant,ops_per_run,ns_per_op,speedup,agrees\n";
+
+	for (uint32_t i = 0; i < param.instant_count; ++i) {
+		if (i) {
+			const int result_seek = content_seek(param.instant[i] - param.instant[i - 1]);
+
+			if (0 != result_seek)
+				return result_seek;
+		}
+
+		// content frame of the instant; frame 0 does not advance the timeline
+		const int result_frame = content_frame(arg, 0);
+
+		if (0 != result_frame)
+			return result_frame;
+
+		cpubench_capture* const capture = cpubench_capture_frame(&arg, param.image_w, param.image_h, microbench_max_rays, microbench_max_tests);
+
+		if (nullptr == capture) {
+			stream::cerr << "warning: scene at instant " << param.instant[i] << " is not traced by the tree; skipped\n";
+			continue;
+		}
+
+		double baseline_ns = 0.0;
+		uint64_t baseline_sum = 0;
+
+		for (uint32_t j = 0; j < case_count; ++j) {
+			const cpubench_case name = cpubench_get_case(j);
+			const uint64_t ops = cpubench_op_count(capture, j);
+
+			// a variant that does not apply to the capture
+			if (0 == ops)
+				continue;
+
+			// warm-up run, and the checksum of the variant
+			const uint64_t sum = cpubench_run(capture, j);
+			uint64_t min_time = uint64_t(-1);
+
+			for (uint32_t r = 0; r < param.microbench_reps; ++r) {
+				const uint64_t t0 = timer_ns();
+				cpubench_run(capture, j);
+				min_time = std::min(min_time, timer_ns() - t0);
+			}
+
+			const double ns = double(min_time) / std::max(ops, uint64_t(1));
+			const bool baseline = 0 == j || std::strcmp(name.primitive, cpubench_get_case(j - 1).primitive);
+
+			if (baseline) {
+				baseline_ns = ns;
+				baseline_sum = sum;
+			}
+
+			stream::cout << param.instant[i] << ',' << content_scene() + 1 << ',' << name.primitive << ',' << name.variant << ',' <<
+				ops << ',' << ns << ',' << baseline_ns / ns << ',' << (sum == baseline_sum ? "yes" : "no") << '\n';
+		}
+
+		cpubench_release(capture);
+	}
+
+	return content_deinit();
+}
+
+// autotune mode, CPU part: render the frames of param.tune_span seconds of timeline from the seek time, each once
+// per candidate tile shape, and report the render time per frame of each shape; store the fastest shape in the
+// tuning cache; candidate order rotates from frame to frame, to even out the warmth of caches across shapes
+int autotune(void)
+{
+	const uint32_t image_w = param.image_w;
+	const uint32_t image_h = param.image_h;
+	const uint32_t frames = std::max(uint32_t(param.tune_span * param.image_hz + .5f), 1U);
+
+	std::vector< Tile > candidate;
+
+	for (uint32_t w = 8; w <= 128; w *= 2)
+		for (uint32_t h = 1; h <= 32; h *= 2)
+			candidate.push_back(Tile{ w, h });
+
+	content_init_arg init_arg;
+	const int result_init = content_init(&init_arg);
+
+	if (0 != result_init)
+		return result_init;
+
+	FrameBuffers buffers;
+
+	if (!buffers.init(init_arg)) {
+		stream::cerr << "error allocating frame buffers\n";
+		return -1;
+	}
+
+	const content_frame_arg arg = buffers.get_arg();
+
+	std::vector< uint8_t > luma(size_t(image_w) * image_h);
+	std::vector< uint64_t > render_time(candidate.size(), 0);
+
+	for (uint32_t f = 0; f < frames; ++f) {
+		const int result_frame = content_frame(arg, f);
+
+		if (0 != result_frame)
+			return result_frame;
+
+		// warm-up render of the first frame
+		if (0 == f)
+			render(arg, luma.data(), image_w, image_h, default_tile);
+
+		for (size_t i = 0; i < candidate.size(); ++i) {
+			const size_t k = (i + f) % candidate.size();
+
+			const uint64_t t0 = timer_ns();
+			render(arg, luma.data(), image_w, image_h, candidate[k]);
+			render_time[k] += timer_ns() - t0;
+		}
+	}
+
+	const size_t best = std::min_element(render_time.begin(), render_time.end()) - render_time.begin();
+	const size_t baseline = std::find_if(candidate.begin(), candidate.end(), [](const Tile& tile) {
+		return tile.w == default_tile.w && tile.h == default_tile.h;
+	}) - candidate.begin();
+
+	stream::cout << "tile_w,tile_h,cpu_ms_per_frame,speedup\n";
+
+	for (size_t i = 0; i < candidate.size(); ++i)
+		stream::cout << candidate[i].w << ',' << candidate[i].h << ',' << render_time[i] * 1e-6 / frames << ',' <<
+			double(render_time[baseline]) / std::max(render_time[i], uint64_t(1)) << '\n';
+
+	char machine[256];
+	get_cpu_machine(machine);
+
+	const uint32_t shape[2] = { candidate[best].w, candidate[best].h };
+
+	if (0 == tune_cache_put(TUNE_CPU, machine, image_w, image_h, shape))
+		stream::cerr << "tile (" << shape[0] << ", " << shape[1] << ") stored for " << machine << " at " << image_w << 'x' << image_h << '\n';
+
+	return content_deinit();
+}
+
+// a session of the contexts mode: a content context of its own over a slice of the timeline, its frames rendered on
+// the CPU on the calling thread; frames go to digests, and the counts of the kernel to stats
+struct Session {
+	float seek;                     // timeline start of the context, seconds
+	std::vector< uint64_t > digest; // FNV-1a of each frame
+	cpukernel_stats stats;
+	uint64_t render_time;           // ns, of all frames
+	uint32_t scene;                 // scene of the last frame
+	int result;
+};
+
+// content context of its own, released at scope exit
+class Context {
+	content_context* context;
+
+public:
+	explicit Context(const cli_param& source)
+	: context(content_context_create(&source)) {
+	}
+
+	~Context() {
+		if (context)
+			content_context_release(context);
+	}
+
+	content_context* get() const {
+		return context;
+	}
+};
+
+// 64-bit FNV-1a of a frame
+uint64_t get_digest(
+	const std::vector< uint8_t >& luma) {
+
+	uint64_t hash = 0xcbf29ce484222325;
+
+	for (const uint8_t byte : luma)
+		hash = (hash ^ byte) * 0x100000001b3;
+
+	return hash;
+}
+
+// run a session: param.context_frames frames, a frame period apart, from the seek time of the session; the context
+// builds with the in-house builder, on the calling thread unless told otherwise, as the builder of the testbed is not
+// known to be re-entrant
+void run_session(
+	Session& session,
+	const Tile tile,
+	const uint32_t isa) {
+
+	const uint32_t image_w = param.image_w;
+	const uint32_t image_h = param.image_h;
+	const float period = 1.f / param.image_hz;
+
+	session.digest.clear();
+	session.stats = cpukernel_stats();
+	session.render_time = 0;
+	session.scene = 0;
+	session.result = -1;
+
+	Context context(param);
+
+	if (nullptr == context.get())
+		return;
+
+	cli_param& context_param = *content_context_param(context.get());
+	context_param.seek = session.seek;
+
+	if (0 == context_param.build_threads)
+		context_param.build_threads = 1;
+
+	content_init_arg init_arg;
+
+	if (0 != (session.result = content_context_init(context.get(), &init_arg)))
+		return;
+
+	FrameBuffers buffers;
+	AOCache cache;
+
+	if (!buffers.init(init_arg) || !cache.init()) {
+		session.result = -1;
+		return;
+	}
+
+	const content_frame_arg arg = buffers.get_arg();
+	std::vector< uint8_t > luma(size_t(image_w) * image_h);
+
+	for (uint32_t f = 0; f < param.context_frames; ++f) {
+		// step the timeline by seeking, and take the content frame of the step as frame 0, which does not advance the
+		// timeline, for the frames not to depend on the pace of the session
+		if (f && 0 != (session.result = content_context_seek(context.get(), period)))
+			return;
+
+		if (0 != (session.result = content_context_frame(context.get(), arg, 0)) ||
+			0 != (session.result = content_context_resample(context.get(), arg, f)))
+			return;
+
+		cpukernel_aocache* const frame_cache = cache.update(arg);
+		const uint64_t t0 = timer_ns();
+
+		for (uint32_t y = 0; y < image_h; y += tile.h)
+			cpukernel(&arg, luma.data(), image_w, image_h, y, std::min(y + tile.h, image_h), tile.w, frame_cache, isa, &session.stats);
+
+		session.render_time += timer_ns() - t0;
+		session.digest.push_back(get_digest(luma));
+	}
+
+	session.scene = content_context_scene(context.get());
+}
+
+// contexts mode: render param.context_count content contexts, each over param.context_frames frames of a slice of its
+// own of the timeline, the slices back to back from the seek time; first a context at a time on the calling thread,
+// then all at once, a thread each; report the render times per frame of both runs, and whether each context renders
+// the same frames, and the same kernel counts, in either -- contexts share no mutable state, so they must
+int contexts(void)
+{
+	const uint32_t count = param.context_count;
+	const uint32_t frames = param.context_frames;
+	const Tile tile = get_tile(param.image_w, param.image_h);
+	const uint32_t isa = cpukernel_isa(param.cpu_isa);
+
+	std::vector< Session > alone(count);
+	std::vector< Session > at_once(count);
+
+	for (uint32_t i = 0; i < count; ++i)
+		alone[i].seek = at_once[i].seek = param.seek + float(double(i) * frames / param.image_hz);
+
+	const uint64_t t0 = timer_ns();
+
+	for (Session& session : alone)
+		run_session(session, tile, isa);
+
+	const uint64_t t1 = timer_ns();
+
+	std::vector< std::thread > thread;
+
+	for (uint32_t i = 1; i < count; ++i)
+		thread.emplace_back(run_session, std::ref(at_once[i]), tile, isa);
+
+	run_session(at_once[0], tile, isa);
+
+	for (auto& t : thread)
+		t.join();
+
+	const uint64_t t2 = timer_ns();
+
+	for (uint32_t i = 0; i < count; ++i)
+		if (0 != alone[i].result || 0 != at_once[i].result) {
+			stream::cerr << "error running context " << i << '\n';
+			return 0 != alone[i].result ? alone[i].result : at_once[i].result;
+		}
+
+	stream::cout << "context,seek,scene,frames,rays_per_frame,cpu_ms_per_frame_alone,cpu_ms_per_frame_at_once,identical\n";
+
+	uint32_t mismatches = 0;
+
+	for (uint32_t i = 0; i < count; ++i) {
+		const Session& a = alone[i];
+		const Session& b = at_once[i];
+		const bool identical = a.digest == b.digest && 0 == std::memcmp(&a.stats, &b.stats, sizeof(a.stats));
+
+		mismatches += identical ? 0 : 1;
+
+		stream::cout << i << ',' << a.seek << ',' << a.scene + 1 << ',' << frames << ',' << double(a.stats.ray_count) / frames << ',' <<
+			a.render_time * 1e-6 / frames << ',' << b.render_time * 1e-6 / frames << ',' << (identical ? "yes" : "no") << '\n';
+	}
+
+	stream::cerr << count << " contexts: " << (t1 - t0) * 1e-9 << " s a context at a time, " << (t2 - t1) * 1e-9 << " s all at once\n";
+
+	if (0 != mismatches) {
+		stream::cerr << "error: " << mismatches << " of " << count << " contexts render other frames at once than alone\n";
+		return -1;
+	}
+
+	return 0;
+}
+
+} // namespace anonymous
+
+int offline_main(void)
+{
+	const uint32_t isa = cpukernel_isa(param.cpu_isa);
+
+	if (CPU_ISA_AUTO != param.cpu_isa && isa != param.cpu_isa)
+		stream::cerr << "warning: CPU does not support the requested ISA; rendering with " << cpukernel_isa_name(isa) << '\n';
+
+	switch (param.mode) {
+	case MODE_CONVERGE:
+		return converge();
+
+	case MODE_SPPS:
+		return spps();
+
+	case MODE_BUILD_BENCH:
+		return content_build_bench();
+
+	case MODE_MICROBENCH:
+		return microbench();
+
+	case MODE_AUTOTUNE:
+		return autotune();
+
+	case MODE_CONTEXTS:
+		return contexts();
+	}
+
+	return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef offline_H__
+#define offline_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// run the offline mode selected by parseCLI in lieu of the app; return exit code of the process
+int offline_main(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // offline_H__
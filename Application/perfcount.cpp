@@ -0,0 +1,160 @@
+#include <cmath>
+#include <cstring>
+
+#if __linux__
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "perfcount.h"
+
+// verify iostream-free status
+#if _GLIBCXX_IOSTREAM
+#error rogue iostream acquired
+#endif
+
+#if __linux__
+namespace { // anonymous
+
+const struct {
+	uint32_t type;
+	uint64_t config;
+}
+event[] = {
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+		PERF_COUNT_HW_CACHE_OP_READ << 8 |
+		PERF_COUNT_HW_CACHE_RESULT_MISS << 16 },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+static_assert(sizeof(event) / sizeof(event[0]) == perf_counter_count, "perf event missing");
+
+// read value, time enabled and time running of a counter
+bool read_counter(
+	const int fd,
+	uint64_t (& value)[3]) {
+
+	return ssize_t(sizeof(value)) == read(fd, value, sizeof(value));
+}
+
+// open a counter on the given thread, and on the threads it starts henceforth, once they exit; return its fd or -1
+int open_counter(
+	const size_t i,
+	const pid_t tid) {
+
+	perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+
+	attr.size = sizeof(attr);
+	attr.type = event[i].type;
+	attr.config = event[i].config;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	// this thread, any CPU, no group
+	return int(syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+}
+
+} // namespace
+#endif
+
+PerfCounters::PerfCounters()
+: thread_count(0) {
+	std::memset(start_value, 0, sizeof(start_value));
+}
+
+PerfCounters::~PerfCounters() {
+#if __linux__
+	for (uint32_t t = 0; t < thread_count; ++t)
+		for (size_t i = 0; i < perf_counter_count; ++i)
+			if (-1 != fd[t][i])
+				close(fd[t][i]);
+
+#endif
+}
+
+uint32_t PerfCounters::open() {
+	uint32_t count = 0;
+
+#if __linux__
+	if (0 == thread_count) {
+		// the calling thread first, then the other threads of the process; a thread counts from its inherited
+		// counters only once it exits, so persistent threads take counters of their own
+		const pid_t self = pid_t(syscall(SYS_gettid));
+		pid_t tid[max_threads] = { self };
+		thread_count = 1;
+
+		if (DIR* const dir = opendir("/proc/self/task")) {
+			while (const dirent* const entry = readdir(dir)) {
+				const pid_t t = pid_t(std::atoi(entry->d_name));
+
+				if (0 != t && self != t && max_threads != thread_count)
+					tid[thread_count++] = t;
+			}
+
+			closedir(dir);
+		}
+
+		for (uint32_t t = 0; t < thread_count; ++t)
+			for (size_t i = 0; i < perf_counter_count; ++i)
+				fd[t][i] = open_counter(i, tid[t]);
+	}
+
+	// a counter is available if of the calling thread
+	for (size_t i = 0; i < perf_counter_count; ++i)
+		count += uint32_t(-1 != fd[0][i]);
+
+#endif
+	return count;
+}
+
+void PerfCounters::start() {
+#if __linux__
+	for (uint32_t t = 0; t < thread_count; ++t)
+		for (size_t i = 0; i < perf_counter_count; ++i)
+			if (-1 != fd[t][i] && !read_counter(fd[t][i], start_value[t][i]))
+				std::memset(start_value[t][i], 0, sizeof(start_value[t][i]));
+
+#endif
+}
+
+void PerfCounters::stop(PerfSample& sample) {
+	for (size_t i = 0; i < perf_counter_count; ++i) {
+		sample.value[i] = NAN;
+
+#if __linux__
+		if (0 == thread_count || -1 == fd[0][i])
+			continue;
+
+		double sum = 0.0;
+
+		for (uint32_t t = 0; t < thread_count; ++t) {
+			uint64_t value[3];
+
+			if (-1 == fd[t][i] || !read_counter(fd[t][i], value))
+				continue;
+
+			const uint64_t delta = value[0] - start_value[t][i][0];
+			const uint64_t enabled = value[1] - start_value[t][i][1];
+			const uint64_t running = value[2] - start_value[t][i][2];
+
+			// a counter that never ran over the interval tells nothing
+			if (0 == running)
+				continue;
+
+			sum += double(delta) * (double(enabled) / running);
+		}
+
+		sample.value[i] = sum;
+
+#endif
+	}
+}
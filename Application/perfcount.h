@@ -0,0 +1,47 @@
+#ifndef perfcount_H__
+#define perfcount_H__
+
+#include <stdint.h>
+
+enum perf_counter {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_L1D_MISSES,    // L1 data cache read misses
+	PERF_LLC_MISSES,    // last-level cache misses
+	PERF_BRANCH_MISSES, // branch mispredicts
+
+	perf_counter_count
+};
+
+// counter values over an interval; a counter not available reads as NaN
+struct PerfSample {
+	double value[perf_counter_count];
+};
+
+// hardware performance counters of the process, user space only, summed over the threads of the process as of
+// open -- persistent workers, such as the tree builder pool, included -- and the threads these start after open,
+// counted once they exit, via perf_event_open on Linux; counters multiplexed by the kernel are scaled to the full
+// interval; elsewhere, or where the kernel denies access, counters are not available
+class PerfCounters {
+	enum { max_threads = 256 };
+
+	// counters per thread, the calling thread first
+	int fd[max_threads][perf_counter_count];
+	uint32_t thread_count;
+
+	// values, time enabled and time running, as of start
+	uint64_t start_value[max_threads][perf_counter_count][3];
+
+public:
+	PerfCounters();
+	~PerfCounters();
+
+	// open all counters, on all threads of the process; open once the threads to count are started; return count
+	// of counters available
+	uint32_t open();
+
+	void start();
+	void stop(PerfSample& sample);
+};
+
+#endif // perfcount_H__
@@ -0,0 +1,432 @@
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "octree.h"
+
+// verify iostream-free status
+#if _GLIBCXX_IOSTREAM
+#error rogue iostream acquired
+#endif
+
+// pool of worker threads running the tasks of a job along with the thread submitting the job
+class WorkerPool {
+public:
+	typedef void (* Task)(void* context, uint32_t index);
+
+private:
+	std::thread* worker;
+	uint32_t worker_count;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	uint64_t generation; // count of jobs submitted
+	uint32_t pending;    // workers yet to finish the current job
+	bool quit;
+
+	Task task;
+	void* context;
+	uint32_t task_count;
+	std::atomic< uint32_t > next; // next task to take
+
+	void drain() {
+		for (uint32_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < task_count;)
+			task(context, i);
+	}
+
+	void work() {
+		for (uint64_t seen = 0;;) {
+			{
+				std::unique_lock< std::mutex > lock(mutex);
+				wake.wait(lock, [&] { return quit || generation != seen; });
+
+				if (quit)
+					return;
+
+				seen = generation;
+			}
+
+			drain();
+
+			std::lock_guard< std::mutex > lock(mutex);
+
+			if (0 == --pending)
+				done.notify_one();
+		}
+	}
+
+public:
+	WorkerPool(const uint32_t worker_count)
+	: worker(new std::thread[worker_count])
+	, worker_count(worker_count)
+	, generation(0)
+	, pending(0)
+	, quit(false)
+	, task(nullptr)
+	, context(nullptr)
+	, task_count(0)
+	, next(0) {
+		for (uint32_t i = 0; i < worker_count; ++i)
+			worker[i] = std::thread(&WorkerPool::work, this);
+	}
+
+	~WorkerPool() {
+		{
+			std::lock_guard< std::mutex > lock(mutex);
+			quit = true;
+		}
+
+		wake.notify_all();
+
+		for (uint32_t i = 0; i < worker_count; ++i)
+			worker[i].join();
+
+		delete [] worker;
+	}
+
+	// run tasks [0, count) to completion
+	void run(
+		const Task task,
+		void* const context,
+		const uint32_t count) {
+
+		{
+			std::lock_guard< std::mutex > lock(mutex);
+			this->task = task;
+			this->context = context;
+			this->task_count = count;
+			this->next.store(0, std::memory_order_relaxed);
+			this->pending = worker_count;
+			++generation;
+		}
+
+		wake.notify_all();
+		drain();
+
+		std::unique_lock< std::mutex > lock(mutex);
+		done.wait(lock, [&] { return 0 == pending; });
+	}
+};
+
+namespace { // anonymous
+
+enum {
+	cell_dim = 4,                                // cells per axis of the root bbox
+	key_count = cell_dim * cell_dim * cell_dim,  // cells of all leaves
+	key_bits = 6,                                // bits of a cell key
+	max_payload = 65535                          // payload entries addressable by ushort start and count
+};
+
+struct BuildJob {
+	const Array< Voxel >* voxel;
+	uint32_t voxel_count;
+	uint32_t chunk_count;
+	float bound[3][cell_dim + 1]; // cell boundaries per axis, as the kernels subdivide the root bbox
+	uint32_t (* cell_count)[key_count];
+	uint16_t* code;
+	float (* payload)[8];
+};
+
+// chunk c of the voxels: [begin, end)
+inline void get_chunk(
+	const BuildJob& job,
+	const uint32_t c,
+	uint32_t& begin,
+	uint32_t& end) {
+
+	begin = uint32_t(uint64_t(job.voxel_count) * c / job.chunk_count);
+	end = uint32_t(uint64_t(job.voxel_count) * (c + 1) / job.chunk_count);
+}
+
+// cell span of a voxel along an axis: cells the voxel overlaps by more than a boundary; a voxel
+// flat at a boundary goes to the cell past it
+inline void get_span(
+	const float (& bound)[cell_dim + 1],
+	const float min,
+	const float max,
+	uint32_t& lo,
+	uint32_t& hi) {
+
+	lo = uint32_t(bound[1] <= min) + uint32_t(bound[2] <= min) + uint32_t(bound[3] <= min);
+	hi = cell_dim - 1 - uint32_t(bound[1] >= max) - uint32_t(bound[2] >= max) - uint32_t(bound[3] >= max);
+	hi = hi < lo ? lo : hi;
+}
+
+// cell key: the 2-level Morton code of the cell, i.e. leaf octant major, child octant minor, as the
+// payload is laid out
+inline uint32_t get_key(
+	const uint32_t x,
+	const uint32_t y,
+	const uint32_t z) {
+
+	const uint32_t octant = x >> 1 | (y >> 1) << 1 | (z >> 1) << 2;
+	const uint32_t child = (x & 1) | (y & 1) << 1 | (z & 1) << 2;
+
+	return octant << 3 | child;
+}
+
+// cell of a key
+inline void get_cell(
+	const uint32_t key,
+	uint32_t& x,
+	uint32_t& y,
+	uint32_t& z) {
+
+	x = (key >> 2 & 2) | (key >> 0 & 1);
+	y = (key >> 3 & 2) | (key >> 1 & 1);
+	z = (key >> 4 & 2) | (key >> 2 & 1);
+}
+
+// voxel code: keys of the first and the last cells the voxel spans; equal for the common voxel of
+// a single cell
+inline uint16_t get_code(
+	const uint32_t key_lo,
+	const uint32_t key_hi) {
+
+	return uint16_t(key_hi << key_bits | key_lo);
+}
+
+// code voxels of chunk c, and count the cell entries of the chunk
+void classify(
+	void* const context,
+	const uint32_t c) {
+
+	BuildJob& job = *reinterpret_cast< BuildJob* >(context);
+	uint32_t (& cell)[key_count] = job.cell_count[c];
+
+	std::memset(cell, 0, sizeof(cell));
+
+	uint32_t begin, end;
+	get_chunk(job, c, begin, end);
+
+	for (uint32_t i = begin; i < end; ++i) {
+		const BBox bbox = job.voxel->getElement(i).get_bbox();
+		const simd::f32x4 min = bbox.get_min();
+		const simd::f32x4 max = bbox.get_max();
+
+		uint32_t lo[3], hi[3];
+
+		for (uint32_t j = 0; j < 3; ++j)
+			get_span(job.bound[j], min[j], max[j], lo[j], hi[j]);
+
+		const uint32_t key_lo = get_key(lo[0], lo[1], lo[2]);
+		const uint32_t key_hi = get_key(hi[0], hi[1], hi[2]);
+
+		job.code[i] = get_code(key_lo, key_hi);
+
+		if (key_lo == key_hi) {
+			cell[key_lo]++;
+			continue;
+		}
+
+		// duplicate into all cells spanned
+		for (uint32_t z = lo[2]; z <= hi[2]; ++z)
+			for (uint32_t y = lo[1]; y <= hi[1]; ++y)
+				for (uint32_t x = lo[0]; x <= hi[0]; ++x)
+					cell[get_key(x, y, z)]++;
+	}
+}
+
+inline void set_entry(
+	float (& entry)[8],
+	const simd::f32x4& min,
+	const simd::f32x4& max,
+	const uint32_t id) {
+
+	float cookie;
+	std::memcpy(&cookie, &id, sizeof(cookie));
+
+	entry[0] = min[0];
+	entry[1] = min[1];
+	entry[2] = min[2];
+	entry[3] = cookie;
+	entry[4] = max[0];
+	entry[5] = max[1];
+	entry[6] = max[2];
+	entry[7] = cookie;
+}
+
+// write the cell entries of chunk c at the chunk offsets of the cells, by the voxel codes
+void scatter(
+	void* const context,
+	const uint32_t c) {
+
+	BuildJob& job = *reinterpret_cast< BuildJob* >(context);
+	uint32_t (& cell)[key_count] = job.cell_count[c];
+
+	uint32_t begin, end;
+	get_chunk(job, c, begin, end);
+
+	for (uint32_t i = begin; i < end; ++i) {
+		const BBox bbox = job.voxel->getElement(i).get_bbox();
+		const simd::f32x4 min = bbox.get_min();
+		const simd::f32x4 max = bbox.get_max();
+
+		const uint32_t key_lo = job.code[i] & (key_count - 1);
+		const uint32_t key_hi = job.code[i] >> key_bits;
+
+		if (key_lo == key_hi) {
+			set_entry(job.payload[cell[key_lo]++], min, max, i);
+			continue;
+		}
+
+		uint32_t lo[3], hi[3];
+		get_cell(key_lo, lo[0], lo[1], lo[2]);
+		get_cell(key_hi, hi[0], hi[1], hi[2]);
+
+		for (uint32_t z = lo[2]; z <= hi[2]; ++z)
+			for (uint32_t y = lo[1]; y <= hi[1]; ++y)
+				for (uint32_t x = lo[0]; x <= hi[0]; ++x)
+					set_entry(job.payload[cell[get_key(x, y, z)]++], min, max, i);
+	}
+}
+
+} // namespace
+
+OctreeBuilder::OctreeBuilder()
+: pool(nullptr)
+, thread_count(0)
+, entry_count(0)
+, cell_count(nullptr)
+, code(nullptr)
+, code_capacity(0) {
+	set_thread_count(1);
+}
+
+OctreeBuilder::~OctreeBuilder() {
+	delete pool;
+	std::free(cell_count);
+	std::free(code);
+}
+
+bool OctreeBuilder::set_thread_count(
+	const uint32_t count) {
+
+	if (0 == count)
+		return false;
+
+	if (count == thread_count)
+		return true;
+
+	delete pool;
+	pool = nullptr;
+	std::free(cell_count);
+	thread_count = 0;
+
+	cell_count = reinterpret_cast< uint32_t (*)[64] >(std::malloc(sizeof(*cell_count) * count));
+
+	if (nullptr == cell_count)
+		return false;
+
+	if (count > 1)
+		pool = new WorkerPool(count - 1);
+
+	thread_count = count;
+	return true;
+}
+
+bool OctreeBuilder::build(
+	const Array< Voxel >& voxel,
+	const BBox& root_bbox,
+	const Storage& storage) {
+
+	if (0 == thread_count || 0 == storage.octet_count || storage.leaf_count < 8)
+		return false;
+
+	const size_t voxel_count = voxel.getCount();
+
+	if (voxel_count > code_capacity) {
+		uint16_t* const grown = reinterpret_cast< uint16_t* >(std::realloc(code, sizeof(*code) * voxel_count));
+
+		if (nullptr == grown)
+			return false;
+
+		code = grown;
+		code_capacity = voxel_count;
+	}
+
+	BuildJob job;
+	job.voxel = &voxel;
+	job.voxel_count = uint32_t(voxel_count);
+	job.chunk_count = thread_count;
+	job.cell_count = cell_count;
+	job.code = code;
+	job.payload = reinterpret_cast< float (*)[8] >(storage.voxel);
+
+	// subdivide as get_child_bbox does, for routing to agree with traversal to the last bit
+	const simd::f32x4 root_min = root_bbox.get_min();
+	const simd::f32x4 root_max = root_bbox.get_max();
+
+	for (uint32_t j = 0; j < 3; ++j) {
+		float (& bound)[cell_dim + 1] = job.bound[j];
+
+		bound[0] = root_min[j];
+		bound[4] = root_max[j];
+		bound[2] = (bound[0] + bound[4]) * .5f;
+		bound[1] = (bound[0] + bound[2]) * .5f;
+		bound[3] = (bound[2] + bound[4]) * .5f;
+	}
+
+	// code voxels and count cell entries per chunk
+	if (pool)
+		pool->run(classify, &job, job.chunk_count);
+	else
+		classify(&job, 0);
+
+	// turn counts to write offsets: cells in key order, chunks in voxel order within a cell
+	uint32_t cell_start[key_count];
+	uint32_t cell_total[key_count];
+	uint32_t offset = 0;
+
+	for (uint32_t key = 0; key < key_count; ++key) {
+		cell_start[key] = offset;
+
+		for (uint32_t c = 0; c < job.chunk_count; ++c) {
+			const uint32_t count = job.cell_count[c][key];
+			job.cell_count[c][key] = offset;
+			offset += count;
+		}
+
+		cell_total[key] = offset - cell_start[key];
+	}
+
+	if (offset > storage.voxel_count || offset > max_payload)
+		return false;
+
+	// emit root octet and non-empty leaves
+	uint16_t (& octet)[8] = *reinterpret_cast< uint16_t (*)[8] >(storage.octet);
+	uint16_t (* const leaf)[16] = reinterpret_cast< uint16_t (*)[16] >(storage.leaf);
+	uint16_t leaf_idx = 0;
+
+	for (uint32_t o = 0; o < 8; ++o) {
+		uint32_t total = 0;
+
+		for (uint32_t k = 0; k < 8; ++k)
+			total += cell_total[o * 8 + k];
+
+		if (0 == total) {
+			octet[o] = uint16_t(-1);
+			continue;
+		}
+
+		for (uint32_t k = 0; k < 8; ++k) {
+			leaf[leaf_idx][k + 0] = uint16_t(cell_start[o * 8 + k]);
+			leaf[leaf_idx][k + 8] = uint16_t(cell_total[o * 8 + k]);
+		}
+
+		octet[o] = leaf_idx++;
+	}
+
+	// duplicate voxels into the cells they span
+	if (pool)
+		pool->run(scatter, &job, job.chunk_count);
+	else
+		scatter(&job, 0);
+
+	entry_count = offset;
+	return true;
+}
@@ -0,0 +1,67 @@
+#ifndef octree_H__
+#define octree_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "vectnative.hpp"
+#include "array.hpp"
+#include "problem_6.hpp"
+
+class WorkerPool;
+
+// builder of the tree of the kernels: a root octet over up to 8 leaves, one per root octant, each over
+// up to 8 cells of voxel payload, and voxels spanning several cells duplicated into each of them; see
+// the maps in start_timeline for the layout
+//
+// the build is a counting sort of the voxels by the Morton codes of the cells they span -- 6 bits for
+// the 2 levels of the tree, so a single radix-sort pass -- parallel over ordered chunks of the voxels:
+// each thread codes its chunk and counts the entries per cell, then scatters the entries of its chunk;
+// the entries of a cell are laid out in chunk order, so the output is the same, byte for byte, for
+// any thread count
+class OctreeBuilder {
+	WorkerPool* pool;
+	uint32_t thread_count;
+	uint32_t entry_count; // payload entries of the last build
+
+	// per-chunk cell entry counts, then write offsets
+	uint32_t (* cell_count)[64];
+
+	// per-voxel codes: keys of the first and last cells spanned
+	uint16_t* code;
+	size_t code_capacity;
+
+public:
+	struct Storage {
+		void* octet;
+		size_t octet_count;
+		void* leaf;
+		size_t leaf_count;
+		void* voxel;
+		size_t voxel_count;
+	};
+
+	OctreeBuilder();
+	~OctreeBuilder();
+
+	// set count of threads to build with, the calling thread included; false on failure to start them
+	bool set_thread_count(const uint32_t count);
+
+	uint32_t get_thread_count() const {
+		return thread_count;
+	}
+
+	// get count of payload entries of the last successful build, duplicates included
+	uint32_t get_entry_count() const {
+		return entry_count;
+	}
+
+	// build a tree of the given root bbox over the voxels; cookie of a voxel is its index; false
+	// if the tree does not fit the storage
+	bool build(
+		const Array< Voxel >& voxel,
+		const BBox& root_bbox,
+		const Storage& storage);
+};
+
+#endif // octree_H__
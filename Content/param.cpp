@@ -4,8 +4,12 @@
 #include <cstdio>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
+#include <thread>
 
 #include "param.h"
+#include "trace.h"
+#include "octree.h"
 #include "timer.h"
 #include "vectnative.hpp"
 #include "pure_macro.hpp"
@@ -40,6 +44,47 @@ const char arg_frame_id_mask[]            = "frame_id_mask";
 const char arg_frame_invar_rng[]          = "frame_invar_rng";
 const char arg_workgroup_size[]           = "group_size";
 const char arg_borderful[]                = "borderful";
+const char arg_wavefront[]                = "wavefront";
+const char arg_octant_order[]             = "octant_order";
+const char arg_mailbox[]                  = "mailbox";
+const char arg_tile_cull[]                = "tile_cull";
+const char arg_perf[]                     = "perf";
+const char arg_seek[]                     = "seek";
+const char arg_heightfield[]              = "heightfield";
+const char arg_sampler[]                  = "sampler";
+const char arg_converge[]                 = "converge";
+const char arg_spps[]                     = "spps";
+const char arg_instants[]                 = "instants";
+const char arg_combos[]                   = "combos";
+const char arg_sweep[]                    = "sweep";
+const char arg_sweep_out[]                = "sweep_out";
+const char arg_trace[]                    = "trace";
+const char arg_build_threads[]            = "build_threads";
+const char arg_build_bench[]              = "build_bench";
+const char arg_stress[]                   = "stress";
+const char arg_microbench[]               = "microbench";
+const char arg_cpu_isa[]                  = "cpu_isa";
+const char arg_tile_size[]                = "tile_size";
+const char arg_autotune[]                 = "autotune";
+const char arg_tune_cache[]               = "tune_cache";
+const char arg_dyn_res[]                  = "dyn_res";
+const char arg_ao_cache[]                 = "ao_cache";
+const char arg_contexts[]                 = "contexts";
+
+const char sampler_white[]                = "white";
+const char sampler_blue_r2[]              = "blue_r2";
+const char sampler_blue_sobol[]           = "blue_sobol";
+
+const char cpu_isa_auto[]                 = "auto";
+const char cpu_isa_generic[]              = "generic";
+const char cpu_isa_avx2[]                 = "avx2";
+const char cpu_isa_avx512[]               = "avx512";
+const char cpu_isa_neon[]                 = "neon";
+
+const char stress_uniform[]               = "uniform";
+const char stress_clustered[]             = "clustered";
+const char stress_heightfield[]           = "heightfield";
+const char stress_shell[]                 = "shell";
 
 namespace testbed {
 
@@ -54,6 +99,300 @@ public:
 
 } // namespace testbed
 
+static bool
+validate_sampler(
+	const char *const string,
+	unsigned &sampler) {
+
+	if (0 == string)
+		return false;
+
+	if (!std::strcmp(string, sampler_white)) {
+		sampler = SAMPLER_WHITE;
+		return true;
+	}
+
+	if (!std::strcmp(string, sampler_blue_r2)) {
+		sampler = SAMPLER_BLUE_R2;
+		return true;
+	}
+
+	if (!std::strcmp(string, sampler_blue_sobol)) {
+		sampler = SAMPLER_BLUE_SOBOL;
+		return true;
+	}
+
+	return false;
+}
+
+static bool
+validate_cpu_isa(
+	const char *const string,
+	uint32_t &isa) {
+
+	if (0 == string)
+		return false;
+
+	if (!std::strcmp(string, cpu_isa_auto)) {
+		isa = CPU_ISA_AUTO;
+		return true;
+	}
+
+	if (!std::strcmp(string, cpu_isa_generic)) {
+		isa = CPU_ISA_GENERIC;
+		return true;
+	}
+
+	if (!std::strcmp(string, cpu_isa_avx2)) {
+		isa = CPU_ISA_AVX2;
+		return true;
+	}
+
+	if (!std::strcmp(string, cpu_isa_avx512)) {
+		isa = CPU_ISA_AVX512;
+		return true;
+	}
+
+	if (!std::strcmp(string, cpu_isa_neon)) {
+		isa = CPU_ISA_NEON;
+		return true;
+	}
+
+	return false;
+}
+
+static bool
+validate_instants(
+	const char *const string,
+	float (& instant)[max_instants],
+	uint32_t &count) {
+
+	if (0 == string)
+		return false;
+
+	uint32_t n = 0;
+	int len;
+
+	// the whole string must parse, to no more than max_instants entries
+	for (const char* s = string + strspn(string, " \t"); '\0' != *s; s += strspn(s, " \t"), ++n) {
+		if (max_instants == n || 1 != sscanf(s, "%f%n", &instant[n], &len) || !(instant[n] >= 0.f) ||
+			0 == strchr(" \t", s[len]))
+			return false;
+
+		s += len;
+	}
+
+	if (0 == n)
+		return false;
+
+	// instants are visited in order
+	std::sort(instant, instant + n);
+	count = n;
+
+	return true;
+}
+
+static bool
+validate_combos(
+	const char *const string,
+	uint32_t (& combo)[max_combos][3],
+	uint32_t &count) {
+
+	if (0 == string)
+		return false;
+
+	uint32_t n = 0;
+	int len;
+
+	// the whole string must parse, to no more than max_combos entries
+	for (const char* s = string + strspn(string, " \t"); '\0' != *s; s += strspn(s, " \t"), ++n) {
+		if (max_combos == n || 3 != sscanf(s, "%ux%u@%u%n", &combo[n][0], &combo[n][1], &combo[n][2], &len) ||
+			!combo[n][0] || !combo[n][1] || !combo[n][2] || 0 == strchr(" \t", s[len]))
+			return false;
+
+		s += len;
+	}
+
+	if (0 == n)
+		return false;
+
+	count = n;
+
+	return true;
+}
+
+// sweep matrix: whitespace-separated dimensions of the form key=value[,value..], where keys and values are:
+//     screen=<width>x<height>@<Hz>
+//     group=<width>x<height>
+//     rng=var|invar
+//     frames=<frame_count>|<seconds>s
+static bool
+validate_sweep(
+	const char *const string,
+	sweep_param &sweep) {
+
+	if (0 == string)
+		return false;
+
+	const char* s = string;
+	char key[16];
+	int len;
+
+	while (1 == sscanf(s, " %15[a-z]=%n", key, &len)) {
+		uint32_t n = 0;
+
+		do {
+			s += len;
+
+			if (!std::strcmp(key, "screen")) {
+				if (n == max_sweep_values)
+					return false;
+
+				uint32_t (& screen)[3] = sweep.screen[n];
+
+				if (3 != sscanf(s, "%ux%u@%u%n", &screen[0], &screen[1], &screen[2], &len) || !screen[0] || !screen[1] || !screen[2])
+					return false;
+
+				sweep.screen_count = ++n;
+			}
+			else
+			if (!std::strcmp(key, "group")) {
+				if (n == max_sweep_values)
+					return false;
+
+				uint32_t (& group)[2] = sweep.group[n];
+
+				if (2 != sscanf(s, "%ux%u%n", &group[0], &group[1], &len) || !group[0] || !group[1])
+					return false;
+
+				sweep.group_count = ++n;
+			}
+			else
+			if (!std::strcmp(key, "rng")) {
+				char rng[8];
+
+				if (n == 2 || 1 != sscanf(s, "%7[a-z]%n", rng, &len))
+					return false;
+
+				if (!std::strcmp(rng, "var"))
+					sweep.frame_msk[n] = -1U;
+				else
+				if (!std::strcmp(rng, "invar"))
+					sweep.frame_msk[n] = 0;
+				else
+					return false;
+
+				sweep.rng_count = ++n;
+			}
+			else
+			if (!std::strcmp(key, "frames")) {
+				float value;
+
+				if (n == max_sweep_values || 1 != sscanf(s, "%f%n", &value, &len) || !(value > 0.f))
+					return false;
+
+				sweep.frames[n] = 0;
+				sweep.seconds[n] = 0.f;
+
+				if ('s' == s[len]) {
+					sweep.seconds[n] = value;
+					++len;
+				}
+				else
+				if (!(sweep.frames[n] = uint32_t(value)))
+					return false;
+
+				sweep.frames_count = ++n;
+			}
+			else
+				return false;
+
+			s += len;
+			len = 1;
+		}
+		while (',' == *s);
+	}
+
+	// no trailing garbage
+	while (' ' == *s || '\t' == *s)
+		++s;
+
+	return '\0' == *s && 0 != sweep.screen_count + sweep.group_count + sweep.rng_count + sweep.frames_count;
+}
+
+// build bench: frame count, followed by up to max_bench_threads thread counts
+static bool
+validate_bench(
+	const char *const string,
+	uint32_t &frames,
+	uint32_t (& thread)[max_bench_threads],
+	uint32_t &count) {
+
+	if (0 == string)
+		return false;
+
+	int len;
+
+	if (1 != sscanf(string, "%u%n", &frames, &len) || 0 == frames)
+		return false;
+
+	uint32_t n = 0;
+
+	for (const char* s = string + len; n < max_bench_threads && 1 == sscanf(s, "%u%n", &thread[n], &len); s += len, ++n)
+		if (0 == thread[n])
+			return false;
+
+	if (0 == n)
+		return false;
+
+	count = n;
+
+	return true;
+}
+
+// stress scene: kind, voxel count and motion fraction
+static bool
+validate_stress(
+	const char *const string,
+	uint32_t &kind,
+	uint32_t &voxels,
+	float &motion) {
+
+	if (0 == string)
+		return false;
+
+	char name[16];
+	int len;
+
+	if (3 != sscanf(string, "%15s %u %f%n", name, &voxels, &motion, &len) || '\0' != string[len])
+		return false;
+
+	if (0 == voxels || voxels > max_stress_voxels || !(motion >= 0.f && motion <= 1.f))
+		return false;
+
+	if (!std::strcmp(name, stress_uniform)) {
+		kind = STRESS_UNIFORM;
+		return true;
+	}
+
+	if (!std::strcmp(name, stress_clustered)) {
+		kind = STRESS_CLUSTERED;
+		return true;
+	}
+
+	if (!std::strcmp(name, stress_heightfield)) {
+		kind = STRESS_HEIGHTFIELD;
+		return true;
+	}
+
+	if (!std::strcmp(name, stress_shell)) {
+		kind = STRESS_SHELL;
+		return true;
+	}
+
+	return false;
+}
+
 static bool
 validate_fullscreen(
 	const char *const string,
@@ -118,6 +457,13 @@ int parseCLI(
 			continue;
 		}
 
+		if (!std::strcmp(argv[i] + prefix_len, arg_seek)) {
+			if (++i == argc || 1 != sscanf(argv[i], "%f", &param.seek) || !(param.seek >= 0.f))
+				success = false;
+
+			continue;
+		}
+
 		if (!std::strcmp(argv[i] + prefix_len, arg_frame_invar_rng)) {
 			param.frame_msk = 0;
 			continue;
@@ -135,6 +481,192 @@ int parseCLI(
 			continue;
 		}
 
+		if (!std::strcmp(argv[i] + prefix_len, arg_wavefront)) {
+			param.flags |= FLAG_WAVEFRONT;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_heightfield)) {
+			param.flags |= FLAG_HEIGHTFIELD;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_octant_order)) {
+			param.flags |= FLAG_OCTANT_ORDER;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_mailbox)) {
+			param.flags |= FLAG_MAILBOX;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_tile_cull)) {
+			param.flags |= FLAG_TILE_CULL;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_perf)) {
+			param.flags |= FLAG_PERF;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_sampler)) {
+			if (++i == argc || !validate_sampler(argv[i], param.sampler))
+				success = false;
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_cpu_isa)) {
+			if (++i == argc || !validate_cpu_isa(argv[i], param.cpu_isa))
+				success = false;
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_converge)) {
+			float window_ms;
+
+			if (++i == argc || 2 != sscanf(argv[i], "%u %f", &param.ref_frames, &window_ms) || param.ref_frames == 0 || !(window_ms > 0.f))
+				success = false;
+
+			param.mode = MODE_CONVERGE;
+			param.window = window_ms * 1e-3f;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_spps)) {
+			float window_ms;
+
+			if (++i == argc || 3 != sscanf(argv[i], "%u %f %f", &param.ref_frames, &window_ms, &param.span) ||
+				param.ref_frames == 0 || !(window_ms > 0.f) || !(param.span > 0.f))
+				success = false;
+
+			param.mode = MODE_SPPS;
+			param.window = window_ms * 1e-3f;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_sweep)) {
+			if (++i == argc || !validate_sweep(argv[i], param.sweep))
+				success = false;
+
+			param.mode = MODE_SWEEP;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_sweep_out)) {
+			if (++i == argc)
+				success = false;
+			else
+				param.sweep_out = argv[i];
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_trace)) {
+			if (++i == argc)
+				success = false;
+			else
+				param.trace_out = argv[i];
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_build_threads)) {
+			if (++i == argc || 1 != sscanf(argv[i], "%u", &param.build_threads))
+				success = false;
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_build_bench)) {
+			if (++i == argc || !validate_bench(argv[i], param.bench_frames, param.bench_threads, param.bench_thread_count))
+				success = false;
+
+			param.mode = MODE_BUILD_BENCH;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_microbench)) {
+			if (++i == argc || 1 != sscanf(argv[i], "%u", &param.microbench_reps) || param.microbench_reps == 0)
+				success = false;
+
+			param.mode = MODE_MICROBENCH;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_tile_size)) {
+			if (++i == argc || 2 != sscanf(argv[i], "%u %u", &param.tile_w, &param.tile_h) || param.tile_w == 0 || param.tile_h == 0)
+				success = false;
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_autotune)) {
+			if (++i == argc || 1 != sscanf(argv[i], "%f", &param.tune_span) || !(param.tune_span > 0.f))
+				success = false;
+
+			param.mode = MODE_AUTOTUNE;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_tune_cache)) {
+			if (++i == argc)
+				success = false;
+			else
+				param.tune_cache = argv[i];
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_dyn_res)) {
+			if (++i == argc || 2 != sscanf(argv[i], "%f %f", &param.res_min, &param.res_max) ||
+				!(param.res_min > 0.f) || !(param.res_min <= param.res_max) || !(param.res_max <= 1.f))
+				success = false;
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_ao_cache)) {
+			if (++i == argc || 1 != sscanf(argv[i], "%f", &param.ao_refresh) ||
+				!(param.ao_refresh > 0.f) || !(param.ao_refresh <= 1.f))
+				success = false;
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_contexts)) {
+			if (++i == argc || 2 != sscanf(argv[i], "%u %u", &param.context_count, &param.context_frames) ||
+				0 == param.context_count || param.context_count > max_contexts || 0 == param.context_frames)
+				success = false;
+
+			param.mode = MODE_CONTEXTS;
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_stress)) {
+			if (++i == argc || !validate_stress(argv[i], param.stress_kind, param.stress_voxels, param.stress_motion))
+				success = false;
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_instants)) {
+			if (++i == argc || !validate_instants(argv[i], param.instant, param.instant_count))
+				success = false;
+
+			continue;
+		}
+
+		if (!std::strcmp(argv[i] + prefix_len, arg_combos)) {
+			if (++i == argc || !validate_combos(argv[i], param.combo, param.combo_count))
+				success = false;
+
+			continue;
+		}
+
 		success = false;
 	}
 
@@ -143,9 +675,67 @@ int parseCLI(
 			"options (multiple args to an option must constitute a single string, eg. -foo \"a b c\"):\n"
 			"\t" << arg_prefix << arg_screen << " <width> <height> <Hz>\t: set framebuffer of specified geometry and refresh\n"
 			"\t" << arg_prefix << arg_frames << " <unsigned_integer>\t: set number of frames to run; default is max unsigned int\n"
+			"\t" << arg_prefix << arg_seek << " <seconds>\t\t: start the timeline at the specified time; default is 0\n"
 			"\t" << arg_prefix << arg_frame_invar_rng << "\t\t: use frame-invariant RNG for sampling\n"
-			"\t" << arg_prefix << arg_workgroup_size << " <width> <height>\t: set workgroup geometry; default is (execution_width, max_threads_per_group / execution_width)\n"
-			"\t" << arg_prefix << arg_borderful << "\t\t\t: set style of output window to titled; default is borderless\n";
+			"\t" << arg_prefix << arg_workgroup_size << " <width> <height>\t: set workgroup geometry, one not dividing the screen geometry taking partial groups at the edges where the GPU supports them; "
+				"default is that of the tuning cache for the GPU and screen, else (execution_width, max_threads_per_group / execution_width)\n"
+			"\t" << arg_prefix << arg_borderful << "\t\t\t: set style of output window to titled; default is borderless\n"
+			"\t" << arg_prefix << arg_wavefront << "\t\t\t: split rendering into primary and AO passes, AO pass over hit pixels only\n"
+			"\t" << arg_prefix << arg_octant_order << "\t\t: order closest-hit children by ray octant; default is by distance sort\n"
+			"\t" << arg_prefix << arg_mailbox << "\t\t\t: in CPU rendering, skip voxel tests a ray repeats across the cells a voxel straddles\n"
+			"\t" << arg_prefix << arg_tile_cull << "\t\t\t: in CPU rendering, trace primary rays of a tile among the tree nodes its frustum meets\n"
+			"\t" << arg_prefix << arg_heightfield << "\t\t: trace heightfield-shaped scenes as max-mip heightfields instead of octrees\n"
+			"\t" << arg_prefix << arg_sampler << " <sampler>\t\t: set AO sampler, one of " <<
+				sampler_white << ", " << sampler_blue_r2 << ", " << sampler_blue_sobol << "; default is " << sampler_white << "\n"
+			"\t" << arg_prefix << arg_cpu_isa << " <isa>\t\t: set ISA of CPU rendering, one of " <<
+				cpu_isa_auto << ", " << cpu_isa_generic << ", " << cpu_isa_avx2 << ", " << cpu_isa_avx512 << ", " << cpu_isa_neon << "; "
+				"one the CPU does not support falls back to " << cpu_isa_auto << "; default is " << cpu_isa_auto << ", for the best the CPU supports short of " << cpu_isa_avx512 << "\n"
+			"\t" << arg_prefix << arg_converge << " <ref_frames> <window_ms>\t: instead of running the timeline, render on the CPU frames of the frozen scene "
+				"and report the RMS error of their box- and exponential-window (time constant window_ms) averages vs a reference of ref_frames white-noise frames\n"
+			"\t" << arg_prefix << arg_spps << " <ref_frames> <window_ms> <seconds>\t: instead of running the timeline, for each instant and combo "
+				"render on the CPU a reference of ref_frames white-noise frames, and the 1-spp frames of the given seconds at the combo Hz; "
+				"report RMSE and SSIM of their box- and exponential-window averages vs the reference, against the sampling cost\n"
+			"\t" << arg_prefix << arg_perf << "\t\t\t: with " << arg_prefix << arg_converge << " and " << arg_prefix << arg_spps << ", also report hardware counters "
+				"(Linux perf_event_open) of the scene build and the CPU rendering: cycles, instructions, IPC, and L1D, LLC and branch misses per million rays\n"
+			"\t" << arg_prefix << arg_instants << " <seconds> ..\t\t: set timeline instants of " << arg_prefix << arg_spps << " and " << arg_prefix << arg_microbench << ", up to " << unsigned(max_instants) << "; default is the seek time\n"
+			"\t" << arg_prefix << arg_combos << " <width>x<height>@<Hz> ..\t: set resolution x Hz combos of " << arg_prefix << arg_spps << ", up to " << unsigned(max_combos) << "; default is the screen\n"
+			"\t" << arg_prefix << arg_sweep << " <key>=<value>[,<value>..] ..\t: run once per combination of values, from the timeline start each, and report frame times, "
+				"build times and dropped frames per run; keys and values are: screen=<width>x<height>@<Hz>, group=<width>x<height>, rng=var|invar, frames=<count>|<seconds>s; "
+				"a key not given takes its value from the rest of the options\n"
+			"\t" << arg_prefix << arg_sweep_out << " <path_prefix>\t: set path prefix of the " << arg_prefix << arg_sweep << " reports <path_prefix>.csv and <path_prefix>.json; default is sweep\n"
+			"\t" << arg_prefix << arg_trace << " <path>\t: record a pacing trace of the frame loop -- scripting, build, dispatch, GPU execution and completion, "
+				"frames in flight, dropped frames -- and write it at exit to <path> in Chrome trace format\n"
+			"\t" << arg_prefix << arg_build_threads << " <unsigned_integer>\t: build scene trees with the in-house builder on the given count of threads, "
+				"output being the same for any count; default is 0, for the builder of the testbed\n"
+			"\t" << arg_prefix << arg_build_bench << " <frames> <threads> ..\t: instead of running the timeline, build on the CPU the trees of all scenes "
+				"over the given count of timeline frames, once per given thread count, up to " << unsigned(max_bench_threads) << " counts; "
+				"report build times per scene and thread count, and whether the trees are identical to the single-thread trees\n"
+			"\t" << arg_prefix << arg_stress << " <kind> <voxels> <motion>\t: show throughout the timeline a procedural scene of the given count of voxels, up to " <<
+				unsigned(max_stress_voxels) << " -- the most whose tree payload, duplicates across cells included, the 16-bit payload indices address for every kind -- "
+				"of which the given fraction moves per frame; kind is one of " <<
+				stress_uniform << ", " << stress_clustered << ", " << stress_heightfield << ", " << stress_shell << "; "
+				"the scene is built with the in-house builder, on all hardware threads unless given " << arg_prefix << arg_build_threads << "\n"
+			"\t" << arg_prefix << arg_microbench << " <runs>\t\t: instead of running the timeline, for each instant time on the CPU each variant of each "
+				"traversal primitive over the rays of the screen frame, the given count of runs; report ns per op of the fastest run, and agreement with the baseline variant\n"
+			"\t" << arg_prefix << arg_tile_size << " <width> <height>\t: set tile geometry of CPU rendering, rows of a tile being those handed to a thread at a time; "
+				"default is that of the tuning cache for the machine and screen, else (8, 16)\n"
+			"\t" << arg_prefix << arg_autotune << " <seconds>\t\t: instead of running the timeline, time candidate CPU tile shapes, then candidate GPU workgroup shapes, "
+				"over the given seconds of timeline from the seek time at the screen geometry and Hz; store the fastest of each in the tuning cache\n"
+			"\t" << arg_prefix << arg_tune_cache << " <path>\t: set path of the tuning cache, of the shapes per machine and screen geometry found by " <<
+				arg_prefix << arg_autotune << ", and taken by later runs not given theirs; default is autotune.txt\n"
+			"\t" << arg_prefix << arg_dyn_res << " <min_scale> <max_scale>\t: render at a scale of the screen geometry between the given ones, in steps of 1/16, "
+				"upsampled to the screen; the scale drops as soon as the GPU time of a frame would exceed 80% of the frame period, and rises a step "
+				"after a second of frames to spare; default is 1 1\n"
+			"\t" << arg_prefix << arg_ao_cache << " <refresh>\t\t: in CPU rendering, cache AO per voxel face across frames, and trace per frame "
+				"only the given share, in (0, 1], of the AO rays of hits on faces of a warm cache; default is no cache\n"
+			"\t" << arg_prefix << arg_contexts << " <count> <frames>\t: instead of running the timeline, render on the CPU the given count of content contexts, "
+				"up to " << unsigned(max_contexts) << ", each the given frames of a slice of its own of the timeline from the seek time, first a context at a time, "
+				"then all at once, a thread each; report times per frame of both runs, and whether each context renders the same frames in either\n"
+#if USE_DST_BUFFER == 0
+			"note: this build writes frames straight to the drawable, and presents them without the scripted contrast and "
+				"blur of the view, which take destination buffers\n"
+#endif
+			;
 
 		return 1;
 	}
@@ -213,23 +803,560 @@ wrap_at_period(
 	const float x,
 	const float period) {
 
-	const simd::f32x4 vx = simd::f32x4(x, simd::flag_zero());
-	const simd::f32x4 vperiod = simd::f32x4(period, simd::flag_zero());
-	const simd::u32x4 mask = vx >= vperiod;
-	return x - simd::mask(vperiod, mask)[0];
-}
+	const simd::f32x4 vx = simd::f32x4(x, simd::flag_zero());
+	const simd::f32x4 vperiod = simd::f32x4(period, simd::flag_zero());
+	const simd::u32x4 mask = vx >= vperiod;
+	return x - simd::mask(vperiod, mask)[0];
+}
+
+
+static inline int32_t
+reset_at_period(
+	const int32_t x,
+	const int32_t period) {
+
+	const simd::s32x4 vx = simd::s32x4(x, simd::flag_zero());
+	const simd::s32x4 vperiod = simd::s32x4(period, simd::flag_zero());
+	const simd::u32x4 mask = vx < vperiod;
+	return simd::mask(vx, mask)[0];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// sampler support
+////////////////////////////////////////////////////////////////////////////////
+
+// blue-noise map:
+// struct Noise {
+//     ushort2 value[64][64]; // two independent blue-noise channels over a toroidal tile, row-major
+// }
+// values are the void-and-cluster ranks of the tile cells, scaled to the range of ushort and centered in their bins;
+// kernels tile the map over the frame, and rotate it toroidally (Cranley-Patterson) per frame by a point of a 2D
+// low-discrepancy sequence, so that each frame is blue noise in space, and each pixel is low-discrepancy in time
+
+enum {
+	noise_dim = 64,
+	noise_count = noise_dim * noise_dim
+};
+
+// see George Marsaglia http://www.jstatsoft.org/v08/i14/paper
+static inline uint32_t
+xorshift(
+	uint32_t value) {
+
+	value ^= value << 13;
+	value ^= value >> 17;
+	value ^= value << 5;
+	return value;
+}
+
+
+static inline double
+fract(
+	const double x) {
+
+	return x - std::floor(x);
+}
+
+// rank the cells of the tile by void-and-cluster, see Robert Ulichney, "The void-and-cluster method for dither
+// array generation", 1993; store the scaled ranks at the given stride
+static void
+void_and_cluster(
+	const uint32_t seed,
+	uint16_t* const value,
+	const size_t stride) {
+
+	const size_t dim = noise_dim;
+	const size_t count = noise_count;
+	const float sigma = 1.5f;
+	const uint32_t bin = 65536 / count;
+
+	// gaussian energy filter, toroidal
+	static float filter[count];
+
+	for (size_t y = 0; y < dim; ++y)
+		for (size_t x = 0; x < dim; ++x) {
+			const float dx = std::min(x, dim - x);
+			const float dy = std::min(y, dim - y);
+			filter[y * dim + x] = std::exp((dx * dx + dy * dy) * (-.5f / (sigma * sigma)));
+		}
+
+	static bool pattern[count];
+	static float energy[count];
+
+	// add (sign = 1) or remove (sign = -1) a point of the pattern
+	const auto splat = [&](const size_t i, const float sign) {
+		const size_t ix = i % dim;
+		const size_t iy = i / dim;
+
+		for (size_t y = 0; y < dim; ++y)
+			for (size_t x = 0; x < dim; ++x)
+				energy[y * dim + x] += sign * filter[(y + dim - iy) % dim * dim + (x + dim - ix) % dim];
+	};
+
+	// tightest cluster among the points, or largest void among the non-points
+	const auto extremum = [&](const bool point) {
+		size_t best = count;
+
+		for (size_t i = 0; i < count; ++i)
+			if (pattern[i] == point && (count == best || (point ? energy[i] > energy[best] : energy[i] < energy[best])))
+				best = i;
+
+		return best;
+	};
+
+	// initial pattern: random points, relaxed by moving the tightest cluster to the largest void until stable
+	std::fill(pattern, pattern + count, false);
+	std::fill(energy, energy + count, 0.f);
+
+	const size_t initial = count / 10;
+	uint32_t rng = seed;
+
+	for (size_t n = 0; n < initial; rng = xorshift(rng)) {
+		const size_t i = rng % count;
+
+		if (pattern[i])
+			continue;
+
+		pattern[i] = true;
+		splat(i, 1.f);
+		++n;
+	}
+
+	for (size_t n = 0; n < count; ++n) {
+		const size_t cluster = extremum(true);
+		pattern[cluster] = false;
+		splat(cluster, -1.f);
+
+		const size_t vacancy = extremum(false);
+		pattern[vacancy] = true;
+		splat(vacancy, 1.f);
+
+		if (vacancy == cluster)
+			break;
+	}
+
+	static bool initial_pattern[count];
+	static float initial_energy[count];
+
+	std::copy(pattern, pattern + count, initial_pattern);
+	std::copy(energy, energy + count, initial_energy);
+
+	// rank the initial points, tightest clusters last
+	for (size_t r = initial; r-- > 0;) {
+		const size_t i = extremum(true);
+		pattern[i] = false;
+		splat(i, -1.f);
+		value[i * stride] = uint16_t(r * bin + bin / 2);
+	}
+
+	std::copy(initial_pattern, initial_pattern + count, pattern);
+	std::copy(initial_energy, initial_energy + count, energy);
+
+	// rank the remaining cells, largest voids first; past half the tile the largest void among the non-points is
+	// the tightest cluster among the non-points, so this serves both halves of the ranking
+	for (size_t r = initial; r < count; ++r) {
+		const size_t i = extremum(false);
+		pattern[i] = true;
+		splat(i, 1.f);
+		value[i * stride] = uint16_t(r * bin + bin / 2);
+	}
+}
+
+// blue-noise tile of the samplers, the same for all contexts; generated on first use, once per process, as
+// void_and_cluster is not re-entrant
+static const uint16_t (& blue_noise())[noise_count][2] {
+	static const struct Tile {
+		uint16_t value[noise_count][2];
+
+		Tile() {
+			void_and_cluster(0x2545f491, &value[0][0], 2);
+			void_and_cluster(0x9e3779b9, &value[0][1], 2);
+		}
+	} tile;
+
+	return tile.value;
+}
+
+// per-frame toroidal rotation of the blue-noise tile: point n of the sequence of the given sampler
+static void
+noise_rotation(
+	const uint32_t sampler,
+	const uint32_t n,
+	float (& rot)[2]) {
+
+	switch (sampler) {
+	case SAMPLER_BLUE_R2: {
+			// see Martin Roberts, "The unreasonable effectiveness of quasirandom sequences", 2018
+			const double g = 1.32471795724474602596; // plastic number
+			rot[0] = fract(.5 + n / g);
+			rot[1] = fract(.5 + n / (g * g));
+		}
+		return;
+
+	case SAMPLER_BLUE_SOBOL: {
+			// first two dimensions of Sobol: van der Corput in base 2, and direction numbers v_k = v_k-1 ^ v_k-1 >> 1
+			uint32_t r0 = n;
+			r0 = r0 << 16 | r0 >> 16;
+			r0 = (r0 & 0x00ff00ff) << 8 | (r0 >> 8 & 0x00ff00ff);
+			r0 = (r0 & 0x0f0f0f0f) << 4 | (r0 >> 4 & 0x0f0f0f0f);
+			r0 = (r0 & 0x33333333) << 2 | (r0 >> 2 & 0x33333333);
+			r0 = (r0 & 0x55555555) << 1 | (r0 >> 1 & 0x55555555);
+
+			uint32_t r1 = 0;
+
+			for (uint32_t i = n, v = 1U << 31; i; i >>= 1, v ^= v >> 1)
+				if (i & 1)
+					r1 ^= v;
+
+			rot[0] = r0 * (1.0 / 4294967296.0);
+			rot[1] = r1 * (1.0 / 4294967296.0);
+		}
+		return;
+
+	default:
+		rot[0] = 0.f;
+		rot[1] = 0.f;
+		return;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// screen culling support
+////////////////////////////////////////////////////////////////////////////////
+
+// screen rect of a set of boxes, as seen by the primary rays of the kernels: the ray of screen coords (u, v) in
+// [-1, 1]^2 runs from the camera origin along u * cam0 + v * cam1 + cam2, so a point projects at the (u, v) of its
+// coords in that basis, over the cam2 coord; the rect bounds the projected corners of each box, and thus the box,
+// as long as the box lies wholly in front of the camera, and takes the full screen otherwise
+
+class ScreenRect {
+	double inv[3][3]; // inverse of the basis of cam0, cam1 and cam2
+	double origin[3];
+	bool full;
+	float rect[4];    // u_min, v_min, u_max, v_max; empty while min > max
+
+public:
+	ScreenRect(
+		const vect3& cam0,
+		const vect3& cam1,
+		const vect3& cam2,
+		const vect3& origin);
+
+	// grow by a box
+	void add(
+		const simd::f32x4& min,
+		const simd::f32x4& max);
+
+	// get u_min, v_min, u_max, v_max, clamped to the screen
+	void get(
+		float (& rect)[4]) const;
+};
+
+
+ScreenRect::ScreenRect(
+	const vect3& cam0,
+	const vect3& cam1,
+	const vect3& cam2,
+	const vect3& origin)
+: full(false) {
+
+	const double m[3][3] = {
+		{ cam0[0], cam1[0], cam2[0] },
+		{ cam0[1], cam1[1], cam2[1] },
+		{ cam0[2], cam1[2], cam2[2] }
+	};
+
+	for (size_t i = 0; i < 3; ++i) {
+		this->origin[i] = origin[i];
+
+		for (size_t j = 0; j < 3; ++j)
+			inv[i][j] = m[(j + 1) % 3][(i + 1) % 3] * m[(j + 2) % 3][(i + 2) % 3] - m[(j + 1) % 3][(i + 2) % 3] * m[(j + 2) % 3][(i + 1) % 3];
+	}
+
+	const double det = m[0][0] * inv[0][0] + m[0][1] * inv[1][0] + m[0][2] * inv[2][0];
+
+	// a degenerate camera sees all or nothing; take it as all
+	if (std::fabs(det) < 1e-12)
+		full = true;
+	else
+		for (size_t i = 0; i < 3; ++i)
+			for (size_t j = 0; j < 3; ++j)
+				inv[i][j] /= det;
+
+	rect[0] = rect[1] = 1.f;
+	rect[2] = rect[3] = -1.f;
+}
+
+
+void ScreenRect::add(
+	const simd::f32x4& min,
+	const simd::f32x4& max) {
+
+	if (full)
+		return;
+
+	for (uint32_t i = 0; i < 8; ++i) {
+		const double d[3] = {
+			(i & 1 ? max[0] : min[0]) - origin[0],
+			(i & 2 ? max[1] : min[1]) - origin[1],
+			(i & 4 ? max[2] : min[2]) - origin[2]
+		};
+		double coord[3];
+
+		for (size_t j = 0; j < 3; ++j)
+			coord[j] = inv[j][0] * d[0] + inv[j][1] * d[1] + inv[j][2] * d[2];
+
+		// corner at or behind the plane of the camera
+		if (coord[2] <= 1e-6) {
+			full = true;
+			return;
+		}
+
+		const float u = coord[0] / coord[2];
+		const float v = coord[1] / coord[2];
+
+		rect[0] = std::min(rect[0], u);
+		rect[1] = std::min(rect[1], v);
+		rect[2] = std::max(rect[2], u);
+		rect[3] = std::max(rect[3], v);
+	}
+}
+
+
+void ScreenRect::get(
+	float (& rect)[4]) const {
+
+	if (full) {
+		rect[0] = rect[1] = -1.f;
+		rect[2] = rect[3] = 1.f;
+		return;
+	}
+
+	rect[0] = std::max(this->rect[0], -1.f);
+	rect[1] = std::max(this->rect[1], -1.f);
+	rect[2] = std::min(this->rect[2], 1.f);
+	rect[3] = std::min(this->rect[3], 1.f);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// heightfield support
+////////////////////////////////////////////////////////////////////////////////
+
+// heightfield map:
+// struct Heightfield {
+//     float origin[2];  // world xy of the grid corner
+//     float cell;       // cell size
+//     uint32 levels;    // count of max-mip levels, level 0 being the grid itself; 0 when no heightfield
+//     uint32 dim[2];    // grid cols and rows
+//     float top;        // max height over the grid
+//     uint32 unused;
+//     uint32 offset[8]; // start of each level in height[]
+//     float height[];   // all levels in sequence, each row-major
+// }
+// columns of the grid span [0, height] along z
+
+class Heightfield {
+	uint32_t* const map;
+	const size_t capacity; // elements of height[]
+
+	enum {
+		header_size = 16,
+		max_levels = 8
+	};
+
+	float* level(const size_t l) const {
+		return reinterpret_cast< float* >(map + header_size) + map[8 + l];
+	}
+
+public:
+	Heightfield(
+		void* const buffer,
+		const size_t size)
+	: map(reinterpret_cast< uint32_t* >(buffer))
+	, capacity(size / sizeof(uint32_t) - header_size) {
+	}
+
+	// mark map as holding no heightfield
+	void clear() {
+		map[3] = 0;
+	}
+
+	bool set_grid(
+		const float origin_x,
+		const float origin_y,
+		const float cell,
+		const uint32_t cols,
+		const uint32_t rows);
+
+	float& height(
+		const size_t x,
+		const size_t y) {
+
+		return level(0)[y * map[4] + x];
+	}
+
+	// compute max-mip levels from the grid heights
+	void build_mips();
+
+	BBox get_bbox() const;
+};
+
+
+bool Heightfield::set_grid(
+	const float origin_x,
+	const float origin_y,
+	const float cell,
+	const uint32_t cols,
+	const uint32_t rows) {
+
+	uint32_t levels = 1;
+	uint32_t size = cols * rows;
+
+	for (uint32_t w = cols, h = rows; w > 1 || h > 1; ++levels) {
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+		size += w * h;
+	}
+
+	if (levels > max_levels || size > capacity)
+		return false;
+
+	map[0] = reinterpret_cast< const uint32_t& >(origin_x);
+	map[1] = reinterpret_cast< const uint32_t& >(origin_y);
+	map[2] = reinterpret_cast< const uint32_t& >(cell);
+	map[3] = levels;
+	map[4] = cols;
+	map[5] = rows;
+
+	map[8] = 0;
+
+	for (uint32_t l = 1, w = cols, h = rows; l < levels; ++l) {
+		map[8 + l] = map[8 + l - 1] + w * h;
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+	}
+
+	return true;
+}
+
+
+void Heightfield::build_mips() {
+	const uint32_t levels = map[3];
+
+	for (uint32_t l = 1, w = map[4], h = map[5]; l < levels; ++l) {
+		const float* const src = level(l - 1);
+		float* const dst = level(l);
+		const uint32_t dst_w = (w + 1) / 2;
+		const uint32_t dst_h = (h + 1) / 2;
+
+		for (uint32_t y = 0; y < dst_h; ++y)
+			for (uint32_t x = 0; x < dst_w; ++x) {
+				const uint32_t x0 = x * 2;
+				const uint32_t y0 = y * 2;
+				const uint32_t x1 = std::min(x0 + 1, w - 1);
+				const uint32_t y1 = std::min(y0 + 1, h - 1);
+
+				dst[y * dst_w + x] = std::max(
+					std::max(src[y0 * w + x0], src[y0 * w + x1]),
+					std::max(src[y1 * w + x0], src[y1 * w + x1]));
+			}
+
+		w = dst_w;
+		h = dst_h;
+	}
+
+	const float top = level(levels - 1)[0];
+	map[6] = reinterpret_cast< const uint32_t& >(top);
+}
+
+
+BBox Heightfield::get_bbox() const {
+	const float origin_x = reinterpret_cast< const float& >(map[0]);
+	const float origin_y = reinterpret_cast< const float& >(map[1]);
+	const float cell     = reinterpret_cast< const float& >(map[2]);
+	const float top      = reinterpret_cast< const float& >(map[6]);
+
+	return BBox(
+		vect3(origin_x,                 origin_y,                 0.f),
+		vect3(origin_x + cell * map[4], origin_y + cell * map[5], top),
+		BBox::flag_direct());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// tree support
+////////////////////////////////////////////////////////////////////////////////
+
+// timeline slice of a scene, building its tree with the in-house builder or with that of Timeslice
+class SceneTree : public Timeslice {
+	OctreeBuilder* builder; // in-house builder, shared by the scenes of a context, or nil for that of Timeslice
+	OctreeBuilder::Storage storage;
+	BBox root_bbox;
+	size_t payload_count;
+
+public:
+	SceneTree()
+	: builder(nullptr)
+	, root_bbox(BBox::flag_noinit())
+	, payload_count(0) {
+		std::memset(&storage, 0, sizeof(storage));
+	}
+
+	// set the in-house builder to build with, or nil for the builder of Timeslice
+	void set_builder(
+		OctreeBuilder* const builder) {
+
+		this->builder = builder;
+	}
+
+	// hides that of Timeslice
+	void set_extrnal_storage(
+		const size_t octet_count,
+		void* const octet_map,
+		const size_t leaf_count,
+		void* const leaf_map,
+		const size_t voxel_count,
+		void* const voxel_map) {
+
+		storage.octet = octet_map;
+		storage.octet_count = octet_count;
+		storage.leaf = leaf_map;
+		storage.leaf_count = leaf_count;
+		storage.voxel = voxel_map;
+		storage.voxel_count = voxel_count;
+
+		Timeslice::set_extrnal_storage(
+			octet_count, octet_map,
+			leaf_count, leaf_map,
+			voxel_count, voxel_map);
+	}
+
+	// hides that of Timeslice
+	bool set_payload_array(
+		const Array< Voxel >& payload,
+		const BBox& bbox) {
+
+		payload_count = payload.getCount();
+
+		if (nullptr == builder)
+			return Timeslice::set_payload_array(payload, bbox);
 
+		root_bbox = bbox;
+		return builder->build(payload, bbox, storage);
+	}
 
-static inline int32_t
-reset_at_period(
-	const int32_t x,
-	const int32_t period) {
+	// hides that of Timeslice
+	BBox get_root_bbox() const {
+		if (nullptr == builder)
+			return Timeslice::get_root_bbox();
 
-	const simd::s32x4 vx = simd::s32x4(x, simd::flag_zero());
-	const simd::s32x4 vperiod = simd::s32x4(period, simd::flag_zero());
-	const simd::u32x4 mask = vx < vperiod;
-	return simd::mask(vx, mask)[0];
-}
+		return root_bbox;
+	}
+
+	// get count of voxels of the last payload
+	size_t get_payload_count() const {
+		return payload_count;
+	}
+};
 
 ////////////////////////////////////////////////////////////////////////////////
 // scene support
@@ -265,8 +1392,21 @@ public:
 	, cam_z(0.f) {
 	}
 
-	virtual bool init(Timeslice& scene) = 0;
-	virtual bool frame(Timeslice& scene, const float dt) = 0;
+	virtual bool init(SceneTree& scene) = 0;
+	virtual bool frame(SceneTree& scene, const float dt) = 0;
+
+	// advance scene state by dt without building a tree; frame(dt) == skip(dt) + tree build
+	virtual void skip(const float dt) = 0;
+
+	// heightfield-shaped scenes, ie. grids of columns standing on z = 0, can produce a heightfield
+	// of their current state in place of a tree
+	virtual bool is_heightfield() const {
+		return false;
+	}
+
+	virtual bool heightfield(Heightfield&) {
+		return false;
+	}
 
 	// scene offset in model space
 	float get_offset_x() const {
@@ -326,12 +1466,12 @@ class Scene1 : public virtual Scene {
 
 	float accum_time;
 	float generation;
+	unsigned rng; // state of rand_r
 
 	Array< Voxel > content;
 	BBox contentBox;
 
-	bool update(
-		Timeslice& scene,
+	void update(
 		const float generation);
 
 	void camera(
@@ -342,23 +1482,43 @@ public:
 
 	// virtual from Scene
 	bool init(
-		Timeslice& scene);
+		SceneTree& scene);
 
 	// virtual from Scene
 	bool frame(
-		Timeslice& scene,
+		SceneTree& scene,
+		const float dt);
+
+	// virtual from Scene
+	void skip(
 		const float dt);
+
+	// virtual from Scene
+	bool is_heightfield() const {
+		return true;
+	}
+
+	// virtual from Scene
+	bool heightfield(
+		Heightfield& field);
 };
 
 
 bool Scene1::init(
-	Timeslice& scene) {
+	SceneTree& scene) {
 
 	accum_x = 0.f;
 	accum_y = 0.f;
 	accum_time = 0.f;
 	generation = grid_rows;
 
+	// content is of rand_r() on a state of the scene, for scenes of different contexts not to draw from each
+	// other; seeded as rand() is in a fresh process, whose content it reproduces where the two share a generator
+	rng = 1;
+
+	// drop any content of a prior init
+	content.resetCount();
+
 	if (!content.setCapacity(grid_rows * grid_cols))
 		return false;
 
@@ -370,7 +1530,7 @@ bool Scene1::init(
 		for (int x = 0; x < grid_cols; ++x) {
 			const BBox box(
 				vect3(x * unit,        y * unit,        0.f),
-				vect3(x * unit + unit, y * unit + unit, alt * (rand() % 4 + 1)),
+				vect3(x * unit + unit, y * unit + unit, alt * (rand_r(&rng) % 4 + 1)),
 				BBox::flag_direct());
 
 			contentBox.grow(box);
@@ -381,8 +1541,7 @@ bool Scene1::init(
 }
 
 
-inline bool Scene1::update(
-	Timeslice& scene,
+inline void Scene1::update(
 	const float generation) {
 
 	const float unit = dist_unit;
@@ -400,14 +1559,12 @@ inline bool Scene1::update(
 	for (int x = 0; x < grid_cols; ++x, ++index) {
 		const BBox box(
 			vect3(x * unit,        y * unit,        0.f),
-			vect3(x * unit + unit, y * unit + unit, alt * (rand() % 4 + 1)),
+			vect3(x * unit + unit, y * unit + unit, alt * (rand_r(&rng) % 4 + 1)),
 			BBox::flag_direct());
 
 		contentBox.grow(box);
 		content.getMutable(index) = Voxel(box.get_min(), box.get_max());
 	}
-
-	return scene.set_payload_array(content, contentBox);
 }
 
 
@@ -438,8 +1595,7 @@ inline void Scene1::camera(
 }
 
 
-bool Scene1::frame(
-	Timeslice& scene,
+void Scene1::skip(
 	const float dt) {
 
 	camera(dt);
@@ -450,11 +1606,41 @@ bool Scene1::frame(
 	accum_time += dt;
 
 	if (accum_time < update_period)
-		return scene.set_payload_array(content, contentBox);
+		return;
 
 	accum_time -= update_period;
 
-	return update(scene, generation++);
+	update(generation++);
+}
+
+
+bool Scene1::frame(
+	SceneTree& scene,
+	const float dt) {
+
+	skip(dt);
+
+	return scene.set_payload_array(content, contentBox);
+}
+
+
+bool Scene1::heightfield(
+	Heightfield& field) {
+
+	// rows scroll along y; the oldest row is the first
+	const simd::f32x4 origin = content.getElement(0).get_bbox().get_min();
+
+	if (!field.set_grid(origin[0], origin[1], dist_unit, grid_cols, grid_rows))
+		return false;
+
+	size_t index = 0;
+
+	for (int y = 0; y < grid_rows; ++y)
+		for (int x = 0; x < grid_cols; ++x, ++index)
+			field.height(x, y) = content.getElement(index).get_bbox().get_max()[2];
+
+	field.build_mips();
+	return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -478,31 +1664,53 @@ class Scene2 : virtual public Scene {
 	Array< Voxel > content;
 
 	bool update(
-		Timeslice& scene,
-		const float dt);
+		SceneTree& scene);
 
 	void camera(
 		const float dt);
 
+	float time_factor() const;
+
+	float height(
+		const int x,
+		const int y,
+		const float time_factor) const;
+
 public:
 	// virtual from Scene
 	bool init(
-		Timeslice& scene);
+		SceneTree& scene);
 
 	// virtual from Scene
 	bool frame(
-		Timeslice& scene,
+		SceneTree& scene,
 		const float dt);
+
+	// virtual from Scene
+	void skip(
+		const float dt);
+
+	// virtual from Scene
+	bool is_heightfield() const {
+		return true;
+	}
+
+	// virtual from Scene
+	bool heightfield(
+		Heightfield& field);
 };
 
 
 bool Scene2::init(
-	Timeslice& scene) {
+	SceneTree& scene) {
 
 	accum_x = 0.f;
 	accum_y = 0.f;
 	accum_time = 0.f;
 
+	// drop any content of a prior init
+	content.resetCount();
+
 	if (!content.setCapacity(grid_rows * grid_cols))
 		return false;
 
@@ -524,27 +1732,39 @@ bool Scene2::init(
 }
 
 
-inline bool Scene2::update(
-	Timeslice& scene,
-	const float dt) {
-
+inline float Scene2::time_factor() const {
 	const float period = 2.f; // seconds
 
-	accum_time = wrap_at_period(accum_time + dt, period);
+	return simd::sin(simd::f32x4(accum_time / period * float(M_PI * 2.0), simd::flag_zero()))[0];
+}
+
 
-	const float time_factor = simd::sin(simd::f32x4(accum_time / period * float(M_PI * 2.0), simd::flag_zero()))[0];
+inline float Scene2::height(
+	const int x,
+	const int y,
+	const float time_factor) const {
 
 	const float unit = dist_unit;
 	const float alt = unit * .5f;
+	const simd::f32x4 sin_xy = simd::sin(simd::f32x4(x * alt, y * alt, 0.f, 0.f));
+
+	return 1.f + time_factor * unit * (sin_xy[0] * sin_xy[1]);
+}
+
+
+inline bool Scene2::update(
+	SceneTree& scene) {
+
+	const float tf = time_factor();
+	const float unit = dist_unit;
 	size_t index = 0;
 	BBox contentBox;
 
 	for (int y = 0; y < grid_rows; ++y)
 		for (int x = 0; x < grid_cols; ++x, ++index) {
-			const simd::f32x4 sin_xy = simd::sin(simd::f32x4(x * alt, y * alt, 0.f, 0.f));
 			const BBox box(
 				vect3(x * unit,        y * unit,        0.f),
-				vect3(x * unit + unit, y * unit + unit, 1.f + time_factor * unit * (sin_xy[0] * sin_xy[1])),
+				vect3(x * unit + unit, y * unit + unit, height(x, y, tf)),
 				BBox::flag_direct());
 
 			contentBox.grow(box);
@@ -582,13 +1802,41 @@ inline void Scene2::camera(
 }
 
 
-bool Scene2::frame(
-	Timeslice& scene,
+void Scene2::skip(
 	const float dt) {
 
+	const float period = 2.f; // seconds
+
 	camera(dt);
 
-	return update(scene, dt);
+	accum_time = wrap_at_period(accum_time + dt, period);
+}
+
+
+bool Scene2::frame(
+	SceneTree& scene,
+	const float dt) {
+
+	skip(dt);
+
+	return update(scene);
+}
+
+
+bool Scene2::heightfield(
+	Heightfield& field) {
+
+	if (!field.set_grid(0.f, 0.f, dist_unit, grid_cols, grid_rows))
+		return false;
+
+	const float tf = time_factor();
+
+	for (int y = 0; y < grid_rows; ++y)
+		for (int x = 0; x < grid_cols; ++x)
+			field.height(x, y) = height(x, y, tf);
+
+	field.build_mips();
+	return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -611,23 +1859,26 @@ class Scene3 : virtual public Scene {
 	Array< Voxel > content;
 
 	bool update(
-		Timeslice& scene,
-		const float dt);
+		SceneTree& scene);
 
 public:
 	// virtual from Scene
 	bool init(
-		Timeslice& scene);
+		SceneTree& scene);
 
 	// virtual from Scene
 	bool frame(
-		Timeslice& scene,
+		SceneTree& scene,
+		const float dt);
+
+	// virtual from Scene
+	void skip(
 		const float dt);
 };
 
 
 bool Scene3::init(
-	Timeslice& scene) {
+	SceneTree& scene) {
 
 	offset_x = 10.f; // matching the center of scene_1
 	offset_y = 10.f; // matching the center of scene_1
@@ -636,6 +1887,9 @@ bool Scene3::init(
 	accum_y = 0.f;
 	accum_time = 0.f;
 
+	// drop any content of a prior init
+	content.resetCount();
+
 	if (!content.setCapacity(queue_length * 2 + 1))
 		return false;
 
@@ -678,66 +1932,293 @@ bool Scene3::init(
 	contentBox.grow(box);
 	content.addElement(Voxel(box.get_min(), box.get_max()));
 
-	return scene.set_payload_array(content, contentBox);
+	return scene.set_payload_array(content, contentBox);
+}
+
+
+inline bool Scene3::update(
+	SceneTree& scene) {
+
+	const float period = 32.f; // seconds
+	const float radius = main_radius;
+	size_t index = 0;
+	BBox contentBox;
+
+	for (int i = 0; i < queue_length; ++i, index += 2) {
+		const float angle = float(M_PI * 2.0) * (i / float(queue_length)) + accum_time * float(M_PI * 2.0) / period;
+		const simd::f32x4 sin_iz = simd::sin(simd::f32x4(
+			i / float(queue_length) * float(M_PI * 16.0),
+			i / float(queue_length) * float(M_PI * 16.0) + accum_time * float(M_PI * 32.0) / period, 0.f, 0.f));
+		const float sin_i = sin_iz[0];
+		const float sin_z = sin_iz[1];
+
+		{
+			const matx3_rotate rot(angle, 0.f, 0.f, 1.f);
+			const vect3 pos = vect3(radius + sin_i, 0.f, sin_z) * rot;
+			const BBox box(
+				pos - vect3(.5f),
+				pos + vect3(.5f),
+				BBox::flag_direct());
+
+			contentBox.grow(box);
+			content.getMutable(index + 0) = Voxel(box.get_min(), box.get_max());
+		}
+		{
+			const matx3_rotate rot(-angle, 0.f, 0.f, 1.f);
+			const vect3 pos = vect3(radius * .5f + sin_i, 0.f, sin_z) * rot;
+			const BBox box(
+				pos - vect3(.35f),
+				pos + vect3(.35f),
+				BBox::flag_direct());
+
+			contentBox.grow(box);
+			content.getMutable(index + 1) = Voxel(box.get_min(), box.get_max());
+		}
+	}
+
+	// account for the last element which is never updated
+	contentBox.grow(content.getElement(index).get_bbox());
+
+	return scene.set_payload_array(content, contentBox);
+}
+
+
+void Scene3::skip(
+	const float dt) {
+
+	const float period = 32.f; // seconds
+
+	accum_time = wrap_at_period(accum_time + dt, period);
+}
+
+
+bool Scene3::frame(
+	SceneTree& scene,
+	const float dt) {
+
+	skip(dt);
+
+	return update(scene);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// SceneStress: procedural content of a given kind and voxel count
+////////////////////////////////////////////////////////////////////////////////
+
+class SceneStress : virtual public Scene {
+	const cli_param& param; // of the stress scene: kind, count of voxels and motion
+
+	enum {
+		field_dim = 16, // xy extent of content, centered at the origin
+		field_alt = 4,  // z extent of volumetric content, centered at the origin
+	};
+
+	float accum_time;
+
+	// voxels at rest, and the ids of those of them bobbing along z, each of its own phase
+	Array< Voxel > rest;
+	Array< uint32_t > moving;
+	Array< Voxel > content;
+	BBox contentBox;
+	float amplitude;
+
+	bool update(
+		SceneTree& scene);
+
+public:
+	SceneStress(const cli_param& param) : param(param), contentBox(BBox::flag_noinit()) {}
+
+	// virtual from Scene
+	bool init(
+		SceneTree& scene);
+
+	// virtual from Scene
+	bool frame(
+		SceneTree& scene,
+		const float dt);
+
+	// virtual from Scene
+	void skip(
+		const float dt);
+};
+
+
+// uniform random float in [0, 1), and the next RNG state
+static inline float
+rand_unorm(
+	uint32_t& rng) {
+
+	rng = xorshift(rng);
+	return (rng >> 8) * (1.f / (1 << 24));
+}
+
+
+bool SceneStress::init(
+	SceneTree& scene) {
+
+	offset_x = 10.f; // matching the center of scene_1
+	offset_y = 10.f; // matching the center of scene_1
+
+	accum_time = 0.f;
+	azim = 0.f;
+
+	// drop any content of a prior init
+	rest.resetCount();
+	moving.resetCount();
+	content.resetCount();
+
+	const size_t count = param.stress_voxels;
+
+	if (!rest.setCapacity(count) || !moving.setCapacity(count) || !content.setCapacity(count))
+		return false;
+
+	// same content on every init
+	uint32_t rng = 0x2545f491;
+
+	const float half_dim = field_dim * .5f;
+	const float half_alt = field_alt * .5f;
+
+	// edge of the voxels of volumetric content, for them to fill about 1/8 of the volume
+	const float edge = std::cbrt(float(field_dim) * field_dim * field_alt / count) * .5f;
+
+	switch (param.stress_kind) {
+	case STRESS_UNIFORM:
+		for (size_t i = 0; i < count; ++i) {
+			const vect3 pos(
+				(rand_unorm(rng) * 2.f - 1.f) * half_dim,
+				(rand_unorm(rng) * 2.f - 1.f) * half_dim,
+				(rand_unorm(rng) * 2.f - 1.f) * half_alt);
+
+			const BBox box(pos - vect3(edge * .5f), pos + vect3(edge * .5f), BBox::flag_direct());
+			rest.addElement(Voxel(box.get_min(), box.get_max()));
+		}
+		break;
+
+	case STRESS_CLUSTERED: {
+		// clusters of 256 voxels on average, each of voxels scattered about its center by a sum of uniforms
+		const size_t cluster_count = std::max(count / 256, size_t(1));
+		const float radius = 1.5f;
+		const float cluster_edge = edge * .5f;
+
+		for (size_t i = 0; i < count; ++i) {
+			uint32_t cluster_rng = xorshift(uint32_t(i * cluster_count / count + 1) * 0x9e3779b9);
+			const vect3 centre(
+				(rand_unorm(cluster_rng) * 2.f - 1.f) * (half_dim - radius),
+				(rand_unorm(cluster_rng) * 2.f - 1.f) * (half_dim - radius),
+				(rand_unorm(cluster_rng) * 2.f - 1.f) * std::max(half_alt - radius, 0.f));
+
+			float scatter[3];
+
+			for (size_t j = 0; j < 3; ++j)
+				scatter[j] = (rand_unorm(rng) + rand_unorm(rng) + rand_unorm(rng) - 1.5f) * (radius / 1.5f);
+
+			const vect3 pos = centre + vect3(scatter[0], scatter[1], scatter[2]);
+			const BBox box(pos - vect3(cluster_edge * .5f), pos + vect3(cluster_edge * .5f), BBox::flag_direct());
+			rest.addElement(Voxel(box.get_min(), box.get_max()));
+		}
+		break;
+	}
+
+	case STRESS_HEIGHTFIELD: {
+		// columns standing on z = 0 over a square grid, row-major; the last row may be partial
+		const size_t grid_dim = size_t(std::ceil(std::sqrt(double(count))));
+		const float cell = float(field_dim) / grid_dim;
+
+		for (size_t i = 0; i < count; ++i) {
+			const float x = (i % grid_dim) * cell - half_dim;
+			const float y = (i / grid_dim) * cell - half_dim;
+			const float alt = (std::sin(x * .7f) * std::cos(y * .5f) + 1.25f) * half_alt + rand_unorm(rng) * cell;
+
+			const BBox box(vect3(x, y, 0.f), vect3(x + cell, y + cell, alt), BBox::flag_direct());
+			rest.addElement(Voxel(box.get_min(), box.get_max()));
+		}
+		break;
+	}
+
+	case STRESS_SHELL: {
+		// sphere of voxels at the points of a Fibonacci lattice, about touching their neighbours
+		const float radius = half_dim * .75f;
+		const float shell_edge = radius * std::sqrt(float(4.0 * M_PI) / count) * .75f;
+		const float golden_angle = float(M_PI * (3.0 - std::sqrt(5.0)));
+
+		for (size_t i = 0; i < count; ++i) {
+			const float z = 1.f - (i + .5f) * (2.f / count);
+			const float r = std::sqrt(1.f - z * z);
+			const float angle = golden_angle * i;
+
+			const vect3 pos = vect3(std::cos(angle) * r, std::sin(angle) * r, z) * vect3(radius);
+			const BBox box(pos - vect3(shell_edge * .5f), pos + vect3(shell_edge * .5f), BBox::flag_direct());
+			rest.addElement(Voxel(box.get_min(), box.get_max()));
+		}
+		break;
+	}
+
+	default:
+		return false;
+	}
+
+	amplitude = edge;
+
+	// moving voxels are picked by a hash of their ids, so they spread over all of the content
+	const simd::f32x4 lift(0.f, 0.f, amplitude, 0.f);
+	const uint32_t moving_threshold = uint32_t(param.stress_motion * float(1 << 24));
+
+	// root bbox covers the full range of motion, so the tree bounds stay put
+	contentBox = BBox();
+
+	for (size_t i = 0; i < count; ++i) {
+		const BBox box = rest.getElement(i).get_bbox();
+		contentBox.grow(box);
+		content.addElement(rest.getElement(i));
+
+		if ((xorshift(uint32_t(i + 1)) * 0x9e3779b9u) >> 8 < moving_threshold) {
+			moving.addElement(uint32_t(i));
+			contentBox.grow(Voxel(box.get_min() - lift, box.get_max() + lift).get_bbox());
+		}
+	}
+
+	return update(scene);
 }
 
 
-inline bool Scene3::update(
-	Timeslice& scene,
-	const float dt) {
-
-	const float period = 32.f; // seconds
+inline bool SceneStress::update(
+	SceneTree& scene) {
 
-	accum_time = wrap_at_period(accum_time + dt, period);
+	const float period = 2.f; // seconds
+	const double golden_ratio = .61803398875;
+	const float time_phase = accum_time / period;
 
-	const float radius = main_radius;
-	size_t index = 0;
-	BBox contentBox;
+	for (size_t i = 0; i < moving.getCount(); ++i) {
+		const uint32_t id = moving.getElement(i);
+		const float phase = float(M_PI * 2.0) * (time_phase + float(fract(id * golden_ratio)));
+		const simd::f32x4 bob(0.f, 0.f, std::sin(phase) * amplitude, 0.f);
+		const BBox box = rest.getElement(id).get_bbox();
 
-	for (int i = 0; i < queue_length; ++i, index += 2) {
-		const float angle = float(M_PI * 2.0) * (i / float(queue_length)) + accum_time * float(M_PI * 2.0) / period;
-		const simd::f32x4 sin_iz = simd::sin(simd::f32x4(
-			i / float(queue_length) * float(M_PI * 16.0),
-			i / float(queue_length) * float(M_PI * 16.0) + accum_time * float(M_PI * 32.0) / period, 0.f, 0.f));
-		const float sin_i = sin_iz[0];
-		const float sin_z = sin_iz[1];
+		content.getMutable(id) = Voxel(box.get_min() + bob, box.get_max() + bob);
+	}
 
-		{
-			const matx3_rotate rot(angle, 0.f, 0.f, 1.f);
-			const vect3 pos = vect3(radius + sin_i, 0.f, sin_z) * rot;
-			const BBox box(
-				pos - vect3(.5f),
-				pos + vect3(.5f),
-				BBox::flag_direct());
+	return scene.set_payload_array(content, contentBox);
+}
 
-			contentBox.grow(box);
-			content.getMutable(index + 0) = Voxel(box.get_min(), box.get_max());
-		}
-		{
-			const matx3_rotate rot(-angle, 0.f, 0.f, 1.f);
-			const vect3 pos = vect3(radius * .5f + sin_i, 0.f, sin_z) * rot;
-			const BBox box(
-				pos - vect3(.35f),
-				pos + vect3(.35f),
-				BBox::flag_direct());
 
-			contentBox.grow(box);
-			content.getMutable(index + 1) = Voxel(box.get_min(), box.get_max());
-		}
-	}
+void SceneStress::skip(
+	const float dt) {
 
-	// account for the last element which is never updated
-	contentBox.grow(content.getElement(index).get_bbox());
+	const float period = 32.f; // seconds
 
-	return scene.set_payload_array(content, contentBox);
+	accum_time = wrap_at_period(accum_time + dt, period);
+	azim = float(M_PI * 2.0) * accum_time / period;
 }
 
 
-bool Scene3::frame(
-	Timeslice& scene,
+bool SceneStress::frame(
+	SceneTree& scene,
 	const float dt) {
 
-	return update(scene, dt);
+	skip(dt);
+
+	return update(scene);
 }
 
 
@@ -745,39 +2226,47 @@ enum {
 	scene_1,
 	scene_2,
 	scene_3,
+	scene_stress,
 
 	scene_count
 };
 
+static_assert(size_t(scene_count) == content_scene_count, "content_scene_count mismatch");
+
 ////////////////////////////////////////////////////////////////////////////////
-// the global control state
+// the control state
 ////////////////////////////////////////////////////////////////////////////////
 
-namespace c {
-	static const float beat_period = 1.714288; // seconds
+// control state of a timeline, driven by the actions of its track
+struct Control {
+	static constexpr float beat_period = 1.714288; // seconds
 
-	static size_t scene_selector;
+	size_t scene_selector = 0;
 
 	// scene properties
-	static float decl = 0.f;
-	static float azim = 0.f;
+	float decl = 0.f;
+	float azim = 0.f;
 
 	// camera properties
-	static float pos_x = 0.f;
-	static float pos_y = 0.f;
-	static float pos_z = 0.f;
+	float pos_x = 0.f;
+	float pos_y = 0.f;
+	float pos_z = 0.f;
 
 	// accumulators
-	static float accum_time = 0.f;
-	static float accum_beat = 0.f;
-	static float accum_beat_2 = 0.f;
+	float accum_time = 0.f;
+	float accum_beat = 0.f;
+	float accum_beat_2 = 0.f;
 
 	// view properties
-	static float contrast_middle = .5f;
-	static float contrast_k = 1.f;
-	static float blur_split = -1.f;
+	float contrast_middle = .5f;
+	float contrast_k = 1.f;
+	float blur_split = -1.f;
+};
+
+constexpr float Control::beat_period;
 
-} // namespace c
+// half-life of a blurred pixel in the temporal blur of the view, seconds
+const float blur_half_life = .05f;
 
 ////////////////////////////////////////////////////////////////////////////////
 // scripting support
@@ -788,13 +2277,15 @@ protected:
 	float lifespan;
 
 public:
-	// start the action; return true if action is alive after the start
+	// start the action on the given control state; return true if action is alive after the start
 	virtual bool start(
+		Control& c,
 		const float delay,
 		const float duration) = 0;
 
 	// perform action at tick (ie. at frame); return true if action still alive
 	virtual bool frame(
+		Control& c,
 		const float dt) = 0;
 };
 
@@ -805,30 +2296,32 @@ public:
 class ActionSetScene1 : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionSetScene1::start(
+	Control& c,
 	const float,
 	const float) {
 
-	c::scene_selector = scene_1;
+	c.scene_selector = scene_1;
 
-	c::pos_x = 0.f;
-	c::pos_y = .25f;
-	c::pos_z = .875f;
+	c.pos_x = 0.f;
+	c.pos_y = .25f;
+	c.pos_z = .875f;
 
-	c::decl = M_PI / -2.0;
+	c.decl = M_PI / -2.0;
 
 	return false;
 }
 
 
 bool ActionSetScene1::frame(
+	Control&,
 	const float) {
 
 	return false;
@@ -841,30 +2334,32 @@ bool ActionSetScene1::frame(
 class ActionSetScene2 : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionSetScene2::start(
+	Control& c,
 	const float,
 	const float) {
 
-	c::scene_selector = scene_2;
+	c.scene_selector = scene_2;
 
-	c::pos_x = 0.f;
-	c::pos_y = .25f;
-	c::pos_z = 1.f;
+	c.pos_x = 0.f;
+	c.pos_y = .25f;
+	c.pos_z = 1.f;
 
-	c::decl = M_PI / -2.0;
+	c.decl = M_PI / -2.0;
 
 	return false;
 }
 
 
 bool ActionSetScene2::frame(
+	Control&,
 	const float) {
 
 	return false;
@@ -877,30 +2372,32 @@ bool ActionSetScene2::frame(
 class ActionSetScene3 : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionSetScene3::start(
+	Control& c,
 	const float,
 	const float) {
 
-	c::scene_selector = scene_3;
+	c.scene_selector = scene_3;
 
-	c::pos_x = 0.f;
-	c::pos_y = 0.f;
-	c::pos_z = 1.125f;
+	c.pos_x = 0.f;
+	c.pos_y = 0.f;
+	c.pos_z = 1.125f;
 
-	c::decl = M_PI / -2.125;
+	c.decl = M_PI / -2.125;
 
 	return false;
 }
 
 
 bool ActionSetScene3::frame(
+	Control&,
 	const float) {
 
 	return false;
@@ -913,24 +2410,26 @@ bool ActionSetScene3::frame(
 class ActionViewBlur : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionViewBlur::start(
+	Control& c,
 	const float,
 	const float) {
 
-	c::blur_split = -1.f;
+	c.blur_split = -1.f;
 
 	return false;
 }
 
 
 bool ActionViewBlur::frame(
+	Control&,
 	const float) {
 
 	return false;
@@ -943,24 +2442,26 @@ bool ActionViewBlur::frame(
 class ActionViewUnblur : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionViewUnblur::start(
+	Control& c,
 	const float,
 	const float) {
 
-	c::blur_split = 1.f;
+	c.blur_split = 1.f;
 
 	return false;
 }
 
 
 bool ActionViewUnblur::frame(
+	Control&,
 	const float) {
 
 	return false;
@@ -973,36 +2474,38 @@ bool ActionViewUnblur::frame(
 class ActionViewBlurDt : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionViewBlurDt::start(
+	Control& c,
 	const float delay,
 	const float) {
 
-	c::blur_split -= (2.0 / c::beat_period) * delay;
+	c.blur_split -= (2.0 / c.beat_period) * delay;
 
-	if (c::blur_split > -1.f)
+	if (c.blur_split > -1.f)
 		return true;
 
-	c::blur_split = -1.f;
+	c.blur_split = -1.f;
 	return false;
 }
 
 
 bool ActionViewBlurDt::frame(
+	Control& c,
 	const float dt) {
 
-	c::blur_split -= (2.0 / c::beat_period) * dt;
+	c.blur_split -= (2.0 / c.beat_period) * dt;
 
-	if (c::blur_split > -1.f)
+	if (c.blur_split > -1.f)
 		return true;
 
-	c::blur_split = -1.f;
+	c.blur_split = -1.f;
 	return false;
 }
 
@@ -1013,36 +2516,38 @@ bool ActionViewBlurDt::frame(
 class ActionViewUnblurDt : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionViewUnblurDt::start(
+	Control& c,
 	const float delay,
 	const float) {
 
-	c::blur_split += (2.0 / c::beat_period) * delay;
+	c.blur_split += (2.0 / c.beat_period) * delay;
 
-	if (c::blur_split < 1.f)
+	if (c.blur_split < 1.f)
 		return true;
 
-	c::blur_split = 1.f;
+	c.blur_split = 1.f;
 	return false;
 }
 
 
 bool ActionViewUnblurDt::frame(
+	Control& c,
 	const float dt) {
 
-	c::blur_split += (2.0 / c::beat_period) * dt;
+	c.blur_split += (2.0 / c.beat_period) * dt;
 
-	if (c::blur_split < 1.f)
+	if (c.blur_split < 1.f)
 		return true;
 
-	c::blur_split = 1.f;
+	c.blur_split = 1.f;
 	return false;
 }
 
@@ -1053,21 +2558,22 @@ bool ActionViewUnblurDt::frame(
 class ActionViewSplit : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionViewSplit::start(
+	Control& c,
 	const float delay,
 	const float duration) {
 
 	if (delay >= duration)
 		return false;
 
-	c::blur_split = simd::sin(simd::f32x4(c::accum_beat * float(M_PI * 2.0 / c::beat_period), simd::flag_zero()))[0] * .25f;
+	c.blur_split = simd::sin(simd::f32x4(c.accum_beat * float(M_PI * 2.0 / c.beat_period), simd::flag_zero()))[0] * .25f;
 
 	lifespan = duration - delay;
 	return true;
@@ -1075,12 +2581,13 @@ bool ActionViewSplit::start(
 
 
 bool ActionViewSplit::frame(
+	Control& c,
 	const float dt) {
 
 	if (dt >= lifespan)
 		return false;
 
-	c::blur_split = simd::sin(simd::f32x4(c::accum_beat * float(M_PI * 2.0 / c::beat_period), simd::flag_zero()))[0] * .25f;
+	c.blur_split = simd::sin(simd::f32x4(c.accum_beat * float(M_PI * 2.0 / c.beat_period), simd::flag_zero()))[0] * .25f;
 
 	lifespan -= dt;
 	return true;
@@ -1093,22 +2600,23 @@ bool ActionViewSplit::frame(
 class ActionContrastBeat : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionContrastBeat::start(
+	Control& c,
 	const float delay,
 	const float duration) {
 
 	if (delay >= duration)
 		return false;
 
-	c::contrast_middle = .5f;
-	c::contrast_k = 1.f + simd::pow(simd::sin(simd::abs(simd::f32x4(float(-M_PI_2) + float(M_PI) * c::accum_beat / c::beat_period, simd::flag_zero()))), simd::f32x4(64.f))[0];
+	c.contrast_middle = .5f;
+	c.contrast_k = 1.f + simd::pow(simd::sin(simd::abs(simd::f32x4(float(-M_PI_2) + float(M_PI) * c.accum_beat / c.beat_period, simd::flag_zero()))), simd::f32x4(64.f))[0];
 
 	lifespan = duration - delay;
 	return true;
@@ -1116,15 +2624,16 @@ bool ActionContrastBeat::start(
 
 
 bool ActionContrastBeat::frame(
+	Control& c,
 	const float dt) {
 
 	if (dt >= lifespan) {
-		c::contrast_middle = .5f;
-		c::contrast_k = 1.f;
+		c.contrast_middle = .5f;
+		c.contrast_k = 1.f;
 		return false;
 	}
 
-	c::contrast_k = 1.f + simd::pow(simd::sin(simd::abs(simd::f32x4(float(-M_PI_2) + float(M_PI) * c::accum_beat / c::beat_period, simd::flag_zero()))), simd::f32x4(64.f))[0];
+	c.contrast_k = 1.f + simd::pow(simd::sin(simd::abs(simd::f32x4(float(-M_PI_2) + float(M_PI) * c.accum_beat / c.beat_period, simd::flag_zero()))), simd::f32x4(64.f))[0];
 
 	lifespan -= dt;
 	return true;
@@ -1137,21 +2646,22 @@ bool ActionContrastBeat::frame(
 class ActionCameraSnake : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionCameraSnake::start(
+	Control& c,
 	const float delay,
 	const float duration) {
 
 	if (delay >= duration)
 		return false;
 
-	c::azim += simd::sin(simd::f32x4(c::accum_beat_2 * float(M_PI / c::beat_period), simd::flag_zero()))[0] * float(M_PI / 4.0) * delay;
+	c.azim += simd::sin(simd::f32x4(c.accum_beat_2 * float(M_PI / c.beat_period), simd::flag_zero()))[0] * float(M_PI / 4.0) * delay;
 
 	lifespan = duration - delay;
 	return true;
@@ -1159,12 +2669,13 @@ bool ActionCameraSnake::start(
 
 
 bool ActionCameraSnake::frame(
+	Control& c,
 	const float dt) {
 
 	if (dt >= lifespan)
 		return false;
 
-	c::azim += simd::sin(simd::f32x4(c::accum_beat_2 * float(M_PI / c::beat_period), simd::flag_zero()))[0] * float(M_PI / 4.0) * dt;
+	c.azim += simd::sin(simd::f32x4(c.accum_beat_2 * float(M_PI / c.beat_period), simd::flag_zero()))[0] * float(M_PI / 4.0) * dt;
 
 	lifespan -= dt;
 	return true;
@@ -1177,21 +2688,22 @@ bool ActionCameraSnake::frame(
 class ActionCameraBounce : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionCameraBounce::start(
+	Control& c,
 	const float delay,
 	const float duration) {
 
 	if (delay >= duration)
 		return false;
 
-	c::azim += simd::cos(simd::f32x4(c::accum_beat_2 * float(M_PI / c::beat_period), simd::flag_zero()))[0] * float(M_PI / 4.0) * delay;
+	c.azim += simd::cos(simd::f32x4(c.accum_beat_2 * float(M_PI / c.beat_period), simd::flag_zero()))[0] * float(M_PI / 4.0) * delay;
 
 	lifespan = duration - delay;
 	return true;
@@ -1199,12 +2711,13 @@ bool ActionCameraBounce::start(
 
 
 bool ActionCameraBounce::frame(
+	Control& c,
 	const float dt) {
 
 	if (dt >= lifespan)
 		return false;
 
-	c::azim += simd::cos(simd::f32x4(c::accum_beat_2 * float(M_PI / c::beat_period), simd::flag_zero()))[0] * float(M_PI / 4.0) * dt;
+	c.azim += simd::cos(simd::f32x4(c.accum_beat_2 * float(M_PI / c.beat_period), simd::flag_zero()))[0] * float(M_PI / 4.0) * dt;
 
 	lifespan -= dt;
 	return true;
@@ -1217,21 +2730,22 @@ bool ActionCameraBounce::frame(
 class ActionCameraBnF : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionCameraBnF::start(
+	Control& c,
 	const float delay,
 	const float duration) {
 
 	if (delay >= duration)
 		return false;
 
-	c::pos_z += simd::cos(simd::f32x4(c::accum_beat_2 * float(M_PI / c::beat_period), simd::flag_zero()))[0] * delay;
+	c.pos_z += simd::cos(simd::f32x4(c.accum_beat_2 * float(M_PI / c.beat_period), simd::flag_zero()))[0] * delay;
 
 	lifespan = duration - delay;
 	return true;
@@ -1239,12 +2753,13 @@ bool ActionCameraBnF::start(
 
 
 bool ActionCameraBnF::frame(
+	Control& c,
 	const float dt) {
 
 	if (dt >= lifespan)
 		return false;
 
-	c::pos_z += simd::cos(simd::f32x4(c::accum_beat_2 * float(M_PI / c::beat_period), simd::flag_zero()))[0] * dt;
+	c.pos_z += simd::cos(simd::f32x4(c.accum_beat_2 * float(M_PI / c.beat_period), simd::flag_zero()))[0] * dt;
 
 	lifespan -= dt;
 	return true;
@@ -1257,21 +2772,22 @@ bool ActionCameraBnF::frame(
 class ActionCameraLean : virtual public Action {
 public:
 	// virtual from Action
-	bool start(const float, const float);
+	bool start(Control&, const float, const float);
 
 	// virtual from Action
-	bool frame(const float);
+	bool frame(Control&, const float);
 };
 
 
 bool ActionCameraLean::start(
+	Control& c,
 	const float delay,
 	const float duration) {
 
 	if (delay >= duration)
 		return false;
 
-	c::decl += simd::sin(simd::f32x4(c::accum_beat_2 * float(M_PI / c::beat_period), simd::flag_zero()))[0] * delay;
+	c.decl += simd::sin(simd::f32x4(c.accum_beat_2 * float(M_PI / c.beat_period), simd::flag_zero()))[0] * delay;
 
 	lifespan = duration - delay;
 	return true;
@@ -1279,12 +2795,13 @@ bool ActionCameraLean::start(
 
 
 bool ActionCameraLean::frame(
+	Control& c,
 	const float dt) {
 
 	if (dt >= lifespan)
 		return false;
 
-	c::decl += simd::sin(simd::f32x4(c::accum_beat_2 * float(M_PI / c::beat_period), simd::flag_zero()))[0] * dt;
+	c.decl += simd::sin(simd::f32x4(c.accum_beat_2 * float(M_PI / c.beat_period), simd::flag_zero()))[0] * dt;
 
 	lifespan -= dt;
 	return true;
@@ -1295,52 +2812,47 @@ cli_param param;
 
 namespace { // anonymous
 
-Scene1 scene1;
-Scene2 scene2;
-Scene3 scene3;
-
-Scene* const scene[] = {
-	&scene1,
-	&scene2,
-	&scene3
+// actions of the track, each instanced per context
+enum {
+	action_set_scene1,
+	action_set_scene2,
+	action_set_scene3,
+	action_contrast_beat,
+	action_view_blur,
+	action_view_unblur,
+	action_view_blur_dt,
+	action_view_unblur_dt,
+	action_view_split,
+	action_camera_snake,
+	action_camera_bounce,
+	action_camera_bnf,
+	action_camera_lean,
+
+	track_action_count
 };
 
-ActionSetScene1    actionSetScene1;
-ActionSetScene2    actionSetScene2;
-ActionSetScene3    actionSetScene3;
-ActionContrastBeat actionContrastBeat;
-ActionViewBlur     actionViewBlur;
-ActionViewUnblur   actionViewUnblur;
-ActionViewBlurDt   actionViewBlurDt;
-ActionViewUnblurDt actionViewUnblurDt;
-ActionViewSplit    actionViewSplit;
-ActionCameraSnake  actionCameraSnake;
-ActionCameraBounce actionCameraBounce;
-ActionCameraBnF    actionCameraBnF;
-ActionCameraLean   actionCameraLean;
-
 // master track of the application (entries sorted by start time)
 const struct {
 	const float start;    // seconds
 	const float duration; // seconds
-	Action& action;
+	const size_t action;  // action_*
 }
 track[] = {
-	{   0.f,        0.f,      actionSetScene1 },
-	{   0.f,        9.428584, actionViewSplit },
-	{   0.f,       68.571342, actionContrastBeat },
-	{   9.428584,   0.f,      actionViewBlurDt },
-	{  68.571342,   0.f,      actionSetScene2 },
-	{  68.571342,   0.f,      actionViewUnblur },
-	{  68.571342,  27.426758, actionCameraBounce },
-	{  82.285824,  6.8551240, actionCameraLean },
-	{  95.998100,   0.f,      actionSetScene3 },
-	{  95.998100,  39.430652, actionCameraSnake },
-	{ 109.714432,  25.714320, actionCameraBnF },
-	{ 133.714464,   0.f,      actionViewBlurDt },
-	{ 135.428752,   0.f,      actionSetScene1 },
-	{ 136.285896,  56.571504, actionContrastBeat },
-	{ 198.f,        0.f,      actionViewUnblurDt }
+	{   0.f,        0.f,      action_set_scene1 },
+	{   0.f,        9.428584, action_view_split },
+	{   0.f,       68.571342, action_contrast_beat },
+	{   9.428584,   0.f,      action_view_blur_dt },
+	{  68.571342,   0.f,      action_set_scene2 },
+	{  68.571342,   0.f,      action_view_unblur },
+	{  68.571342,  27.426758, action_camera_bounce },
+	{  82.285824,  6.8551240, action_camera_lean },
+	{  95.998100,   0.f,      action_set_scene3 },
+	{  95.998100,  39.430652, action_camera_snake },
+	{ 109.714432,  25.714320, action_camera_bnf },
+	{ 133.714464,   0.f,      action_view_blur_dt },
+	{ 135.428752,   0.f,      action_set_scene1 },
+	{ 136.285896,  56.571504, action_contrast_beat },
+	{ 198.f,        0.f,      action_view_unblur_dt }
 };
 
 const size_t octet_w = 2;
@@ -1357,31 +2869,191 @@ const size_t leaf_count = mem_size_leaf / sizeof(simd::u16x4[4]);
 
 const size_t voxel_w = 2;
 const size_t voxel_h = 4096;
+const size_t voxel_h_stress = 65536; // stress scenes: all of the payload ushort start and count can address
+
+const size_t height_w = 1;
+const size_t height_h = 1040;
 
-const size_t mem_size_voxel = voxel_w * voxel_h * sizeof(simd::f32x4);
-const size_t voxel_count = mem_size_voxel / sizeof(simd::f32x4[2]);
+const size_t mem_size_height = height_w * height_h * sizeof(simd::f32x4);
+
+const size_t noise_w = noise_dim;
+const size_t noise_h = noise_dim;
+
+const size_t mem_size_noise = noise_w * noise_h * sizeof(uint16_t[2]);
 
 const size_t carb_w = 1;
-const size_t carb_h = 6;
+const size_t carb_h = 9;
 
 const size_t mem_size_carb = carb_w * carb_h * sizeof(simd::f32x4);
 const size_t carb_count = mem_size_carb / sizeof(simd::f32x4);
 
-Array< Timeslice > timeline;
+} // namespace anonymous
+
+// a timeline with all of its state: scenes and their trees, the scripting of the track, and the control state the
+// track drives; the content_* calls run the default context, over the global param, and the content_context_*
+// calls run contexts of their own, over copies of the param given at creation; contexts share no mutable state,
+// so that each can run on a thread of its own
+struct content_context {
+	cli_param own_param; // param of a context of its own
+	cli_param& param;    // own_param, or the global param for the default context
+
+	// in-house tree builder, shared by all scenes; used in place of the builder of Timeslice while
+	// the CLI asks for build threads
+	OctreeBuilder tree_builder;
+
+	Scene1 scene1;
+	Scene2 scene2;
+	Scene3 scene3;
+	SceneStress sceneStress;
+
+	Scene* const scene[scene_count];
+
+	ActionSetScene1    actionSetScene1;
+	ActionSetScene2    actionSetScene2;
+	ActionSetScene3    actionSetScene3;
+	ActionContrastBeat actionContrastBeat;
+	ActionViewBlur     actionViewBlur;
+	ActionViewUnblur   actionViewUnblur;
+	ActionViewBlurDt   actionViewBlurDt;
+	ActionViewUnblurDt actionViewUnblurDt;
+	ActionViewSplit    actionViewSplit;
+	ActionCameraSnake  actionCameraSnake;
+	ActionCameraBounce actionCameraBounce;
+	ActionCameraBnF    actionCameraBnF;
+	ActionCameraLean   actionCameraLean;
+
+	Action* const track_action[track_action_count];
+
+	// set by init, for voxel_h, or voxel_h_stress when there is a stress scene
+	size_t mem_size_voxel;
+	size_t voxel_count;
+
+	Array< SceneTree > timeline;
+
+	Control c;
+
+	size_t track_cursor;
+	Action* action[8];
+	size_t action_count;
+
+	simd::f32x4 bbox_min;
+	simd::f32x4 bbox_max;
+	simd::f32x4 centre;
+	simd::f32x4 extent;
+	float max_extent;
+
+#if FRAME_RATE == 0
+	uint64_t tlast; // time of the last frame
+
+#endif
+	content_context(const cli_param* const copy)
+	: own_param(nullptr != copy ? *copy : cli_param())
+	, param(nullptr != copy ? own_param : ::param)
+	, sceneStress(param)
+	, scene {
+		&scene1,
+		&scene2,
+		&scene3,
+		&sceneStress }
+	, track_action {
+		&actionSetScene1,
+		&actionSetScene2,
+		&actionSetScene3,
+		&actionContrastBeat,
+		&actionViewBlur,
+		&actionViewUnblur,
+		&actionViewBlurDt,
+		&actionViewUnblurDt,
+		&actionViewSplit,
+		&actionCameraSnake,
+		&actionCameraBounce,
+		&actionCameraBnF,
+		&actionCameraLean }
+	, mem_size_voxel(0)
+	, voxel_count(0)
+	, track_cursor(0)
+	, action_count(0) {
+	}
+
+	int script(const float dt);
+	int seek(const float t);
+	int start_timeline();
+	int init(content_init_arg* arg);
+	int build_bench();
+	int frame(const content_frame_arg& arg, const uint32_t frame);
+	int resample(const content_frame_arg& arg, const uint32_t frame);
+
+	uint64_t build_tree(
+		const size_t s,
+		void* const octet_map,
+		void* const leaf_map,
+		void* const voxel_map);
+};
 
-size_t track_cursor;
-Action* action[8];
-size_t action_count;
+namespace { // anonymous
 
-simd::f32x4 bbox_min;
-simd::f32x4 bbox_max;
-simd::f32x4 centre;
-simd::f32x4 extent;
-float max_extent;
+content_context default_context(nullptr);
 
 } // namespace anonymous
 
-int content_init(content_init_arg *arg)
+// advance the control state by dt
+int content_context::script(const float dt)
+{
+	// upate run time (we aren't supposed to run long - fp32 should do) and beat time
+	c.accum_time += dt;
+	c.accum_beat   = wrap_at_period(c.accum_beat   + dt, c.beat_period);
+	c.accum_beat_2 = wrap_at_period(c.accum_beat_2 + dt, c.beat_period * 2.0);
+
+	// run all live actions, retiring the completed ones
+	for (size_t i = 0; i < action_count; ++i)
+		if (!action[i]->frame(c, dt))
+			action[i--] = action[--action_count];
+
+	// start any pending actions
+	for (; track_cursor < COUNT_OF(track) && c.accum_time >= track[track_cursor].start; ++track_cursor)
+		if (track_action[track[track_cursor].action]->start(c, c.accum_time - track[track_cursor].start, track[track_cursor].duration)) {
+			if (action_count == COUNT_OF(action)) {
+				stream::cerr << "error: too many pending actions\n";
+				return 999;
+			}
+
+			action[action_count++] = track_action[track[track_cursor].action];
+		}
+
+	// a stress scene replaces all scenes of the track, the camera work of the track notwithstanding
+	if (0 != param.stress_voxels)
+		c.scene_selector = scene_stress;
+
+	return 0;
+}
+
+// fast-forward the timeline by the given time, reproducing exactly the control and scene
+// state of a run of fixed-dt frames over that time; skip all tree builds along the way
+int content_context::seek(const float t)
+{
+#if FRAME_RATE == 0
+	const float dt = 1.0 / param.image_hz;
+
+#else
+	const float dt = 1.0 / FRAME_RATE;
+
+#endif
+	const size_t steps = size_t(double(t) / dt);
+
+	for (size_t i = 0; i < steps; ++i) {
+		const int result_script = script(dt);
+
+		if (0 != result_script)
+			return result_script;
+
+		scene[c.scene_selector]->skip(dt);
+	}
+
+	return 0;
+}
+
+// set up the scenes and the control state as of time 0, then seek the timeline to the CLI start time
+int content_context::start_timeline()
 {
 	using testbed::scoped_ptr;
 	using testbed::generic_free;
@@ -1427,8 +3099,6 @@ int content_init(content_init_arg *arg)
 	}
 
 	// prepare the playfield ///////////////////////////////////////////////////
-	timeline.setCapacity(scene_count);
-	timeline.addMultiElement(scene_count);
 
 	// allow scenes to compute their initial params, for us to inquire their prelim info
 
@@ -1463,9 +3133,33 @@ int content_init(content_init_arg *arg)
 	if (!scene3.init(timeline.getMutable(scene_3)))
 		return 3;
 
+	// set initial external storage to the octree of the stress scene (same as storage for the other scenes)
+	timeline.getMutable(scene_stress).set_extrnal_storage(
+		octet_count, octet_map(),
+		leaf_count, leaf_map(),
+		voxel_count, voxel_map());
+
+	if (0 != param.stress_voxels && !sceneStress.init(timeline.getMutable(scene_stress))) {
+		stream::cerr << "error building stress scene; its tree may exceed the " << unsigned(voxel_count - 1) << " payload entries the kernels address\n";
+		return 5;
+	}
+
 	track_cursor = 0;
 	action_count = 0;
 
+	c.scene_selector = 0 != param.stress_voxels ? scene_stress : scene_1;
+	c.decl = 0.f;
+	c.azim = 0.f;
+	c.pos_x = 0.f;
+	c.pos_y = 0.f;
+	c.pos_z = 0.f;
+	c.accum_time = 0.f;
+	c.accum_beat = 0.f;
+	c.accum_beat_2 = 0.f;
+	c.contrast_middle = .5f;
+	c.contrast_k = 1.f;
+	c.blur_split = -1.f;
+
 	// use first scene's initial world bbox to compute a normalization (pan_n_zoom) matrix
 	const BBox& world_bbox = timeline.getElement(scene_1).get_root_bbox();
 
@@ -1475,35 +3169,212 @@ int content_init(content_init_arg *arg)
 	extent = (bbox_max - bbox_min) * simd::f32x4(.5f);
 	max_extent = std::max(extent[0], std::max(extent[1], extent[2]));
 
+	if (0 != seek(param.seek))
+		return 4;
+
+	return 0;
+}
+
+int content_context::init(content_init_arg *arg)
+{
+	// stress scenes are built with the in-house builder, on all hardware threads unless told otherwise
+	if (0 != param.stress_voxels && 0 == param.build_threads)
+		param.build_threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+	if (0 != param.build_threads && !tree_builder.set_thread_count(param.build_threads)) {
+		stream::cerr << "error starting " << param.build_threads << " build threads\n";
+		return -1;
+	}
+
+	mem_size_voxel = voxel_w * (0 != param.stress_voxels ? voxel_h_stress : voxel_h) * sizeof(simd::f32x4);
+	voxel_count = mem_size_voxel / sizeof(simd::f32x4[2]);
+
+	timeline.setCapacity(scene_count);
+	timeline.addMultiElement(scene_count);
+
+	for (size_t s = 0; s < scene_count; ++s)
+		timeline.getMutable(s).set_builder(0 != param.build_threads ? &tree_builder : nullptr);
+
+	const int result_start = start_timeline();
+
+	if (0 != result_start)
+		return result_start;
+
+	// blue-noise channels of the samplers; generate regardless of the sampler in use, as the offline
+	// modes switch samplers
+	blue_noise();
+
 	size_t buf_idx = 0;
 	arg->buffer_size[buf_idx++] = mem_size_octet;
 	arg->buffer_size[buf_idx++] = mem_size_leaf;
 	arg->buffer_size[buf_idx++] = mem_size_voxel;
 	arg->buffer_size[buf_idx++] = mem_size_carb;
+	arg->buffer_size[buf_idx++] = mem_size_height;
+	arg->buffer_size[buf_idx++] = mem_size_noise;
 
 	assert(buffer_designation_count == buf_idx);
 
 	return 0;
 }
 
-int content_deinit(void)
+// build the tree of a scene, as of its current state, into the given storage; return build time, ns, or
+// zero on failure
+uint64_t content_context::build_tree(
+	const size_t s,
+	void* const octet_map,
+	void* const leaf_map,
+	void* const voxel_map)
+{
+	std::memset(octet_map, 0, mem_size_octet);
+	std::memset(leaf_map, 0, mem_size_leaf);
+	std::memset(voxel_map, 0, mem_size_voxel);
+
+	timeline.getMutable(s).set_extrnal_storage(
+		octet_count, octet_map,
+		leaf_count, leaf_map,
+		voxel_count, voxel_map);
+
+	// frame(0) == skip(0) + tree build == tree build
+	const uint64_t tstart = timer_ns();
+
+	if (!scene[s]->frame(timeline.getMutable(s), 0.f))
+		return 0;
+
+	return std::max(timer_ns() - tstart, uint64_t(1));
+}
+
+int content_context::build_bench()
 {
+	using testbed::scoped_ptr;
+	using testbed::generic_free;
+
+	const uint32_t frames = param.bench_frames;
+	const uint32_t thread_count = param.bench_thread_count;
+
+	// scenes are inited with the in-house builder, so the trees of all builds are of the same layout
+	param.build_threads = 1;
+
+	content_init_arg init_arg;
+	const int result_init = init(&init_arg);
+
+	if (0 != result_init)
+		return result_init;
+
+	// reference trees, of the single-thread build, and trees of the thread count under test
+	scoped_ptr< void, generic_free > ref_octet_map(std::malloc(mem_size_octet));
+	scoped_ptr< void, generic_free > ref_leaf_map(std::malloc(mem_size_leaf));
+	scoped_ptr< void, generic_free > ref_voxel_map(std::malloc(mem_size_voxel));
+	scoped_ptr< void, generic_free > octet_map(std::malloc(mem_size_octet));
+	scoped_ptr< void, generic_free > leaf_map(std::malloc(mem_size_leaf));
+	scoped_ptr< void, generic_free > voxel_map(std::malloc(mem_size_voxel));
+
+	if (nullptr == ref_octet_map() || nullptr == ref_leaf_map() || nullptr == ref_voxel_map() ||
+		nullptr == octet_map() || nullptr == leaf_map() || nullptr == voxel_map()) {
+		stream::cerr << "error allocating tree maps\n";
+		return -1;
+	}
+
+	struct Stats {
+		uint64_t sum;
+		uint64_t min;
+		uint64_t max;
+		uint32_t builds;
+		uint32_t mismatches;
+	} stats[scene_count][max_bench_threads];
+
+	for (size_t s = 0; s < scene_count; ++s)
+		for (uint32_t t = 0; t < thread_count; ++t) {
+			stats[s][t].sum = 0;
+			stats[s][t].min = uint64_t(-1);
+			stats[s][t].max = 0;
+			stats[s][t].builds = 0;
+			stats[s][t].mismatches = 0;
+		}
+
+	uint32_t voxels[scene_count] = { 0 };
+	uint32_t entries[scene_count] = { 0 };
+	uint32_t leaves[scene_count] = { 0 };
+
+	// the stress scene is live only when asked for
+	const size_t scene_end = 0 != param.stress_voxels ? scene_count : scene_stress;
+
+	// scenes advance at the screen Hz, each on its own, regardless of the scene selection of the script
+	const float dt = 1.0 / param.image_hz;
+
+	for (uint32_t f = 0; f < frames; ++f)
+		for (size_t s = 0; s < scene_end; ++s) {
+			if (0 != f)
+				scene[s]->skip(dt);
+
+			tree_builder.set_thread_count(1);
+
+			if (0 == build_tree(s, ref_octet_map(), ref_leaf_map(), ref_voxel_map())) {
+				stream::cerr << "failure building scene " << s << " at frame " << f << '\n';
+				return -1;
+			}
+
+			voxels[s] = std::max(voxels[s], uint32_t(timeline.getElement(s).get_payload_count()));
+			entries[s] = std::max(entries[s], tree_builder.get_entry_count());
+
+			const uint16_t (& octet)[8] = *reinterpret_cast< const uint16_t (*)[8] >(ref_octet_map());
+			leaves[s] = std::max(leaves[s], uint32_t(8 - std::count(octet, octet + 8, uint16_t(-1))));
+
+			for (uint32_t t = 0; t < thread_count; ++t) {
+				if (!tree_builder.set_thread_count(param.bench_threads[t])) {
+					stream::cerr << "error starting " << param.bench_threads[t] << " build threads\n";
+					return -1;
+				}
+
+				const uint64_t duration = build_tree(s, octet_map(), leaf_map(), voxel_map());
+
+				if (0 == duration) {
+					stream::cerr << "failure building scene " << s << " at frame " << f << '\n';
+					return -1;
+				}
+
+				Stats& stat = stats[s][t];
+				stat.sum += duration;
+				stat.min = std::min(stat.min, duration);
+				stat.max = std::max(stat.max, duration);
+				stat.builds++;
+
+				if (std::memcmp(octet_map(), ref_octet_map(), mem_size_octet) ||
+					std::memcmp(leaf_map(), ref_leaf_map(), mem_size_leaf) ||
+					std::memcmp(voxel_map(), ref_voxel_map(), mem_size_voxel))
+					stat.mismatches++;
+			}
+		}
+
+	stream::cout << "scene,max_voxels,max_entries,max_tree_kib,threads,builds,mean_us,min_us,max_us,identical\n";
+
+	for (size_t s = 0; s < scene_end; ++s)
+		for (uint32_t t = 0; t < thread_count; ++t) {
+			const Stats& stat = stats[s][t];
+
+			// root octet, leaves and payload entries
+			const double tree_kib = (sizeof(uint16_t[8]) + leaves[s] * sizeof(uint16_t[16]) + entries[s] * sizeof(float[8])) / 1024.0;
+
+			stream::cout << unsigned(s + 1) << ',' << voxels[s] << ',' << entries[s] << ',' << tree_kib << ',' << param.bench_threads[t] << ',' <<
+				stat.builds << ',' << double(stat.sum) * 1e-3 / stat.builds << ',' << double(stat.min) * 1e-3 << ',' << double(stat.max) * 1e-3 << ',' <<
+				(0 == stat.mismatches ? "yes" : "no") << '\n';
+		}
+
 	return 0;
 }
 
-int content_frame(content_frame_arg arg, const uint32_t frame)
+int content_context::frame(const content_frame_arg& arg, const uint32_t frame)
 {
 	const uint32_t image_w = param.image_w;
 	const uint32_t image_h = param.image_h;
-	const uint32_t fmask   = param.frame_msk;
 
 	void *octet_map_buffer = arg.buffer[buffer_octet];
 	void *leaf_map_buffer  = arg.buffer[buffer_leaf];
 	void *voxel_map_buffer = arg.buffer[buffer_voxel];
+	void *height_map_buffer = arg.buffer[buffer_height];
 	void *carb_map_buffer  = arg.buffer[buffer_carb];
+	void *noise_map_buffer = arg.buffer[buffer_noise];
 
 #if FRAME_RATE == 0
-	static uint64_t tlast;
 	const uint64_t tframe = timer_ns();
 
 	if (0 == frame)
@@ -1516,38 +3387,47 @@ int content_frame(content_frame_arg arg, const uint32_t frame)
 	const float dt = 1.0 / FRAME_RATE;
 
 #endif
-	// upate run time (we aren't supposed to run long - fp32 should do) and beat time
-	c::accum_time += dt;
-	c::accum_beat   = wrap_at_period(c::accum_beat   + dt, c::beat_period);
-	c::accum_beat_2 = wrap_at_period(c::accum_beat_2 + dt, c::beat_period * 2.0);
+	const uint64_t script_start = trace_time();
+	const int result_script = script(dt);
+	const uint64_t script_end = trace_time();
 
-	// run all live actions, retiring the completed ones
-	for (size_t i = 0; i < action_count; ++i)
-		if (!action[i]->frame(dt))
-			action[i--] = action[--action_count];
+	trace_span(TRACE_SCRIPT, frame, script_start, script_end, 0);
 
-	// start any pending actions
-	for (; track_cursor < COUNT_OF(track) && c::accum_time >= track[track_cursor].start; ++track_cursor)
-		if (track[track_cursor].action.start(c::accum_time - track[track_cursor].start, track[track_cursor].duration)) {
-			if (action_count == COUNT_OF(action)) {
-				stream::cerr << "error: too many pending actions\n";
-				return 999;
-			}
+	if (0 != result_script)
+		return result_script;
 
-			action[action_count++] = &track[track_cursor].action;
-		}
+	Heightfield field(height_map_buffer, mem_size_height);
+	BBox root_bbox;
+	bool tree = false;
 
-	// set proper external storage to the octree of the live scene
-	// note: practically all buffers of the octree require 16-byte alignment; since this is
-	// guaranteed by 64-bit malloc, we don't do anything WRT alignment here /32-bit caveat
-	timeline.getMutable(c::scene_selector).set_extrnal_storage(
-		octet_count, octet_map_buffer,
-		leaf_count, leaf_map_buffer,
-		voxel_count, voxel_map_buffer);
+	// run the live scene, producing a heightfield if allowed and applicable, or a tree otherwise
+	if (param.flags & FLAG_HEIGHTFIELD && scene[c.scene_selector]->is_heightfield()) {
+		scene[c.scene_selector]->skip(dt);
+
+		if (!scene[c.scene_selector]->heightfield(field))
+			stream::cerr << "failure building frame " << frame << '\n';
+
+		root_bbox = field.get_bbox();
+	}
+	else {
+		field.clear();
+
+		// set proper external storage to the octree of the live scene
+		// note: practically all buffers of the octree require 16-byte alignment; since this is
+		// guaranteed by 64-bit malloc, we don't do anything WRT alignment here /32-bit caveat
+		timeline.getMutable(c.scene_selector).set_extrnal_storage(
+			octet_count, octet_map_buffer,
+			leaf_count, leaf_map_buffer,
+			voxel_count, voxel_map_buffer);
+
+		if (!scene[c.scene_selector]->frame(timeline.getMutable(c.scene_selector), dt))
+			stream::cerr << "failure building frame " << frame << '\n';
+
+		root_bbox = timeline.getElement(c.scene_selector).get_root_bbox();
+		tree = true;
+	}
 
-	// run the live scene
-	if (!scene[c::scene_selector]->frame(timeline.getMutable(c::scene_selector), dt))
-		stream::cerr << "failure building frame " << frame << '\n';
+	trace_span(TRACE_BUILD, frame, script_end, trace_time(), 0);
 
 	// produce camera for the new frame;
 	// collapse S * T and T * S operators as follows:
@@ -1566,25 +3446,25 @@ int content_frame(content_frame_arg arg, const uint32_t frame)
 	// inverse: (eyep)-1 * rotT * (zoom)-1 * (pan)-1
 
 	const matx4 rot =
-		matx4_rotate(scene[c::scene_selector]->get_roll(),           0.f, 1.f, 0.f) *
-		matx4_rotate(scene[c::scene_selector]->get_azim() + c::azim, 0.f, 0.f, 1.f) *
-		matx4_rotate(scene[c::scene_selector]->get_decl() + c::decl, 1.f, 0.f, 0.f);
+		matx4_rotate(scene[c.scene_selector]->get_roll(),           0.f, 1.f, 0.f) *
+		matx4_rotate(scene[c.scene_selector]->get_azim() + c.azim, 0.f, 0.f, 1.f) *
+		matx4_rotate(scene[c.scene_selector]->get_decl() + c.decl, 1.f, 0.f, 0.f);
 
 	const matx4 eyep(
 		1.f, 0.f, 0.f, 0.f,
 		0.f, 1.f, 0.f, 0.f,
 		0.f, 0.f, 1.f, 0.f,
-		scene[c::scene_selector]->get_cam_x() + c::pos_x,
-		scene[c::scene_selector]->get_cam_y() + c::pos_y,
-		scene[c::scene_selector]->get_cam_z() + c::pos_z, 1.f);
+		scene[c.scene_selector]->get_cam_x() + c.pos_x,
+		scene[c.scene_selector]->get_cam_y() + c.pos_y,
+		scene[c.scene_selector]->get_cam_z() + c.pos_z, 1.f);
 
 	const matx4 zoom_n_pan(
 		max_extent, 0.f, 0.f, 0.f,
 		0.f, max_extent, 0.f, 0.f,
 		0.f, 0.f, max_extent, 0.f,
-		centre[0] - scene[c::scene_selector]->get_offset_x(),
-		centre[1] - scene[c::scene_selector]->get_offset_y(),
-		centre[2] - scene[c::scene_selector]->get_offset_z(), 1.f);
+		centre[0] - scene[c.scene_selector]->get_offset_x(),
+		centre[1] - scene[c.scene_selector]->get_offset_y(),
+		centre[2] - scene[c.scene_selector]->get_offset_z(), 1.f);
 
 	const matx4 mv_inv = eyep * transpose(rot) * zoom_n_pan;
 
@@ -1595,11 +3475,147 @@ int content_frame(content_frame_arg arg, const uint32_t frame)
 	carb[2] = vect3(mv_inv[2][0], mv_inv[2][1], mv_inv[2][2]) * vect3(-1);
 	carb[3] = vect3(mv_inv[3][0], mv_inv[3][1], mv_inv[3][2]);
 	// root bbox
-	carb[4] = timeline.getElement(c::scene_selector).get_root_bbox().get_min();
-	carb[5] = timeline.getElement(c::scene_selector).get_root_bbox().get_max();
+	carb[4] = root_bbox.get_min();
+	carb[5] = root_bbox.get_max();
+	// screen rect of the live children of the root octet, or of the root bbox of a heightfield; pixels outside it
+	// miss the scene
+	ScreenRect screen(carb[0], carb[1], carb[2], carb[3]);
+
+	if (tree) {
+		const uint16_t (& octet)[8] = *reinterpret_cast< const uint16_t (*)[8] >(octet_map_buffer);
+		const simd::f32x4 min = carb[4];
+		const simd::f32x4 max = carb[5];
+		const simd::f32x4 mid = (min + max) * simd::f32x4(.5f);
+
+		// child bboxes as of get_child_bbox of the kernels
+		for (uint32_t i = 0; i < 8; ++i)
+			if (uint16_t(-1) != octet[i])
+				screen.add(
+					vect3(i & 1 ? mid[0] : min[0], i & 2 ? mid[1] : min[1], i & 4 ? mid[2] : min[2]),
+					vect3(i & 1 ? max[0] : mid[0], i & 2 ? max[1] : mid[1], i & 4 ? max[2] : mid[2]));
+	}
+	else
+		screen.add(carb[4], carb[5]);
+
+	float rect[4];
+	screen.get(rect);
+	carb[7] = vect3(rect[0], rect[1], rect[2]);
+	carb[7].set(3, rect[3]);
+	// view state, for the post-process stage: contrast middle and factor, blur split in screen coords, and the blend
+	// weight of the prior output in the blur, per the time step of the frame
+	carb[8] = vect3(c.contrast_middle, c.contrast_k, c.blur_split);
+	carb[8].set(3, std::exp2(-dt / blur_half_life));
+
+	// blue-noise tile; a mere 16KB, so just copy it to whichever frame slot we are given
+	std::memcpy(noise_map_buffer, blue_noise(), mem_size_noise);
+
+	return resample(arg, frame);
+}
+
+int content_context::resample(const content_frame_arg& arg, const uint32_t frame)
+{
+	const uint32_t fmask   = param.frame_msk;
+	const uint32_t sampler = param.sampler;
+	const uint32_t flags   = param.flags;
+
+	void *carb_map_buffer  = arg.buffer[buffer_carb];
+
+	vect3 (& carb)[carb_count] = *reinterpret_cast< vect3 (*)[carb_count] >(carb_map_buffer);
 	// frame id
 	const uint32_t masked_frame = frame & fmask;
 	carb[5].set(3, reinterpret_cast< const float& >(masked_frame));
+	// sampler and its per-frame rotation of the blue-noise tile
+	float rot[2];
+	noise_rotation(sampler, masked_frame, rot);
+	carb[6] = vect3(rot[0], rot[1], 0.f);
+	carb[6].set(3, reinterpret_cast< const float& >(sampler));
+	// flags, for the CPU kernels to take those of the context rather than those of the global param
+	carb[6].set(2, reinterpret_cast< const float& >(flags));
+
+	return 0;
+}
+
+int content_init(content_init_arg *arg)
+{
+	return default_context.init(arg);
+}
 
+int content_deinit(void)
+{
 	return 0;
 }
+
+int content_frame(content_frame_arg arg, const uint32_t frame)
+{
+	return default_context.frame(arg, frame);
+}
+
+int content_resample(content_frame_arg arg, const uint32_t frame)
+{
+	return default_context.resample(arg, frame);
+}
+
+int content_seek(const float t)
+{
+	return default_context.seek(t);
+}
+
+int content_rewind(void)
+{
+	return default_context.start_timeline();
+}
+
+uint32_t content_scene(void)
+{
+	return uint32_t(default_context.c.scene_selector);
+}
+
+int content_build_bench(void)
+{
+	return default_context.build_bench();
+}
+
+content_context *content_context_create(const cli_param *param)
+{
+	return new content_context(param);
+}
+
+void content_context_release(content_context *context)
+{
+	delete context;
+}
+
+cli_param *content_context_param(content_context *context)
+{
+	return &context->param;
+}
+
+int content_context_init(content_context *context, content_init_arg *arg)
+{
+	return context->init(arg);
+}
+
+int content_context_frame(content_context *context, content_frame_arg arg, const uint32_t frame)
+{
+	return context->frame(arg, frame);
+}
+
+int content_context_resample(content_context *context, content_frame_arg arg, const uint32_t frame)
+{
+	return context->resample(arg, frame);
+}
+
+int content_context_seek(content_context *context, const float t)
+{
+	return context->seek(t);
+}
+
+int content_context_rewind(content_context *context)
+{
+	return context->start_timeline();
+}
+
+uint32_t content_context_scene(const content_context *context)
+{
+	return uint32_t(context->c.scene_selector);
+}
@@ -3,17 +3,111 @@
 
 #include <stdint.h>
 
-enum { FLAG_BORDERFUL = 1UL }; // window decor: borderful vs borderless
+enum {
+	FLAG_BORDERFUL = 1UL, // window decor: borderful vs borderless
+	FLAG_WAVEFRONT = 2UL, // pipeline: primary and AO passes vs monokernel
+	FLAG_OCTANT_ORDER = 4UL, // closest-hit child order: from ray octant vs from distance sort
+	FLAG_HEIGHTFIELD = 8UL, // heightfield-shaped scenes: max-mip heightfield vs octree
+	FLAG_MAILBOX = 16UL, // CPU traversal: skip voxel tests repeated by a ray vs test every voxel listed
+	FLAG_PERF = 32UL, // offline modes: report hardware performance counters vs not
+	FLAG_TILE_CULL = 64UL, // CPU traversal: primary rays of a tile among the candidates of its frustum vs among all children
+};
+
+enum {
+	SAMPLER_WHITE,      // AO directions from a hash of pixel and frame: white noise
+	SAMPLER_BLUE_R2,    // AO directions from a blue-noise tile, rotated per frame along the R2 sequence
+	SAMPLER_BLUE_SOBOL, // AO directions from a blue-noise tile, rotated per frame along the Sobol sequence
+};
+
+enum {
+	CPU_ISA_AUTO,    // CPU kernels: the best of those the CPU supports
+	CPU_ISA_GENERIC, // CPU kernels: scalar, of the baseline ISA of the build
+	CPU_ISA_AVX2,    // CPU kernels: x86-64 AVX2 and FMA
+	CPU_ISA_AVX512,  // CPU kernels: x86-64 AVX-512F
+	CPU_ISA_NEON,    // CPU kernels: AArch64 NEON
+};
+
+enum {
+	STRESS_UNIFORM,     // voxels at uniform random positions in a box
+	STRESS_CLUSTERED,   // voxels in clusters of about 256, at uniform random positions in a box
+	STRESS_HEIGHTFIELD, // columns standing on z = 0 over a square grid, of a smooth height profile
+	STRESS_SHELL,       // voxels over the surface of a sphere
+};
+
+enum {
+	MODE_REALTIME, // render to screen on the GPU
+	MODE_CONVERGE, // offline: error of temporally-filtered frames vs a high-spp reference, on the CPU
+	MODE_SPPS,     // offline: error of temporally-filtered frames vs cost, over instants and resolution x Hz combos, on the CPU
+	MODE_SWEEP,    // render to screen on the GPU, once per configuration of a run matrix, from the timeline start each
+	MODE_BUILD_BENCH, // offline: tree build times per thread count, and build identity to the single-thread build, on the CPU
+	MODE_MICROBENCH, // offline: times of the traversal primitives of the CPU kernel, per variant, over rays of the scenes
+	MODE_AUTOTUNE,   // offline, then on the GPU: times of CPU tile and GPU workgroup shapes over a timeline slice, the fastest cached
+	MODE_CONTEXTS,   // offline: content contexts rendered on threads of their own at once, checked against each context run alone, on the CPU
+};
+
+enum {
+	max_instants = 8,
+	max_combos = 16,
+	max_sweep_values = 8,
+	max_bench_threads = 8,
+	max_contexts = 64,
+	max_stress_voxels = 1 << 14 // most voxels of which the tree payload of every kind of stress scene fits the 16-bit payload indices
+};
+
+// run matrix of the sweep mode: runs are the cartesian product of the dimensions; a dimension of no values
+// takes its single value from the rest of the CLI
+struct sweep_param {
+	uint32_t screen_count;
+	uint32_t screen[max_sweep_values][3]; // width, height, Hz
+	uint32_t group_count;
+	uint32_t group[max_sweep_values][2];  // width, height
+	uint32_t rng_count;
+	uint32_t frame_msk[2];                // frame-variant: -1U, frame-invariant: 0
+	uint32_t frames_count;
+	uint32_t frames[max_sweep_values];    // frame count, or 0 for seconds
+	float seconds[max_sweep_values];      // duration at the screen Hz, when frame count is 0
+};
 
 struct cli_param {
 	uint32_t image_w;       // frame width
 	uint32_t image_h;       // frame height
 	uint32_t image_hz;      // frame rate target Hz
 	uint32_t frames;        // frames to run
+	float seek;             // timeline start, seconds
 	uint32_t frame_msk;     // frame_id mask
 	uint32_t group_w;       // workgroup width
 	uint32_t group_h;       // workgroup height
 	uint32_t flags;
+	uint32_t sampler;       // AO sampler
+	uint32_t mode;          // run mode
+	uint32_t ref_frames;    // converge and spps modes: frames accumulated in the reference
+	float window;           // converge and spps modes: time constant of the exponential window, seconds
+	float span;             // spps mode: viewing time integrated per combo, seconds
+	uint32_t instant_count; // spps and microbench modes: count of timeline instants
+	float instant[max_instants]; // spps and microbench modes: timeline instants, seconds, ascending
+	uint32_t combo_count;   // spps mode: count of resolution x Hz combos
+	uint32_t combo[max_combos][3]; // spps mode: resolution x Hz combos: width, height, Hz
+	struct sweep_param sweep; // sweep mode: run matrix
+	const char *sweep_out;  // sweep mode: path prefix of the reports
+	const char *trace_out;  // path of the pacing trace, or nil for no tracing
+	uint32_t build_threads; // threads of the in-house tree builder, or 0 for the builder of Timeslice
+	uint32_t bench_frames;  // build_bench mode: timeline frames to build the trees of
+	uint32_t bench_thread_count; // build_bench mode: count of thread counts
+	uint32_t bench_threads[max_bench_threads]; // build_bench mode: thread counts to build with
+	uint32_t stress_kind;   // stress scene: kind of content
+	uint32_t stress_voxels; // stress scene: count of voxels, or 0 for no stress scene
+	float stress_motion;    // stress scene: fraction of voxels moving per frame
+	uint32_t microbench_reps; // microbench mode: timed runs per primitive variant, the fastest one reported
+	uint32_t cpu_isa;       // ISA of the CPU kernels
+	uint32_t tile_w;        // CPU rendering: tile width, or 0 for that of the tuning cache
+	uint32_t tile_h;        // CPU rendering: tile height, i.e. rows of the bands handed out to threads
+	float tune_span;        // autotune mode: timeline slice to time each shape over, seconds
+	const char *tune_cache; // path of the tuning cache, or nil for no cache
+	float res_min;          // dynamic resolution: least render scale of the screen geometry
+	float res_max;          // dynamic resolution: most render scale of the screen geometry; same as res_min for fixed scale
+	float ao_refresh;       // CPU rendering: share of the AO rays of cached hits traced per frame, or 0 for no AO cache
+	uint32_t context_count; // contexts mode: count of contexts, each run on a thread of its own
+	uint32_t context_frames; // contexts mode: frames rendered per context
 };
 
 enum buffer_designations {
@@ -21,10 +115,14 @@ enum buffer_designations {
 	buffer_leaf,  // tree node: leaf
 	buffer_voxel, // tree payload (voxel)
 	buffer_carb,  // Camera and Root BBox
+	buffer_height, // heightfield
+	buffer_noise, // blue-noise tile
 
 	buffer_designation_count,
 };
 
+enum { content_scene_count = 4 };
+
 struct content_init_arg {
 	uint32_t buffer_size[buffer_designation_count];
 };
@@ -43,6 +141,26 @@ int parseCLI(int, const char **);
 int content_init(struct content_init_arg *);
 int content_deinit(void);
 int content_frame(struct content_frame_arg, uint32_t);
+int content_resample(struct content_frame_arg, uint32_t); // re-sample the last content_frame as another frame
+int content_seek(float); // advance the timeline by the given time, without producing frames
+int content_rewind(void); // restart the timeline, as of content_init
+uint32_t content_scene(void); // scene of the last content_frame
+int content_build_bench(void); // report tree build times of the timeline per thread count, on the CPU
+
+// contexts of their own: each runs a timeline of its own, over a copy of the param given at creation, sharing no
+// mutable state with the others or with the content_* calls above, so that contexts can be built and rendered on
+// threads of their own; calls below mirror those above, a context at a time
+struct content_context;
+
+struct content_context *content_context_create(const struct cli_param *);
+void content_context_release(struct content_context *);
+struct cli_param *content_context_param(struct content_context *); // param of the context, to adjust between calls
+int content_context_init(struct content_context *, struct content_init_arg *);
+int content_context_frame(struct content_context *, struct content_frame_arg, uint32_t);
+int content_context_resample(struct content_context *, struct content_frame_arg, uint32_t);
+int content_context_seek(struct content_context *, float);
+int content_context_rewind(struct content_context *);
+uint32_t content_context_scene(const struct content_context *);
 
 #ifdef __cplusplus
 }
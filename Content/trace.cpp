@@ -0,0 +1,208 @@
+#include <time.h>
+#include <stdio.h>
+#include <atomic>
+#include <algorithm>
+
+#include "trace.h"
+#include "param.h"
+#include "stream.hpp"
+
+// verify iostream-free status
+#if _GLIBCXX_IOSTREAM
+#error rogue iostream acquired
+#endif
+
+namespace { // anonymous
+
+// at 8 events per frame, 64K events keep the last ~1 min of frames at 120 Hz
+enum { trace_capacity = 1 << 16 };
+
+static_assert(0 == (trace_capacity & (trace_capacity - 1)), "trace capacity must be a power of 2");
+
+struct Event {
+	uint64_t start;
+	uint64_t end;
+	uint32_t kind;
+	uint32_t frame;
+	uint32_t value;
+
+	// ring position this event was written at, plus one; zero while being written
+	std::atomic< uint64_t > seq;
+};
+
+Event ring[trace_capacity];
+std::atomic< uint64_t > head;
+
+void record(
+	const trace_kind kind,
+	const uint32_t frame,
+	const uint64_t start,
+	const uint64_t end,
+	const uint32_t value) {
+
+	// claim a slot; a writer lapped by another writer at the same slot is practically impossible at our rates,
+	// and would only corrupt that one event
+	const uint64_t pos = head.fetch_add(1, std::memory_order_relaxed);
+	Event& event = ring[pos & (trace_capacity - 1)];
+
+	event.seq.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	event.start = start;
+	event.end = end;
+	event.kind = kind;
+	event.frame = frame;
+	event.value = value;
+
+	event.seq.store(pos + 1, std::memory_order_release);
+}
+
+// Chrome trace tracks, by thread id
+enum {
+	track_cpu = 1,
+	track_gpu,
+	track_completion,
+};
+
+const char* const kind_name[] = {
+	"frame",
+	"script",
+	"build",
+	"dispatch",
+	"present",
+	"gpu",
+	"completion",
+	"queue_depth",
+	"buffering_depth",
+	"drop",
+	"render_scale",
+};
+
+static_assert(sizeof(kind_name) / sizeof(kind_name[0]) == trace_kind_count, "trace kind name missing");
+
+const char* const drop_name[] = {
+	"overload",
+	"superseded",
+};
+
+const char* const pass_name[] = {
+	"mono",
+	"primary",
+	"occlusion",
+};
+
+} // namespace
+
+uint64_t trace_time(void)
+{
+	return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+void trace_span(
+	const trace_kind kind,
+	const uint32_t frame,
+	const uint64_t start,
+	const uint64_t end,
+	const uint32_t value)
+{
+	if (0 == param.trace_out)
+		return;
+
+	record(kind, frame, start, end, value);
+}
+
+void trace_mark(
+	const trace_kind kind,
+	const uint32_t frame,
+	const uint32_t value)
+{
+	if (0 == param.trace_out)
+		return;
+
+	const uint64_t t = trace_time();
+	record(kind, frame, t, t, value);
+}
+
+int trace_write(const char* const path)
+{
+	FILE* const f = fopen(path, "w");
+
+	if (0 == f) {
+		stream::cerr << "error: cannot write trace at " << path << '\n';
+		return -1;
+	}
+
+	const uint64_t end = head.load(std::memory_order_acquire);
+	const uint64_t begin = end > trace_capacity ? end - trace_capacity : 0;
+
+	// timestamps are relative to the oldest event in the ring
+	uint64_t origin = uint64_t(-1);
+
+	for (uint64_t pos = begin; pos < end; ++pos) {
+		const Event& event = ring[pos & (trace_capacity - 1)];
+
+		if (pos + 1 == event.seq.load(std::memory_order_acquire))
+			origin = std::min(origin, event.start);
+	}
+
+	fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+		"{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"CPU frame loop\"}},\n"
+		"{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"GPU\"}},\n"
+		"{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"completion handlers\"}}",
+		track_cpu, track_gpu, track_completion);
+
+	size_t count = 0;
+
+	for (uint64_t pos = begin; pos < end; ++pos) {
+		const Event& event = ring[pos & (trace_capacity - 1)];
+
+		if (pos + 1 != event.seq.load(std::memory_order_acquire))
+			continue;
+
+		const double ts = (event.start - origin) * 1e-3;
+		const char* const name = kind_name[event.kind];
+
+		switch (event.kind) {
+		case TRACE_FRAME:
+		case TRACE_SCRIPT:
+		case TRACE_BUILD:
+		case TRACE_DISPATCH:
+		case TRACE_PRESENT:
+			fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d, \"args\": {\"frame\": %u}}",
+				name, ts, (event.end - event.start) * 1e-3, track_cpu, event.frame);
+			break;
+		case TRACE_GPU:
+			fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d, \"args\": {\"frame\": %u}}",
+				pass_name[event.value], ts, (event.end - event.start) * 1e-3, track_gpu, event.frame);
+			break;
+		case TRACE_COMPLETION:
+			fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f, \"pid\": 1, \"tid\": %d, \"args\": {\"frame\": %u, \"pass\": \"%s\"}}",
+				name, ts, track_completion, event.frame, pass_name[event.value]);
+			break;
+		case TRACE_QUEUE_DEPTH:
+			fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"args\": {\"slots_in_use\": %u}}",
+				name, ts, event.value);
+			break;
+		case TRACE_BUFFERING:
+			fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"args\": {\"slots_allowed\": %u}}",
+				name, ts, event.value);
+			break;
+		case TRACE_DROP:
+			fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"i\", \"s\": \"p\", \"ts\": %.3f, \"pid\": 1, \"tid\": %d, \"args\": {\"frame\": %u, \"reason\": \"%s\"}}",
+				name, ts, track_cpu, event.frame, drop_name[event.value]);
+			break;
+		case TRACE_RESOLUTION:
+			fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"args\": {\"percent\": %u}}",
+				name, ts, event.value);
+			break;
+		}
+
+		++count;
+	}
+
+	fprintf(f, "\n]}\n");
+	fclose(f);
+
+	stream::cout << "trace of " << count << " events written to " << path << '\n';
+	return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef trace_H__
+#define trace_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// pacing trace of the frame loop: events go to a fixed-size ring, oldest overwritten first, and are written out
+// in Chrome trace format (chrome://tracing, ui.perfetto.dev); recording is lock-free and safe from any thread,
+// and a no-op unless tracing is enabled from the CLI
+enum trace_kind {
+	TRACE_FRAME,       // span: frame loop iteration on the CPU
+	TRACE_SCRIPT,      // span: timeline scripting of content_frame
+	TRACE_BUILD,       // span: scene build of content_frame
+	TRACE_DISPATCH,    // span: command encoding and commit
+	TRACE_PRESENT,     // span: destination buffer copy to drawable and present; frame is that of the buffer
+	TRACE_GPU,         // span: command buffer execution on the GPU; value is the pass
+	TRACE_COMPLETION,  // instant: command buffer completion handler; value is the pass
+	TRACE_QUEUE_DEPTH, // counter: frame slots in use
+	TRACE_BUFFERING,   // counter: buffering depth, i.e. frame slots allowed in use
+	TRACE_DROP,        // instant: frame dropped; value is the reason
+	TRACE_RESOLUTION,  // counter: render scale of the screen geometry, percent
+
+	trace_kind_count
+};
+
+enum trace_drop {
+	TRACE_DROP_OVERLOAD,   // not built for lack of a free slot
+	TRACE_DROP_SUPERSEDED, // built, but not presented for a later frame done at the same time
+};
+
+enum trace_pass {
+	TRACE_PASS_MONO,      // monokernel
+	TRACE_PASS_PRIMARY,   // wavefront primary pass
+	TRACE_PASS_OCCLUSION, // wavefront AO pass
+};
+
+// trace clock, ns; same time base as mach_absolute_time, and thus as GPU times of command buffers
+uint64_t trace_time(void);
+
+// record a span of [start, end) on the trace clock
+void trace_span(enum trace_kind kind, uint32_t frame, uint64_t start, uint64_t end, uint32_t value);
+
+// record an instant or a counter value at the present time
+void trace_mark(enum trace_kind kind, uint32_t frame, uint32_t value);
+
+// write the events in the ring to a Chrome trace file; events still being recorded are omitted; return zero on success
+int trace_write(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // trace_H__
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <string.h>
+#if __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+#include "tune.h"
+#include "param.h"
+#include "stream.hpp"
+
+// verify iostream-free status
+#if _GLIBCXX_IOSTREAM
+#error rogue iostream acquired
+#endif
+
+namespace { // anonymous
+
+const char* const backend_name[] = {
+	"cpu",
+	"gpu",
+};
+
+// an entry of the cache: <backend> <image_w> <image_h> <shape_w> <shape_h> <machine>, machine taking the rest of
+// the line, spaces included
+struct Entry {
+	char backend[8];
+	uint32_t image_w;
+	uint32_t image_h;
+	uint32_t shape[2];
+	const char* machine;
+};
+
+enum { max_line = 1024 };
+
+// parse an entry off a line; the machine of the entry points into the line, its newline dropped
+bool parse(
+	char* const line,
+	Entry& entry) {
+
+	int machine_pos = 0;
+
+	if (5 != sscanf(line, "%7s %u %u %u %u %n", entry.backend, &entry.image_w, &entry.image_h, &entry.shape[0], &entry.shape[1], &machine_pos) ||
+		0 == machine_pos)
+		return false;
+
+	line[strcspn(line, "\n")] = '\0';
+	entry.machine = line + machine_pos;
+	return true;
+}
+
+bool matches(
+	const Entry& entry,
+	const tune_backend backend,
+	const char* const machine,
+	const uint32_t image_w,
+	const uint32_t image_h) {
+
+	return
+		!strcmp(entry.backend, backend_name[backend]) &&
+		entry.image_w == image_w &&
+		entry.image_h == image_h &&
+		!strcmp(entry.machine, machine);
+}
+
+} // namespace
+
+void tune_cpu_model(
+	char* const name,
+	const size_t size)
+{
+	snprintf(name, size, "unknown");
+
+#if __APPLE__
+	size_t len = size;
+
+	if (0 != sysctlbyname("machdep.cpu.brand_string", name, &len, 0, 0))
+		snprintf(name, size, "unknown");
+
+#else
+	FILE* const f = fopen("/proc/cpuinfo", "r");
+
+	if (0 == f)
+		return;
+
+	char line[max_line];
+
+	while (fgets(line, sizeof(line), f)) {
+		if (strncmp(line, "model name", strlen("model name")))
+			continue;
+
+		const char* const value = strchr(line, ':');
+
+		if (value) {
+			line[strcspn(line, "\n")] = '\0';
+			snprintf(name, size, "%s", value + strspn(value, ": \t"));
+		}
+
+		break;
+	}
+
+	fclose(f);
+
+#endif
+}
+
+int tune_cache_get(
+	const tune_backend backend,
+	const char* const machine,
+	const uint32_t image_w,
+	const uint32_t image_h,
+	uint32_t shape[2])
+{
+	if (0 == param.tune_cache)
+		return -1;
+
+	FILE* const f = fopen(param.tune_cache, "r");
+
+	if (0 == f)
+		return -1;
+
+	char line[max_line];
+	int result = -1;
+
+	while (fgets(line, sizeof(line), f)) {
+		Entry entry;
+
+		if (parse(line, entry) && matches(entry, backend, machine, image_w, image_h) && entry.shape[0] && entry.shape[1]) {
+			shape[0] = entry.shape[0];
+			shape[1] = entry.shape[1];
+			result = 0;
+		}
+	}
+
+	fclose(f);
+	return result;
+}
+
+int tune_cache_put(
+	const tune_backend backend,
+	const char* const machine,
+	const uint32_t image_w,
+	const uint32_t image_h,
+	const uint32_t shape[2])
+{
+	if (0 == param.tune_cache)
+		return -1;
+
+	// rewrite the cache aside, sans entries of the key, then move it in place
+	char path[max_line];
+	snprintf(path, sizeof(path), "%s.tmp", param.tune_cache);
+
+	FILE* const out = fopen(path, "w");
+
+	if (0 == out) {
+		stream::cerr << "error: cannot write tuning cache at " << path << '\n';
+		return -1;
+	}
+
+	FILE* const in = fopen(param.tune_cache, "r");
+
+	if (in) {
+		char line[max_line];
+
+		while (fgets(line, sizeof(line), in)) {
+			char copy[max_line];
+			memcpy(copy, line, sizeof(copy));
+			Entry entry;
+
+			if (parse(copy, entry) && !matches(entry, backend, machine, image_w, image_h))
+				fputs(line, out);
+		}
+
+		fclose(in);
+	}
+
+	fprintf(out, "%s %u %u %u %u %s\n", backend_name[backend], image_w, image_h, shape[0], shape[1], machine);
+
+	if (0 != fclose(out) || 0 != rename(path, param.tune_cache)) {
+		stream::cerr << "error: cannot write tuning cache at " << param.tune_cache << '\n';
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef tune_H__
+#define tune_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// tuning cache: the fastest shapes found by the autotune mode, one per backend, machine and screen geometry, in
+// a text file of a line per entry at param.tune_cache; runs not given a shape of their own start at the cached one
+enum tune_backend {
+	TUNE_CPU, // tile of CPU rendering: width, height
+	TUNE_GPU, // workgroup of GPU rendering: width, height
+};
+
+// name of the CPU model, or "unknown"; a key of CPU entries would add to it the settings the timings depend on
+void tune_cpu_model(char *name, size_t size);
+
+// look up the shape of a key; return zero on a hit
+int tune_cache_get(enum tune_backend backend, const char *machine, uint32_t image_w, uint32_t image_h, uint32_t shape[2]);
+
+// store the shape of a key, replacing any prior shape of the key; return zero on success
+int tune_cache_put(enum tune_backend backend, const char *machine, uint32_t image_w, uint32_t image_h, const uint32_t shape[2]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // tune_H__
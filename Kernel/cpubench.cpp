@@ -0,0 +1,836 @@
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "cpubench.h"
+#include "cpuprim.h"
+
+// verify iostream-free status
+#if _GLIBCXX_IOSTREAM
+#error rogue iostream acquired
+#endif
+
+using namespace cpuprim;
+
+namespace { // anonymous
+
+// test of the children of a leaf (cells) by a ray
+struct LeafTest {
+	uint32_t ray;
+	uint32_t leaf;
+	BBox bbox;
+};
+
+// test of a voxel by a ray
+struct VoxelTest {
+	uint32_t ray;
+	uint32_t voxel;
+	BBox bbox;
+};
+
+// AO sample of a primary hit
+struct AoSample {
+	uint32_t x;
+	uint32_t y;
+	Hit hit;
+};
+
+} // namespace anonymous
+
+struct cpubench_capture {
+	Source src;
+	Tally tally;
+	Line* linear; // tree of src linearized, or nil if it does not fit the layout
+	uint32_t dimx;
+	uint32_t dimy;
+	uint32_t frame;
+	float sampler_white[4];
+	float sampler_blue[4];
+
+	std::vector< Ray > primary;
+	std::vector< Ray > ao;
+	std::vector< AoSample > ao_sample;
+
+	// origins of the rays premultiplied by their rcpdir
+	std::vector< float3 > primary_origin_rcp;
+	std::vector< float3 > ao_origin_rcp;
+
+	// tests a traversal of the rays performs, in traversal order
+	std::vector< LeafTest > primary_leaf;
+	std::vector< LeafTest > ao_leaf;
+	std::vector< VoxelTest > primary_voxel;
+	std::vector< VoxelTest > ao_voxel;
+};
+
+namespace { // anonymous
+
+void add_voxel_tests(
+	const Source& src,
+	const Leaf& leaf,
+	const uint32_t cell,
+	const uint32_t ray,
+	const size_t max_tests,
+	std::vector< VoxelTest >& test)
+{
+	for (uint32_t j = leaf.start[cell]; j < leaf.start[cell] + leaf.count[cell] && test.size() < max_tests; ++j) {
+		const Voxel payload = get_voxel(src.voxel, j);
+		const VoxelTest t = {
+			ray,
+			j,
+			{
+				float3(payload.min[0], payload.min[1], payload.min[2]),
+				float3(payload.max[0], payload.max[1], payload.max[2])
+			}
+		};
+		test.push_back(t);
+	}
+}
+
+// record the leaf and voxel tests of a closest-hit traversal, as of traverse sans mailboxing
+void capture_traverse(
+	const Source& src,
+	const uint32_t ray_idx,
+	Ray ray,
+	const size_t max_tests,
+	std::vector< LeafTest >& leaf_test,
+	std::vector< VoxelTest >& voxel_test)
+{
+	const Octet octet = get_octet(src.octet, 0);
+	float distance[8];
+	uint8_t index[8];
+
+	const uint32_t hit_count = order_children(src.flags, intersect8(src.root_bbox, ray, distance) & octet_occupancy(octet), distance, ray, index);
+
+	for (uint32_t i = 0; i < hit_count; ++i) {
+		const uint32_t child = octet.child[index[i]];
+		const LeafTest test = { ray_idx, child, get_child_bbox(src.root_bbox, index[i]) };
+		leaf_test.push_back(test);
+
+		const Leaf leaf = get_leaf(src.leaf, child);
+		float cell_distance[8];
+		uint8_t cell_index[8];
+
+		const uint32_t cell_count = order_children(src.flags, intersect8(test.bbox, ray, cell_distance) & leaf_occupancy(leaf), cell_distance, ray, cell_index);
+
+		for (uint32_t j = 0; j < cell_count; ++j) {
+			const size_t first = voxel_test.size();
+			add_voxel_tests(src, leaf, cell_index[j], ray_idx, max_tests, voxel_test);
+
+			bool hit = false;
+
+			for (size_t k = first; k < voxel_test.size(); ++k) {
+				Hit maybe_hit;
+				hit |= intersect(voxel_test[k].bbox, ray, maybe_hit) < cell_distance[cell_index[j]];
+			}
+
+			if (hit)
+				return;
+		}
+	}
+}
+
+// record the leaf and voxel tests of an any-hit traversal, as of occlude sans mailboxing
+void capture_occlude(
+	const Source& src,
+	const uint32_t ray_idx,
+	const Ray& ray,
+	const size_t max_tests,
+	std::vector< LeafTest >& leaf_test,
+	std::vector< VoxelTest >& voxel_test)
+{
+	const Octet octet = get_octet(src.octet, 0);
+	float distance[8];
+
+	for (uint32_t mask = intersect8(src.root_bbox, ray, distance) & octet_occupancy(octet); mask; mask &= mask - 1) {
+		const uint32_t i = __builtin_ctz(mask);
+		const uint32_t child = octet.child[i];
+		const LeafTest test = { ray_idx, child, get_child_bbox(src.root_bbox, i) };
+		leaf_test.push_back(test);
+
+		const Leaf leaf = get_leaf(src.leaf, child);
+		float cell_distance[8];
+
+		for (uint32_t cell_mask = intersect8(test.bbox, ray, cell_distance) & leaf_occupancy(leaf); cell_mask; cell_mask &= cell_mask - 1) {
+			const size_t first = voxel_test.size();
+			add_voxel_tests(src, leaf, __builtin_ctz(cell_mask), ray_idx, max_tests, voxel_test);
+
+			for (size_t k = first; k < voxel_test.size(); ++k)
+				if (get_voxel(src.voxel, voxel_test[k].voxel).min_cookie != ray.prior_id && occluded(voxel_test[k].bbox, ray))
+					return;
+		}
+	}
+}
+
+// linearize the tree of the source buffers, see Line; return nil if a leaf payload exceeds what the 16-bit starts
+// of its record address, or on failure to allocate; free with std::free
+Line* linearize(const Source& src)
+{
+	const Octet octet = get_octet(src.octet, 0);
+	const uint32_t occupancy = octet_occupancy(octet);
+
+	// root line, and the lines of each leaf record: the cell ranges and the payload of the leaf
+	uint32_t line_count = 1;
+	uint32_t leaf_line[8];
+
+	for (uint32_t mask = occupancy; mask; mask &= mask - 1) {
+		const uint32_t i = __builtin_ctz(mask);
+		const Leaf leaf = get_leaf(src.leaf, octet.child[i]);
+		uint32_t payload_count = 0;
+
+		for (uint32_t k = 0; k < 8; ++k)
+			payload_count += leaf.count[k];
+
+		if (payload_count > uint16_t(-1))
+			return nullptr;
+
+		leaf_line[i] = line_count;
+		line_count += (1 + payload_count + 1) / 2;
+	}
+
+	void* linear = nullptr;
+
+	if (0 != posix_memalign(&linear, sizeof(Line), line_count * sizeof(Line)))
+		return nullptr;
+
+	Line* const line = static_cast< Line* >(linear);
+	std::memset(line, 0, line_count * sizeof(Line));
+
+	LinearOctet& root = *reinterpret_cast< LinearOctet* >(line);
+
+	for (uint32_t i = 0; i < 8; ++i)
+		root.child[i] = occupancy & 1U << i ? leaf_line[i] : -1U;
+
+	for (uint32_t mask = occupancy; mask; mask &= mask - 1) {
+		const uint32_t i = __builtin_ctz(mask);
+		const Leaf leaf = get_leaf(src.leaf, octet.child[i]);
+		Leaf& record = *reinterpret_cast< Leaf* >(line + leaf_line[i]);
+		Voxel* const payload = reinterpret_cast< Voxel* >(line + leaf_line[i]);
+		uint32_t start = 1;
+
+		for (uint32_t k = 0; k < 8; ++k) {
+			record.start[k] = 0 != leaf.count[k] ? start : 0;
+			record.count[k] = leaf.count[k];
+
+			std::copy(src.voxel + leaf.start[k], src.voxel + leaf.start[k] + leaf.count[k], payload + start);
+			start += leaf.count[k];
+		}
+	}
+
+	return line;
+}
+
+// alternatives to the primitives of cpukernel ////////////////////////////////////////////////////////////////////
+
+// intersect, given the ray origin premultiplied by the ray rcpdir: a multiply-subtract per slab plane in place of
+// a subtract and a multiply, at the cost of a product per ray, and of a rounding different from the port
+inline float intersect_origin_rcp(
+	const BBox& bbox,
+	const Ray& ray,
+	const float3 origin_rcp,
+	Hit& hit)
+{
+	float axial_min[3];
+	float axial_max[3];
+
+	for (size_t i = 0; i < 3; ++i) {
+		const float t0 = bbox.min[i] * ray.rcpdir[i] - origin_rcp[i];
+		const float t1 = bbox.max[i] * ray.rcpdir[i] - origin_rcp[i];
+
+		hit.min_mask[i] = t0 <= t1;
+		axial_min[i] = std::min(t0, t1);
+		axial_max[i] = std::max(t0, t1);
+	}
+
+	hit.a_mask = axial_min[0] >= axial_min[1];
+	hit.b_mask = std::max(axial_min[0], axial_min[1]) >= axial_min[2];
+
+	const float min = std::max(std::max(axial_min[0], axial_min[1]), axial_min[2]);
+	const float max = std::min(std::min(axial_max[0], axial_max[1]), axial_max[2]);
+
+#if INFINITE_RAY
+	return 0.f < min && min < max ? min : INFINITY;
+#else
+	return 0.f < min && min < max && min < ray.dist ? min : INFINITY;
+#endif
+}
+
+// occluded, given the ray origin premultiplied by the ray rcpdir; see intersect_origin_rcp
+inline bool occluded_origin_rcp(
+	const BBox& bbox,
+	const Ray& ray,
+	const float3 origin_rcp)
+{
+	float min = -INFINITY;
+	float max = INFINITY;
+
+	for (size_t i = 0; i < 3; ++i) {
+		const float t0 = bbox.min[i] * ray.rcpdir[i] - origin_rcp[i];
+		const float t1 = bbox.max[i] * ray.rcpdir[i] - origin_rcp[i];
+
+		min = std::max(min, std::min(t0, t1));
+		max = std::min(max, std::max(t0, t1));
+	}
+
+#if INFINITE_RAY
+	return 0.f < min && min < max;
+#else
+	return 0.f < min && min < max && min < ray.dist;
+#endif
+}
+
+// intersect8 from the distances to the 3 slab planes per axis -- min, mid and max -- shared by the children in
+// place of 2 planes per axis per child; same arithmetic, and thus same results, as the port
+inline uint32_t intersect8_shared_slabs(
+	const BBox& bbox,
+	const Ray& ray,
+	float (& t)[8])
+{
+	const float3 mid = (bbox.min + bbox.max) * .5f;
+	float plane[3][3];
+
+	for (size_t j = 0; j < 3; ++j) {
+		plane[j][0] = (bbox.min[j] - ray.origin[j]) * ray.rcpdir[j];
+		plane[j][1] = (mid[j] - ray.origin[j]) * ray.rcpdir[j];
+		plane[j][2] = (bbox.max[j] - ray.origin[j]) * ray.rcpdir[j];
+	}
+
+	float axial_min[3][2];
+	float axial_max[3][2];
+
+	for (size_t j = 0; j < 3; ++j)
+		for (size_t k = 0; k < 2; ++k) {
+			axial_min[j][k] = std::min(plane[j][k], plane[j][k + 1]);
+			axial_max[j][k] = std::max(plane[j][k], plane[j][k + 1]);
+		}
+
+	uint32_t mask = 0;
+
+	for (uint32_t i = 0; i < 8; ++i) {
+		const uint32_t x = i & 1, y = i >> 1 & 1, z = i >> 2;
+		const float min = std::max(std::max(std::max(-INFINITY, axial_min[0][x]), axial_min[1][y]), axial_min[2][z]);
+		const float max = std::min(std::min(std::min(INFINITY, axial_max[0][x]), axial_max[1][y]), axial_max[2][z]);
+
+		t[i] = max;
+#if INFINITE_RAY
+		mask |= uint32_t(min < max && 0.f < max) << i;
+#else
+		mask |= uint32_t(min < max && 0.f < max && min < ray.dist) << i;
+#endif
+	}
+
+	return mask;
+}
+
+// compare-exchange of 4 lane pairs: a stage of the sort network of order_children< closest_hit > in monokernel.metal
+inline void sort_stage(
+	const float (& a)[4],
+	const float (& b)[4],
+	const uint8_t (& ia)[4],
+	const uint8_t (& ib)[4],
+	float (& min)[4],
+	float (& max)[4],
+	uint8_t (& imin)[4],
+	uint8_t (& imax)[4])
+{
+	for (size_t i = 0; i < 4; ++i) {
+		const bool m = a[i] <= b[i];
+
+		min[i] = std::min(a[i], b[i]);
+		max[i] = std::max(a[i], b[i]);
+		imin[i] = m ? ia[i] : ib[i];
+		imax[i] = m ? ib[i] : ia[i];
+	}
+}
+
+// closest hit: order the hit children (mask) front to back by the 6-stage sort network of monokernel.metal, missed
+// children sorted last at infinite distance; same order as the distance sort, but for the order of equal distances
+inline uint32_t order_children_network(
+	const uint32_t mask,
+	const float (& t)[8],
+	uint8_t (& index)[8])
+{
+	float d[8];
+
+	for (uint32_t i = 0; i < 8; ++i)
+		d[i] = mask >> i & 1 ? t[i] : INFINITY;
+
+	float min0[4], max0[4], min1[4], max1[4], min2[4], max2[4], min3[4], max3[4], min4[4], max4[4], min5[4], max5[4];
+	uint8_t imin0[4], imax0[4], imin1[4], imax1[4], imin2[4], imax2[4], imin3[4], imax3[4], imin4[4], imax4[4], imin5[4], imax5[4];
+
+	sort_stage(
+		{ d[0], d[3], d[4], d[7] },
+		{ d[1], d[2], d[5], d[6] },
+		{ 0, 3, 4, 7 },
+		{ 1, 2, 5, 6 },
+		min0, max0, imin0, imax0);
+	sort_stage(
+		{ min0[0], max0[0], max0[3], min0[3] },
+		{ max0[1], min0[1], min0[2], max0[2] },
+		{ imin0[0], imax0[0], imax0[3], imin0[3] },
+		{ imax0[1], imin0[1], imin0[2], imax0[2] },
+		min1, max1, imin1, imax1);
+	sort_stage(
+		{ min1[0], max1[0], max1[3], min1[3] },
+		{ min1[1], max1[1], max1[2], min1[2] },
+		{ imin1[0], imax1[0], imax1[3], imin1[3] },
+		{ imin1[1], imax1[1], imax1[2], imin1[2] },
+		min2, max2, imin2, imax2);
+	sort_stage(
+		{ min2[0], max2[0], min2[1], max2[1] },
+		{ max2[2], min2[2], max2[3], min2[3] },
+		{ imin2[0], imax2[0], imin2[1], imax2[1] },
+		{ imax2[2], imin2[2], imax2[3], imin2[3] },
+		min3, max3, imin3, imax3);
+	sort_stage(
+		{ min3[0], min3[1], max3[0], max3[1] },
+		{ min3[2], min3[3], max3[2], max3[3] },
+		{ imin3[0], imin3[1], imax3[0], imax3[1] },
+		{ imin3[2], imin3[3], imax3[2], imax3[3] },
+		min4, max4, imin4, imax4);
+	sort_stage(
+		{ min4[0], max4[0], min4[2], max4[2] },
+		{ min4[1], max4[1], min4[3], max4[3] },
+		{ imin4[0], imax4[0], imin4[2], imax4[2] },
+		{ imin4[1], imax4[1], imin4[3], imax4[3] },
+		min5, max5, imin5, imax5);
+
+	for (uint32_t k = 0; k < 4; ++k) {
+		index[k * 2 + 0] = imin5[k];
+		index[k * 2 + 1] = imax5[k];
+	}
+
+	return __builtin_popcount(mask);
+}
+
+// benchmark cases ////////////////////////////////////////////////////////////////////////////////////////////////
+
+// checksum of a child order: the distances in visiting order, so that orders differing only among children of equal
+// distance sum up the same
+uint64_t order_checksum(
+	const uint32_t count,
+	const float (& t)[8],
+	const uint8_t (& index)[8])
+{
+	uint64_t sum = count;
+
+	for (uint32_t k = 0; k < count; ++k)
+		sum = sum * 31 + as_uint(t[index[k]]);
+
+	return sum;
+}
+
+uint64_t intersect8_checksum(
+	const uint32_t mask,
+	const float (& t)[8])
+{
+	uint64_t sum = mask;
+
+	for (uint32_t m = mask; m; m &= m - 1)
+		sum += as_uint(t[__builtin_ctz(m)]);
+
+	return sum;
+}
+
+uint64_t run_intersect(const cpubench_capture& c) {
+	uint64_t sum = 0;
+
+	for (const VoxelTest& test : c.primary_voxel) {
+		Hit hit;
+		sum += intersect(test.bbox, c.primary[test.ray], hit) < INFINITY;
+	}
+
+	return sum;
+}
+
+uint64_t run_intersect_origin_rcp(const cpubench_capture& c) {
+	uint64_t sum = 0;
+
+	for (const VoxelTest& test : c.primary_voxel) {
+		Hit hit;
+		sum += intersect_origin_rcp(test.bbox, c.primary[test.ray], c.primary_origin_rcp[test.ray], hit) < INFINITY;
+	}
+
+	return sum;
+}
+
+uint64_t run_occluded(const cpubench_capture& c) {
+	uint64_t sum = 0;
+
+	for (const VoxelTest& test : c.ao_voxel)
+		sum += occluded(test.bbox, c.ao[test.ray]);
+
+	return sum;
+}
+
+uint64_t run_occluded_origin_rcp(const cpubench_capture& c) {
+	uint64_t sum = 0;
+
+	for (const VoxelTest& test : c.ao_voxel)
+		sum += occluded_origin_rcp(test.bbox, c.ao[test.ray], c.ao_origin_rcp[test.ray]);
+
+	return sum;
+}
+
+template < uint32_t (* isect8)(const BBox&, const Ray&, float (&)[8]) >
+uint64_t run_intersect8(const cpubench_capture& c) {
+	uint64_t sum = 0;
+
+	for (const LeafTest& test : c.primary_leaf) {
+		float t[8];
+		const uint32_t mask = isect8(test.bbox, c.primary[test.ray], t);
+		sum += intersect8_checksum(mask, t);
+	}
+
+	for (const LeafTest& test : c.ao_leaf) {
+		float t[8];
+		const uint32_t mask = isect8(test.bbox, c.ao[test.ray], t);
+		sum += intersect8_checksum(mask, t);
+	}
+
+	return sum;
+}
+
+// closest-hit child orders, as by the port, by ray octant, and by the sort network of monokernel.metal
+enum ChildOrder {
+	order_distance,
+	order_octant,
+	order_network,
+};
+
+inline uint32_t order(
+	const ChildOrder kind,
+	const uint32_t mask,
+	const float (& t)[8],
+	const Ray& ray,
+	uint8_t (& index)[8])
+{
+	switch (kind) {
+	case order_octant:
+		return order_children_octant(mask, ray, index);
+	case order_network:
+		return order_children_network(mask, t, index);
+	default:
+		return order_children_distance(mask, t, index);
+	}
+}
+
+// octet_intersect_wide< closest_hit >: root octet tests of the primary rays
+template < ChildOrder kind >
+uint64_t run_octet_intersect_wide(const cpubench_capture& c) {
+	const Octet octet = get_octet(c.src.octet, 0);
+	uint64_t sum = 0;
+
+	for (const Ray& ray : c.primary) {
+		float t[8];
+		uint8_t index[8];
+		const uint32_t count = order(kind, intersect8(c.src.root_bbox, ray, t) & octet_occupancy(octet), t, ray, index);
+		sum += order_checksum(count, t, index);
+	}
+
+	return sum;
+}
+
+// octlf_intersect_wide< closest_hit >: leaf tests of the primary rays
+template < ChildOrder kind >
+uint64_t run_octlf_intersect_wide(const cpubench_capture& c) {
+	uint64_t sum = 0;
+
+	for (const LeafTest& test : c.primary_leaf) {
+		const Ray& ray = c.primary[test.ray];
+		float t[8];
+		uint8_t index[8];
+		const uint32_t count = order(kind, intersect8(test.bbox, ray, t) & leaf_occupancy(get_leaf(c.src.leaf, test.leaf)), t, ray, index);
+		sum += order_checksum(count, t, index);
+	}
+
+	return sum;
+}
+
+// AO ray directions of the primary hits, from xorshift white noise or from the blue-noise tile
+template < bool blue >
+uint64_t run_ao_direction(const cpubench_capture& c) {
+	const float (& sampler)[4] = blue ? c.sampler_blue : c.sampler_white;
+	uint64_t sum = 0;
+
+	for (const AoSample& sample : c.ao_sample) {
+		float r0, r1;
+		sample_ao(c.src, sampler, sample.x, sample.y, c.dimx, c.dimy, c.frame, r0, r1);
+
+		const float3 dir = ao_direction(sample.hit, r0, r1);
+		sum += as_uint(dir.x) ^ as_uint(dir.y) ^ as_uint(dir.z);
+	}
+
+	return sum;
+}
+
+// octet fetches of the root tests of all rays
+uint64_t run_get_octet(const cpubench_capture& c) {
+	const size_t count = c.primary.size() + c.ao.size();
+	uint64_t sum = 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		const Octet octet = get_octet(c.src.octet, 0);
+
+		for (uint32_t k = 0; k < 8; ++k)
+			sum += octet.child[k];
+	}
+
+	return sum;
+}
+
+// leaf fetches of the leaf tests of all rays, in traversal order
+uint64_t run_get_leaf(const cpubench_capture& c) {
+	uint64_t sum = 0;
+
+	for (const std::vector< LeafTest >* tests : { &c.primary_leaf, &c.ao_leaf })
+		for (const LeafTest& test : *tests) {
+			const Leaf leaf = get_leaf(c.src.leaf, test.leaf);
+
+			for (uint32_t k = 0; k < 8; ++k)
+				sum += leaf.start[k] + leaf.count[k];
+		}
+
+	return sum;
+}
+
+// voxel fetches of the voxel tests of all rays, in traversal order
+uint64_t run_get_voxel(const cpubench_capture& c) {
+	uint64_t sum = 0;
+
+	for (const std::vector< VoxelTest >* tests : { &c.primary_voxel, &c.ao_voxel })
+		for (const VoxelTest& test : *tests) {
+			const Voxel voxel = get_voxel(c.src.voxel, test.voxel);
+			sum += as_uint(voxel.min[0]) + as_uint(voxel.max[2]) + voxel.min_cookie;
+		}
+
+	return sum;
+}
+
+// whole closest-hit and any-hit traversals, for reference of the primitives; child order as of the frame; over the
+// source buffers, or over the linearized tree
+template < bool mailbox, bool linear >
+uint64_t run_traverse(const cpubench_capture& c) {
+	Source src = c.src;
+	src.flags = mailbox ? src.flags | FLAG_MAILBOX : src.flags & ~FLAG_MAILBOX;
+
+	const LinearLayout layout = { c.linear };
+	uint64_t sum = 0;
+
+	for (Ray ray : c.primary) {
+		Hit hit;
+		const uint32_t id = linear ? traverse(src, layout, ray, hit) : traverse(src, ray, hit);
+		sum += -1U != id ? id + as_uint(ray.dist) : 0;
+	}
+
+	return sum;
+}
+
+template < bool mailbox, bool linear >
+uint64_t run_occlude(const cpubench_capture& c) {
+	Source src = c.src;
+	src.flags = mailbox ? src.flags | FLAG_MAILBOX : src.flags & ~FLAG_MAILBOX;
+
+	const LinearLayout layout = { c.linear };
+	uint64_t sum = 0;
+
+	for (const Ray& ray : c.ao)
+		sum += linear ? occlude(src, layout, ray) : occlude(src, ray);
+
+	return sum;
+}
+
+uint64_t count_primary(const cpubench_capture& c) {
+	return c.primary.size();
+}
+
+uint64_t count_ao(const cpubench_capture& c) {
+	return c.ao.size();
+}
+
+uint64_t count_rays(const cpubench_capture& c) {
+	return c.primary.size() + c.ao.size();
+}
+
+uint64_t count_primary_leaf(const cpubench_capture& c) {
+	return c.primary_leaf.size();
+}
+
+uint64_t count_leaf(const cpubench_capture& c) {
+	return c.primary_leaf.size() + c.ao_leaf.size();
+}
+
+uint64_t count_primary_voxel(const cpubench_capture& c) {
+	return c.primary_voxel.size();
+}
+
+uint64_t count_ao_voxel(const cpubench_capture& c) {
+	return c.ao_voxel.size();
+}
+
+uint64_t count_voxel(const cpubench_capture& c) {
+	return c.primary_voxel.size() + c.ao_voxel.size();
+}
+
+uint64_t count_primary_linear(const cpubench_capture& c) {
+	return nullptr != c.linear ? c.primary.size() : 0;
+}
+
+uint64_t count_ao_linear(const cpubench_capture& c) {
+	return nullptr != c.linear ? c.ao.size() : 0;
+}
+
+struct Case {
+	cpubench_case name;
+	uint64_t (* op_count)(const cpubench_capture&);
+	uint64_t (* run)(const cpubench_capture&);
+};
+
+// to A/B an alternative, add it as a variant of its primitive
+const Case bench_case[] = {
+	{ { "intersect", "port" },                       count_primary_voxel, run_intersect },
+	{ { "intersect", "origin_rcp" },                 count_primary_voxel, run_intersect_origin_rcp },
+	{ { "occluded", "port" },                        count_ao_voxel,      run_occluded },
+	{ { "occluded", "origin_rcp" },                  count_ao_voxel,      run_occluded_origin_rcp },
+	{ { "intersect8", "port" },                      count_leaf,          run_intersect8< intersect8 > },
+	{ { "intersect8", "shared_slabs" },              count_leaf,          run_intersect8< intersect8_shared_slabs > },
+	{ { "octet_intersect_wide", "distance_sort" },   count_primary,       run_octet_intersect_wide< order_distance > },
+	{ { "octet_intersect_wide", "octant" },          count_primary,       run_octet_intersect_wide< order_octant > },
+	{ { "octet_intersect_wide", "sort_network" },    count_primary,       run_octet_intersect_wide< order_network > },
+	{ { "octlf_intersect_wide", "distance_sort" },   count_primary_leaf,  run_octlf_intersect_wide< order_distance > },
+	{ { "octlf_intersect_wide", "octant" },          count_primary_leaf,  run_octlf_intersect_wide< order_octant > },
+	{ { "octlf_intersect_wide", "sort_network" },    count_primary_leaf,  run_octlf_intersect_wide< order_network > },
+	{ { "ao_direction", "xorshift" },                count_ao,            run_ao_direction< false > },
+	{ { "ao_direction", "blue_noise" },              count_ao,            run_ao_direction< true > },
+	{ { "get_octet", "port" },                       count_rays,          run_get_octet },
+	{ { "get_leaf", "port" },                        count_leaf,          run_get_leaf },
+	{ { "get_voxel", "port" },                       count_voxel,         run_get_voxel },
+	{ { "traverse", "port" },                        count_primary,       run_traverse< false, false > },
+	{ { "traverse", "mailbox" },                     count_primary,       run_traverse< true, false > },
+	{ { "traverse", "linear" },                      count_primary_linear, run_traverse< false, true > },
+	{ { "occlude", "port" },                         count_ao,            run_occlude< false, false > },
+	{ { "occlude", "mailbox" },                      count_ao,            run_occlude< true, false > },
+	{ { "occlude", "linear" },                       count_ao_linear,     run_occlude< false, true > },
+};
+
+const uint32_t bench_case_count = sizeof(bench_case) / sizeof(bench_case[0]);
+
+} // namespace anonymous
+
+cpubench_capture* cpubench_capture_frame(
+	const content_frame_arg *arg,
+	const uint32_t dimx,
+	const uint32_t dimy,
+	const uint32_t max_rays,
+	const uint32_t max_tests)
+{
+	const float (* const carb)[4] = reinterpret_cast< const float (*)[4] >(arg->buffer[buffer_carb]);
+	const uint32_t* const height = reinterpret_cast< const uint32_t* >(arg->buffer[buffer_height]);
+
+	if (height[3])
+		return nullptr;
+
+	cpubench_capture* const c = new cpubench_capture;
+
+	c->tally = Tally{ 0, 0, 0, 0 };
+	c->linear = nullptr;
+	c->src = Source{
+		reinterpret_cast< const Octet* >(arg->buffer[buffer_octet]),
+		reinterpret_cast< const Leaf* >(arg->buffer[buffer_leaf]),
+		reinterpret_cast< const Voxel* >(arg->buffer[buffer_voxel]),
+		height,
+		reinterpret_cast< const uint16_t (*)[2] >(arg->buffer[buffer_noise]),
+		{
+			float3(carb[4][0], carb[4][1], carb[4][2]),
+			float3(carb[5][0], carb[5][1], carb[5][2])
+		},
+		&c->tally,
+		as_uint(carb[6][2])
+	};
+	c->linear = linearize(c->src);
+	c->dimx = dimx;
+	c->dimy = dimy;
+	c->frame = as_uint(carb[5][3]);
+
+	const float sampler_white[4] = { 0.f, 0.f, 0.f, as_float(SAMPLER_WHITE) };
+	const float sampler_blue[4] = { carb[6][0], carb[6][1], 0.f, as_float(SAMPLER_BLUE_R2) };
+	std::copy(sampler_white, sampler_white + 4, c->sampler_white);
+	std::copy(sampler_blue, sampler_blue + 4, c->sampler_blue);
+
+	const float3 cam0(carb[0][0], carb[0][1], carb[0][2]);
+	const float3 cam1(carb[1][0], carb[1][1], carb[1][2]);
+	const float3 cam2(carb[2][0], carb[2][1], carb[2][2]);
+	const float3 ray_origin(carb[3][0], carb[3][1], carb[3][2]);
+
+	// pixels at an even stride over the frame, as many as max_rays allows
+	const uint32_t stride = std::max(uint32_t(std::ceil(std::sqrt(double(dimx) * dimy / std::max(max_rays, 1U)))), 1U);
+
+	for (uint32_t y = stride / 2; y < dimy; y += stride)
+		for (uint32_t x = stride / 2; x < dimx; x += stride) {
+			const float3 ray_direction =
+				cam0 * ((int32_t(x) * 2 - int32_t(dimx)) * (1.f / dimx)) +
+				cam1 * ((int32_t(y) * 2 - int32_t(dimy)) * (1.f / dimy)) +
+				cam2;
+
+			const Ray primary = { ray_origin, -1U, rcp(ray_direction), FLT_MAX };
+			c->primary.push_back(primary);
+
+			Ray ray = primary;
+			Hit hit;
+			const uint32_t id = traverse(c->src, ray, hit);
+
+			if (-1U == id)
+				continue;
+
+			// AO rays as sampled by the frame
+			float r0, r1;
+			sample_ao(c->src, carb[6], x, y, dimx, dimy, c->frame, r0, r1);
+
+			const Ray ao = { ray_origin + ray_direction * ray.dist, id, rcp(ao_direction(hit, r0, r1)), FLT_MAX };
+			const AoSample sample = { x, y, hit };
+			c->ao.push_back(ao);
+			c->ao_sample.push_back(sample);
+		}
+
+	for (uint32_t i = 0; i < c->primary.size(); ++i) {
+		c->primary_origin_rcp.push_back(c->primary[i].origin * c->primary[i].rcpdir);
+		capture_traverse(c->src, i, c->primary[i], max_tests, c->primary_leaf, c->primary_voxel);
+	}
+
+	for (uint32_t i = 0; i < c->ao.size(); ++i) {
+		c->ao_origin_rcp.push_back(c->ao[i].origin * c->ao[i].rcpdir);
+		capture_occlude(c->src, i, c->ao[i], max_tests, c->ao_leaf, c->ao_voxel);
+	}
+
+	return c;
+}
+
+void cpubench_release(cpubench_capture *capture)
+{
+	if (nullptr != capture)
+		std::free(capture->linear);
+
+	delete capture;
+}
+
+uint32_t cpubench_case_count(void)
+{
+	return bench_case_count;
+}
+
+cpubench_case cpubench_get_case(const uint32_t i)
+{
+	return bench_case[i].name;
+}
+
+uint64_t cpubench_op_count(const cpubench_capture *capture, const uint32_t i)
+{
+	return bench_case[i].op_count(*capture);
+}
+
+uint64_t cpubench_run(const cpubench_capture *capture, const uint32_t i)
+{
+	return bench_case[i].run(*capture);
+}
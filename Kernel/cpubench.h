@@ -0,0 +1,48 @@
+#ifndef cpubench_H__
+#define cpubench_H__
+
+#include <stdint.h>
+#include "param.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// microbenchmarks of the traversal primitives of cpukernel, in isolation, over workloads captured from a content
+// frame: the primary rays of the frame, the AO rays of their hits, and the octet, leaf and voxel tests and fetches
+// those rays take; each primitive comes in variants -- the port used by cpukernel, and alternatives to weigh
+// against it -- so that a kernel change can be evaluated without a full render
+struct cpubench_capture;
+
+struct cpubench_case {
+	const char *primitive; // name of the primitive, as in monokernel.metal where it has a counterpart
+	const char *variant;   // name of the implementation; the first variant of a primitive is the baseline
+};
+
+// capture the workloads from the primary rays of a dimx x dimy frame, at most max_rays of them spread evenly over
+// the frame, and from up to max_tests voxel tests of each kind; the capture refers to the source buffers of the
+// frame, which must outlive it; return null if the frame is not traced by the tree, i.e. of a heightfield map
+struct cpubench_capture *cpubench_capture_frame(
+	const struct content_frame_arg *arg,
+	uint32_t dimx,
+	uint32_t dimy,
+	uint32_t max_rays,
+	uint32_t max_tests);
+
+void cpubench_release(struct cpubench_capture *capture);
+
+// cases of all primitives, variants of a primitive consecutive, baseline first
+uint32_t cpubench_case_count(void);
+struct cpubench_case cpubench_get_case(uint32_t i);
+
+// count of primitive ops of one run of a case over the capture; zero for a variant that does not apply to it
+uint64_t cpubench_op_count(const struct cpubench_capture *capture, uint32_t i);
+
+// run a case once over the capture; return a checksum of the results, same for variants of the same results
+uint64_t cpubench_run(const struct cpubench_capture *capture, uint32_t i);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // cpubench_H__
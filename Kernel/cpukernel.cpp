@@ -0,0 +1,192 @@
+#include <new>
+
+#include "cpukernel.h"
+#include "cpukernel_isa.h"
+#include "cpuprim.h"
+
+// verify iostream-free status
+#if _GLIBCXX_IOSTREAM
+#error rogue iostream acquired
+#endif
+
+using namespace cpuprim;
+
+namespace { // anonymous
+
+typedef void (* Kernel)(const content_frame_arg*, uint8_t*, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, cpukernel_aocache*, cpukernel_stats*);
+
+// records of the AO cache: of all voxels of a scene up to this count
+const uint32_t aocache_capacity = 1U << 16;
+
+void clear(
+	cpukernel_aocache::Record& record,
+	const uint32_t cookie) {
+
+	record.cookie = cookie;
+
+	for (auto& face : record.texel)
+		for (auto& texel : face)
+			texel.store(0, std::memory_order_relaxed);
+}
+
+bool supported(const uint32_t isa) {
+	switch (isa) {
+	case CPU_ISA_GENERIC:
+		return true;
+#if __x86_64__
+	case CPU_ISA_AVX2:
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	case CPU_ISA_AVX512:
+		return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif __aarch64__
+	case CPU_ISA_NEON:
+		return true;
+#endif
+	}
+	return false;
+}
+
+uint32_t select_isa(const uint32_t requested) {
+	if (CPU_ISA_AUTO != requested && supported(requested))
+		return requested;
+
+	// AVX-512 is opt-in: voxel tests dominate, and those take 128-bit ops in either build, so pairing leaves does
+	// not outweigh the lower clocks of 512-bit ops
+	const uint32_t preference[] = {
+		CPU_ISA_AVX2,
+		CPU_ISA_NEON,
+	};
+
+	for (const uint32_t isa : preference)
+		if (supported(isa))
+			return isa;
+
+	return CPU_ISA_GENERIC;
+}
+
+Kernel get_kernel(const uint32_t isa) {
+	switch (isa) {
+#if __x86_64__
+	case CPU_ISA_AVX2:
+		return cpukernel_avx2;
+	case CPU_ISA_AVX512:
+		return cpukernel_avx512;
+#elif __aarch64__
+	case CPU_ISA_NEON:
+		return cpukernel_neon;
+#endif
+	}
+	return cpukernel_generic;
+}
+
+} // namespace anonymous
+
+void cpukernel_generic(
+	const content_frame_arg *arg,
+	uint8_t *dst,
+	const uint32_t dimx,
+	const uint32_t dimy,
+	const uint32_t row_start,
+	const uint32_t row_end,
+	const uint32_t tile_w,
+	cpukernel_aocache *cache,
+	cpukernel_stats *stats)
+{
+	render_rows(arg, dst, dimx, dimy, row_start, row_end, tile_w, cache, *stats);
+}
+
+uint32_t cpukernel_isa(const uint32_t requested)
+{
+	return select_isa(requested);
+}
+
+const char *cpukernel_isa_name(const uint32_t isa)
+{
+	switch (isa) {
+	case CPU_ISA_GENERIC:
+		return "generic";
+	case CPU_ISA_AVX2:
+		return "avx2";
+	case CPU_ISA_AVX512:
+		return "avx512";
+	case CPU_ISA_NEON:
+		return "neon";
+	}
+	return "auto";
+}
+
+void cpukernel(
+	const content_frame_arg *arg,
+	uint8_t *dst,
+	const uint32_t dimx,
+	const uint32_t dimy,
+	const uint32_t row_start,
+	const uint32_t row_end,
+	const uint32_t tile_w,
+	cpukernel_aocache *cache,
+	const uint32_t isa,
+	cpukernel_stats *stats)
+{
+	get_kernel(isa)(arg, dst, dimx, dimy, row_start, row_end, tile_w, cache, stats);
+}
+
+cpukernel_aocache *cpukernel_aocache_create(const float refresh)
+{
+	if (!(refresh > 0.f && refresh <= 1.f))
+		return nullptr;
+
+	cpukernel_aocache::Record* const record = new (std::nothrow) cpukernel_aocache::Record[aocache_capacity];
+
+	if (nullptr == record)
+		return nullptr;
+
+	for (uint32_t i = 0; i < aocache_capacity; ++i)
+		clear(record[i], -1U);
+
+	return new (std::nothrow) cpukernel_aocache{ record, aocache_capacity, uint32_t(refresh * (1U << 24) + .5f), 0 };
+}
+
+void cpukernel_aocache_release(cpukernel_aocache *cache)
+{
+	if (nullptr == cache)
+		return;
+
+	delete [] cache->record;
+	delete cache;
+}
+
+void cpukernel_aocache_update(cpukernel_aocache *cache, const content_frame_arg *arg)
+{
+	cache->frame++;
+
+	const Octet* const octet_map = reinterpret_cast< const Octet* >(arg->buffer[buffer_octet]);
+	const Leaf* const leaf_map = reinterpret_cast< const Leaf* >(arg->buffer[buffer_leaf]);
+	const Voxel* const voxel_map = reinterpret_cast< const Voxel* >(arg->buffer[buffer_voxel]);
+	const uint32_t* const height = reinterpret_cast< const uint32_t* >(arg->buffer[buffer_height]);
+
+	if (height[3])
+		return;
+
+	// voxels of the frame, once per cell they straddle; a record of other bounds than its voxel is one of another
+	// voxel of the cookie, or of the voxel as of before it moved
+	const Octet root = get_octet(octet_map, 0);
+
+	for (uint32_t mask = octet_occupancy(root); mask; mask &= mask - 1) {
+		const Leaf leaf = get_leaf(leaf_map, root.child[__builtin_ctz(mask)]);
+
+		for (uint32_t cell = 0; cell < 8; ++cell)
+			for (uint32_t i = leaf.start[cell]; i < uint32_t(leaf.start[cell] + leaf.count[cell]); ++i) {
+				const Voxel voxel = get_voxel(voxel_map, i);
+				cpukernel_aocache::Record& record = cache->record[voxel.min_cookie & (cache->capacity - 1)];
+
+				if (record.cookie == voxel.min_cookie &&
+					0 == std::memcmp(record.min, voxel.min, sizeof(record.min)) &&
+					0 == std::memcmp(record.max, voxel.max, sizeof(record.max)))
+					continue;
+
+				clear(record, voxel.min_cookie);
+				std::memcpy(record.min, voxel.min, sizeof(record.min));
+				std::memcpy(record.max, voxel.max, sizeof(record.max));
+			}
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef cpukernel_H__
+#define cpukernel_H__
+
+#include <stdint.h>
+#include "param.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// object-space AO cache: AO samples of primary hits accumulated on texels of voxel faces, records of voxels keyed
+// by voxel cookie, texels of a record by face axis and sign and by hit position; a hit of a texel of enough samples
+// shades from its mean, its AO ray traced only for a refresh share of such hits, the samples of the traced rays
+// going to the texel, over a window of the latest; samples of a voxel are dropped once its bounds change
+struct cpukernel_aocache;
+
+// create a cache tracing the given share of the AO rays of cached hits, in (0, 1]; return null on failure
+struct cpukernel_aocache *cpukernel_aocache_create(float refresh);
+void cpukernel_aocache_release(struct cpukernel_aocache *cache);
+
+// take the cache to a new content frame: drop the samples of voxels whose bounds changed, and move to new refresh
+// shares of the hits; call once per frame, ahead of rendering it; no-op for a heightfield frame
+void cpukernel_aocache_update(struct cpukernel_aocache *cache, const struct content_frame_arg *arg);
+
+// counts of cpukernel calls; voxel tests are those of tree traversal, heightfields not included
+struct cpukernel_stats {
+	uint64_t ray_count;  // rays traced, primary and AO
+	uint64_t test_count; // voxel box tests performed
+	uint64_t skip_count; // voxel box tests skipped by mailboxing, as repeats of tests of the same ray
+	uint64_t node_count; // tree node box tests performed, of the 8 children of a node at once
+	uint64_t cull_count; // pixels cleared untraced, as outside the screen rect of the scene
+	uint64_t tile_cull_count; // pixels cleared untraced, as in tiles whose frustum meets no occupied leaf cells
+	uint64_t ao_cache_count; // primary hits shaded from the AO cache, their AO rays untraced
+};
+
+// CPU counterpart of monokernel in monokernel.metal: render rows [row_start, row_end) of a dimx x dimy frame from
+// the source buffers of the frame, as produced by content_frame, to 8-bit luma at dst (row-major, pitch dimx), in
+// tiles of the given rows by tile_w columns, the last tile of the rows taking the columns left, shading through the
+// given AO cache, if any, with the kernel of the given ISA, as of cpukernel_isa; add the counts of the call to stats;
+// pixels are independent of one another but for the cache, whose texels are updated atomically, so disjoint row
+// ranges of a frame can be rendered concurrently, each to stats of its own
+void cpukernel(
+	const struct content_frame_arg *arg,
+	uint8_t *dst,
+	uint32_t dimx,
+	uint32_t dimy,
+	uint32_t row_start,
+	uint32_t row_end,
+	uint32_t tile_w,
+	struct cpukernel_aocache *cache,
+	uint32_t isa,
+	struct cpukernel_stats *stats);
+
+// ISA of cpukernel for the requested one of CPU_ISA_*: the request if the CPU supports it, else, as for auto, the
+// best the CPU supports
+uint32_t cpukernel_isa(uint32_t requested);
+const char *cpukernel_isa_name(uint32_t isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // cpukernel_H__
@@ -0,0 +1,48 @@
+// cpukernel built for x86-64 AVX-512F; selected at runtime by cpukernel_isa
+#if __x86_64__
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <immintrin.h>
+
+#include "cpukernel_isa.h"
+
+// verify iostream-free status
+#if _GLIBCXX_IOSTREAM
+#error rogue iostream acquired
+#endif
+
+// build all of the primitives for the ISA, regardless of the build settings
+#if __clang__
+#pragma clang attribute push (__attribute__((target("avx2,fma,avx512f"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma,avx512f")
+#endif
+
+#define CPUPRIM_AVX512 1
+#include "cpuprim.h"
+
+void cpukernel_avx512(
+	const content_frame_arg *arg,
+	uint8_t *dst,
+	const uint32_t dimx,
+	const uint32_t dimy,
+	const uint32_t row_start,
+	const uint32_t row_end,
+	const uint32_t tile_w,
+	cpukernel_aocache *cache,
+	cpukernel_stats *stats)
+{
+	cpuprim::render_rows(arg, dst, dimx, dimy, row_start, row_end, tile_w, cache, *stats);
+}
+
+#if __clang__
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif // __x86_64__
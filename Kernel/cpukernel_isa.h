@@ -0,0 +1,19 @@
+#ifndef cpukernel_isa_H__
+#define cpukernel_isa_H__
+
+#include <stdint.h>
+#include "cpukernel.h"
+
+// builds of cpukernel per ISA, of the same results; each renders rows as cpukernel does, adding its counts to stats;
+// see cpukernel_<isa>.cpp
+void cpukernel_generic(const content_frame_arg *arg, uint8_t *dst, uint32_t dimx, uint32_t dimy, uint32_t row_start, uint32_t row_end, uint32_t tile_w, cpukernel_aocache *cache, cpukernel_stats *stats);
+
+#if __x86_64__
+void cpukernel_avx2(const content_frame_arg *arg, uint8_t *dst, uint32_t dimx, uint32_t dimy, uint32_t row_start, uint32_t row_end, uint32_t tile_w, cpukernel_aocache *cache, cpukernel_stats *stats);
+void cpukernel_avx512(const content_frame_arg *arg, uint8_t *dst, uint32_t dimx, uint32_t dimy, uint32_t row_start, uint32_t row_end, uint32_t tile_w, cpukernel_aocache *cache, cpukernel_stats *stats);
+
+#elif __aarch64__
+void cpukernel_neon(const content_frame_arg *arg, uint8_t *dst, uint32_t dimx, uint32_t dimy, uint32_t row_start, uint32_t row_end, uint32_t tile_w, cpukernel_aocache *cache, cpukernel_stats *stats);
+
+#endif
+#endif // cpukernel_isa_H__
@@ -0,0 +1,34 @@
+// cpukernel built for AArch64 NEON, baseline of the architecture; selected by cpukernel_isa
+#if __aarch64__
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <arm_neon.h>
+
+#include "cpukernel_isa.h"
+
+// verify iostream-free status
+#if _GLIBCXX_IOSTREAM
+#error rogue iostream acquired
+#endif
+
+#define CPUPRIM_NEON 1
+#include "cpuprim.h"
+
+void cpukernel_neon(
+	const content_frame_arg *arg,
+	uint8_t *dst,
+	const uint32_t dimx,
+	const uint32_t dimy,
+	const uint32_t row_start,
+	const uint32_t row_end,
+	const uint32_t tile_w,
+	cpukernel_aocache *cache,
+	cpukernel_stats *stats)
+{
+	cpuprim::render_rows(arg, dst, dimx, dimy, row_start, row_end, tile_w, cache, *stats);
+}
+
+#endif // __aarch64__
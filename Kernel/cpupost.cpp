@@ -0,0 +1,171 @@
+#include <cmath>
+#include <algorithm>
+#if __SSE2__
+#include <emmintrin.h>
+#elif __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "cpupost.h"
+
+// verify iostream-free status
+#if _GLIBCXX_IOSTREAM
+#error rogue iostream acquired
+#endif
+
+namespace { // anonymous
+
+// factors of the pass, in 16-bit fixed point: a luma delta d scales by a factor f as (d << 7) * (f << 9) >> 16,
+// i.e. of 9 fractional bits, deltas being within 9 bits of sign and magnitude
+const float fixed_one = 512.f;
+
+// post-process a span of pixels, those from blend on blurred; scalar counterpart of the SIMD pass
+inline void post_span(
+	const uint8_t* const src,
+	const uint8_t* const hist,
+	uint8_t* const dst,
+	const uint32_t first,
+	const uint32_t last,
+	const uint32_t blend,
+	const int32_t middle,
+	const int32_t contrast,
+	const int32_t weight) {
+
+	for (uint32_t x = first; x < last; ++x) {
+		const int32_t c = std::min(std::max(middle + ((int32_t(src[x]) - middle) * 128 * contrast >> 16), 0), 255);
+		dst[x] = uint8_t(x < blend ? c : c + ((int32_t(hist[x]) - c) * 128 * weight >> 16));
+	}
+}
+
+#if __SSE2__
+// post-process 16 pixels; the history blend is that of the given weight, zero for none
+inline void post16(
+	const uint8_t* const src,
+	const uint8_t* const hist,
+	uint8_t* const dst,
+	const __m128i middle,
+	const __m128i contrast,
+	const __m128i weight) {
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i s = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src));
+	const __m128i h = _mm_loadu_si128(reinterpret_cast< const __m128i* >(hist));
+
+	// contrast about the middle, then the blend with the history; both deltas fit 16-bit lanes shifted by 7
+	__m128i c[2] = {
+		_mm_unpacklo_epi8(s, zero),
+		_mm_unpackhi_epi8(s, zero)
+	};
+	const __m128i p[2] = {
+		_mm_unpacklo_epi8(h, zero),
+		_mm_unpackhi_epi8(h, zero)
+	};
+
+	for (size_t i = 0; i < 2; ++i) {
+		c[i] = _mm_add_epi16(_mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(c[i], middle), 7), contrast), middle);
+		c[i] = _mm_min_epi16(_mm_max_epi16(c[i], zero), _mm_set1_epi16(255));
+		c[i] = _mm_add_epi16(_mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(p[i], c[i]), 7), weight), c[i]);
+	}
+
+	_mm_storeu_si128(reinterpret_cast< __m128i* >(dst), _mm_packus_epi16(c[0], c[1]));
+}
+
+#elif __ARM_NEON
+// post-process 16 pixels; the history blend is that of the given weight, zero for none
+inline void post16(
+	const uint8_t* const src,
+	const uint8_t* const hist,
+	uint8_t* const dst,
+	const int16x8_t middle,
+	const int16x8_t contrast,
+	const int16x8_t weight) {
+
+	const uint8x16_t s = vld1q_u8(src);
+	const uint8x16_t h = vld1q_u8(hist);
+
+	// contrast about the middle, then the blend with the history; a doubling high half of deltas shifted by 6 is
+	// that of deltas shifted by 7 of the scalar pass
+	int16x8_t c[2] = {
+		vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(s))),
+		vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(s)))
+	};
+	const int16x8_t p[2] = {
+		vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(h))),
+		vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(h)))
+	};
+
+	for (size_t i = 0; i < 2; ++i) {
+		c[i] = vaddq_s16(vqdmulhq_s16(vshlq_n_s16(vsubq_s16(c[i], middle), 6), contrast), middle);
+		c[i] = vminq_s16(vmaxq_s16(c[i], vdupq_n_s16(0)), vdupq_n_s16(255));
+		c[i] = vaddq_s16(vqdmulhq_s16(vshlq_n_s16(vsubq_s16(p[i], c[i]), 6), weight), c[i]);
+	}
+
+	vst1q_u8(dst, vcombine_u8(vqmovun_s16(c[0]), vqmovun_s16(c[1])));
+}
+
+#endif
+} // namespace
+
+int cpupost_frame(
+	const content_frame_arg* const arg,
+	const uint8_t* const src,
+	const uint8_t* const history,
+	uint8_t* const dst,
+	const uint32_t dimx,
+	const uint32_t dimy)
+{
+	const float (* const carb)[4] = reinterpret_cast< const float (*)[4] >(arg->buffer[buffer_carb]);
+	const float (& view)[4] = carb[8];
+
+	// pixels right of the split blur, the split in screen coords as of the primary rays of the kernels
+	const float split = std::floor((view[2] + 1.f) * .5f * dimx) + 1.f;
+	const uint32_t first_blur = uint32_t(std::min(std::max(split, 0.f), float(dimx)));
+
+	const int32_t middle = int32_t(view[0] * 255.f + .5f);
+	const int32_t contrast = int32_t(std::min(view[1], 63.f) * fixed_one + .5f);
+	const int32_t weight = int32_t(std::min(std::max(view[3], 0.f), 1.f) * fixed_one + .5f);
+
+	if (int32_t(fixed_one) == contrast && (dimx == first_blur || 0 == weight))
+		return 0;
+
+	// the first frame of a blur has no history to blend with
+	const uint32_t blend = history ? first_blur : dimx;
+	const uint32_t blend_vec = std::min((blend + 15) & ~15U, dimx);
+
+	for (uint32_t y = 0; y < dimy; ++y) {
+		const uint8_t* const row_src = src + size_t(y) * dimx;
+		const uint8_t* const row_hist = history ? history + size_t(y) * dimx : row_src;
+		uint8_t* const row_dst = dst + size_t(y) * dimx;
+		uint32_t x = 0;
+
+#if __SSE2__ || __ARM_NEON
+#if __SSE2__
+		const __m128i v_middle = _mm_set1_epi16(int16_t(middle));
+		const __m128i v_contrast = _mm_set1_epi16(int16_t(contrast));
+		const __m128i v_weight = _mm_set1_epi16(int16_t(weight));
+		const __m128i v_none = _mm_setzero_si128();
+
+#else
+		const int16x8_t v_middle = vdupq_n_s16(int16_t(middle));
+		const int16x8_t v_contrast = vdupq_n_s16(int16_t(contrast));
+		const int16x8_t v_weight = vdupq_n_s16(int16_t(weight));
+		const int16x8_t v_none = vdupq_n_s16(0);
+
+#endif
+		// unblurred pixels in whole vectors, then the vector straddling the split, if any, in scalar, then blurred
+		// pixels in whole vectors
+		for (; x + 16 <= blend; x += 16)
+			post16(row_src + x, row_hist + x, row_dst + x, v_middle, v_contrast, v_none);
+
+		post_span(row_src, row_hist, row_dst, x, blend_vec, blend, middle, contrast, weight);
+		x = blend_vec;
+
+		for (; x + 16 <= dimx; x += 16)
+			post16(row_src + x, row_hist + x, row_dst + x, v_middle, v_contrast, v_weight);
+
+#endif
+		post_span(row_src, row_hist, row_dst, x, dimx, blend, middle, contrast, weight);
+	}
+
+	return 1;
+}
@@ -0,0 +1,32 @@
+#ifndef cpupost_H__
+#define cpupost_H__
+
+#include <stdint.h>
+#include "param.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// post-process stage of a frame, fused with its output packing: in a single pass over the 8-bit luma of a dimx x
+// dimy frame at src, apply the contrast of the frame about its middle, and the temporal blur of the frame to the
+// right of its blur split, i.e. a running mean with the prior output at history; contrast and blur are those of the
+// view state of the frame, as produced by content_frame; write the frame to present to dst (row-major, pitch dimx),
+// which may be the history itself
+//
+// with no history, e.g. at a change of geometry, the blur restarts of the frame; return zero if the view state of
+// the frame is neutral -- no contrast, no blur -- in which case dst is left as is, and src is the frame to present;
+// non-zero otherwise
+int cpupost_frame(
+	const struct content_frame_arg *arg,
+	const uint8_t *src,
+	const uint8_t *history,
+	uint8_t *dst,
+	uint32_t dimx,
+	uint32_t dimy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // cpupost_H__
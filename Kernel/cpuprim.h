@@ -0,0 +1,1551 @@
+#ifndef cpuprim_H__
+#define cpuprim_H__
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+
+// ISA of the primitives, as defined by the including translation unit, built for that ISA: CPUPRIM_AVX2,
+// CPUPRIM_AVX512 or CPUPRIM_NEON; none for the generic build, of the baseline ISA of the target
+#if CPUPRIM_AVX2 || CPUPRIM_AVX512
+#include <immintrin.h>
+#elif CPUPRIM_NEON
+#include <arm_neon.h>
+#endif
+
+#if CPUPRIM_AVX512
+#define CPUPRIM_NAMESPACE avx512
+#elif CPUPRIM_AVX2
+#define CPUPRIM_NAMESPACE avx2
+#elif CPUPRIM_NEON
+#define CPUPRIM_NAMESPACE neon
+#else
+#define CPUPRIM_NAMESPACE generic
+#endif
+
+#include "param.h"
+#include "cpukernel.h"
+
+// primitives of cpukernel, a scalar port of monokernel.metal; routines keep the names and the semantics of their
+// metal counterparts, so see there for commentary beyond the port specifics; shared by cpukernel and cpubench,
+// the latter timing them in isolation
+//
+// builds for different ISAs are of the same results, and live in inline namespaces of their own, to keep them
+// apart at link time: box tests take 128-bit ops per voxel and 256-bit ops per 8 children, and AVX-512 tests the
+// children of 2 leaves in 512-bit ops
+
+// AO cache, see cpukernel_aocache_create; plain data, shared by the builds for all ISAs
+struct cpukernel_aocache {
+	enum {
+		texel_side = 4,    // texels per side of a face
+		min_samples = 4,   // samples of a texel it takes to shade from it
+		max_samples = 64,  // samples of a texel past which its counts are halved, for a window of the latest
+	};
+
+	// record of a voxel: texels of its faces, of axis * 2 + 0 for the min face, 1 for the max face, each the count
+	// of samples in the lo 16 bits, and of unoccluded samples in the hi 16 bits
+	struct Record {
+		uint32_t cookie; // voxel of the record, or -1U for none
+		float min[3];    // bounds of the voxel as of the samples
+		float max[3];
+		std::atomic< uint32_t > texel[6][texel_side * texel_side];
+	};
+
+	Record* record;    // records, direct-mapped by cookie
+	uint32_t capacity; // count of records, a power of 2
+	uint32_t refresh;  // share of the AO rays of cached hits traced, of 2^24
+	uint32_t frame;    // count of frames the cache was taken to
+};
+
+namespace cpuprim {
+inline namespace CPUPRIM_NAMESPACE {
+
+const float pi = 3.1415926535897932f;
+
+struct float3 {
+	float x, y, z;
+
+	float3() {
+	}
+
+	float3(
+		const float x,
+		const float y,
+		const float z)
+	: x(x)
+	, y(y)
+	, z(z) {
+	}
+
+	float operator[](const size_t i) const {
+		return (&x)[i];
+	}
+};
+
+inline float3 operator +(const float3 a, const float3 b) {
+	return float3(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+inline float3 operator -(const float3 a, const float3 b) {
+	return float3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline float3 operator *(const float3 a, const float3 b) {
+	return float3(a.x * b.x, a.y * b.y, a.z * b.z);
+}
+
+inline float3 operator *(const float3 a, const float b) {
+	return float3(a.x * b, a.y * b, a.z * b);
+}
+
+inline float3 rcp(const float3 a) {
+	// clamp as in the kernels: rcp of +-0 is +-MAXFLOAT
+	return float3(
+		std::min(std::max(1.f / a.x, -FLT_MAX), FLT_MAX),
+		std::min(std::max(1.f / a.y, -FLT_MAX), FLT_MAX),
+		std::min(std::max(1.f / a.z, -FLT_MAX), FLT_MAX));
+}
+
+inline uint32_t as_uint(const float a) {
+	uint32_t r;
+	std::memcpy(&r, &a, sizeof(r));
+	return r;
+}
+
+inline float as_float(const uint32_t a) {
+	float r;
+	std::memcpy(&r, &a, sizeof(r));
+	return r;
+}
+
+inline float fract(const float a) {
+	return std::min(a - std::floor(a), 1.f - FLT_EPSILON * .5f);
+}
+
+struct BBox {
+	float3 min;
+	float3 max;
+};
+
+struct Ray {
+	float3 origin;
+	uint32_t prior_id;
+	float3 rcpdir;
+	float dist;
+};
+
+struct Hit {
+	bool min_mask[3];
+	bool a_mask;
+	bool b_mask;
+};
+
+// tree node: interior (octet)
+struct Octet {
+	uint16_t child[8];
+};
+
+// tree node: leaf
+struct Leaf {
+	uint16_t start[8];
+	uint16_t count[8];
+};
+
+// tree payload (voxel)
+struct Voxel {
+	float min[3];
+	uint32_t min_cookie;
+	float max[3];
+	uint32_t max_cookie;
+};
+
+// linearized tree, an alternative to the layout of the source buffers: a stream of 64-byte lines, the root octet
+// first, then the leaves in child order, each leaf record right followed by its payload -- the cell ranges of a
+// leaf take the first half of its first line, so a leaf of a single voxel takes a single line; records start at
+// line boundaries, and the starts of a leaf are in voxels from its record
+struct alignas(64) Line {
+	uint32_t word[16];
+};
+
+// tree node of the linearized tree: interior (octet)
+struct LinearOctet {
+	uint32_t child[8]; // line of the leaf record of each child, or -1U for none
+	uint32_t unused[8];
+};
+
+static_assert(sizeof(Line) == 64 && sizeof(LinearOctet) == sizeof(Line), "Line size mismatch");
+static_assert(sizeof(Leaf) == sizeof(Voxel), "Leaf record size mismatch");
+
+// counts of a cpukernel call, see cpukernel_stats
+struct Tally {
+	uint64_t ray_count;
+	uint64_t test_count;
+	uint64_t skip_count;
+	uint64_t node_count;
+};
+
+// source buffers of a frame
+struct Source {
+	const Octet* octet;
+	const Leaf* leaf;
+	const Voxel* voxel;
+	const uint32_t* height;
+	const uint16_t (* noise)[2];
+	BBox root_bbox;
+	Tally* tally;
+	uint32_t flags; // FLAG_* of the frame, of which FLAG_OCTANT_ORDER and FLAG_MAILBOX matter
+};
+
+// per-ray cache of the latest tests of voxels straddling cells, direct-mapped by voxel cookie: such a voxel is listed
+// in each cell it straddles, and a ray walking those cells would test it again for the same outcome; voxels within
+// a cell are never cached, to keep them from evicting the straddling ones; closest-hit keeps the test outcome,
+// any-hit needs none as all tests up to the first occluder are misses
+struct Mailbox {
+	enum { size = 16 };
+
+	uint32_t id[size];
+	float dist[size];
+	Hit hit[size];
+
+	Mailbox() {
+		std::fill(id, id + size, -1U);
+	}
+
+	static uint32_t slot(const uint32_t id) {
+		return id & (size - 1);
+	}
+};
+
+// children of the root octet, and cells of their leaves, a closest-hit traversal may enter; those of a tile are the
+// ones the frustum of the tile meets, a superset of those any primary ray of the tile enters
+struct Candidates {
+	uint32_t child_mask;
+	uint8_t cell_mask[8];
+
+	static Candidates all() {
+		return Candidates{ 0xff, { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff } };
+	}
+};
+
+// pyramid of the primary rays of a tile: apex and inward normals of the side planes
+struct Frustum {
+	float3 origin;
+	float3 normal[4];
+};
+
+inline bool contains(
+	const BBox& bbox,
+	const Voxel& voxel)
+{
+	return
+		bbox.min.x <= voxel.min[0] && voxel.max[0] <= bbox.max.x &&
+		bbox.min.y <= voxel.min[1] && voxel.max[1] <= bbox.max.y &&
+		bbox.min.z <= voxel.min[2] && voxel.max[2] <= bbox.max.z;
+}
+
+#if CPUPRIM_AVX2 || CPUPRIM_AVX512
+// slab distances of the bbox per axis, in lanes 0-2
+inline void slabs(
+	const BBox& bbox,
+	const Ray& ray,
+	__m128& t0,
+	__m128& t1)
+{
+	const __m128 origin = _mm_setr_ps(ray.origin.x, ray.origin.y, ray.origin.z, 0.f);
+	const __m128 rcpdir = _mm_setr_ps(ray.rcpdir.x, ray.rcpdir.y, ray.rcpdir.z, 0.f);
+
+	t0 = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(bbox.min.x, bbox.min.y, bbox.min.z, 0.f), origin), rcpdir);
+	t1 = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(bbox.max.x, bbox.max.y, bbox.max.z, 0.f), origin), rcpdir);
+}
+
+inline float intersect(
+	const BBox& bbox,
+	const Ray& ray,
+	Hit& hit)
+{
+	__m128 t0, t1;
+	slabs(bbox, ray, t0, t1);
+
+	const uint32_t min_mask = _mm_movemask_ps(_mm_cmple_ps(t0, t1));
+	const __m128 axial_min = _mm_min_ps(t0, t1);
+	const __m128 axial_max = _mm_max_ps(t0, t1);
+	const __m128 axial_min_y = _mm_shuffle_ps(axial_min, axial_min, _MM_SHUFFLE(1, 1, 1, 1));
+	const __m128 axial_min_z = _mm_shuffle_ps(axial_min, axial_min, _MM_SHUFFLE(2, 2, 2, 2));
+	const __m128 axial_max_y = _mm_shuffle_ps(axial_max, axial_max, _MM_SHUFFLE(1, 1, 1, 1));
+	const __m128 axial_max_z = _mm_shuffle_ps(axial_max, axial_max, _MM_SHUFFLE(2, 2, 2, 2));
+	const __m128 min_xy = _mm_max_ss(axial_min, axial_min_y);
+
+	for (size_t i = 0; i < 3; ++i)
+		hit.min_mask[i] = min_mask >> i & 1;
+
+	hit.a_mask = _mm_comige_ss(axial_min, axial_min_y);
+	hit.b_mask = _mm_comige_ss(min_xy, axial_min_z);
+
+	const float min = _mm_cvtss_f32(_mm_max_ss(min_xy, axial_min_z));
+	const float max = _mm_cvtss_f32(_mm_min_ss(_mm_min_ss(axial_max, axial_max_y), axial_max_z));
+
+#if INFINITE_RAY
+	return 0.f < min && min < max ? min : INFINITY;
+#else
+	return 0.f < min && min < max && min < ray.dist ? min : INFINITY;
+#endif
+}
+
+inline bool occluded(
+	const BBox& bbox,
+	const Ray& ray)
+{
+	__m128 t0, t1;
+	slabs(bbox, ray, t0, t1);
+
+	const __m128 axial_min = _mm_min_ps(t0, t1);
+	const __m128 axial_max = _mm_max_ps(t0, t1);
+
+	const float min = _mm_cvtss_f32(_mm_max_ss(_mm_max_ss(axial_min,
+		_mm_shuffle_ps(axial_min, axial_min, _MM_SHUFFLE(1, 1, 1, 1))),
+		_mm_shuffle_ps(axial_min, axial_min, _MM_SHUFFLE(2, 2, 2, 2))));
+	const float max = _mm_cvtss_f32(_mm_min_ss(_mm_min_ss(axial_max,
+		_mm_shuffle_ps(axial_max, axial_max, _MM_SHUFFLE(1, 1, 1, 1))),
+		_mm_shuffle_ps(axial_max, axial_max, _MM_SHUFFLE(2, 2, 2, 2))));
+
+#if INFINITE_RAY
+	return 0.f < min && min < max;
+#else
+	return 0.f < min && min < max && min < ray.dist;
+#endif
+}
+
+#elif CPUPRIM_NEON
+// slab distances of the bbox per axis, in lanes 0-2
+inline void slabs(
+	const BBox& bbox,
+	const Ray& ray,
+	float32x4_t& t0,
+	float32x4_t& t1)
+{
+	const float origin_[4] = { ray.origin.x, ray.origin.y, ray.origin.z, 0.f };
+	const float rcpdir_[4] = { ray.rcpdir.x, ray.rcpdir.y, ray.rcpdir.z, 0.f };
+	const float min_[4] = { bbox.min.x, bbox.min.y, bbox.min.z, 0.f };
+	const float max_[4] = { bbox.max.x, bbox.max.y, bbox.max.z, 0.f };
+	const float32x4_t origin = vld1q_f32(origin_);
+	const float32x4_t rcpdir = vld1q_f32(rcpdir_);
+
+	t0 = vmulq_f32(vsubq_f32(vld1q_f32(min_), origin), rcpdir);
+	t1 = vmulq_f32(vsubq_f32(vld1q_f32(max_), origin), rcpdir);
+}
+
+inline float intersect(
+	const BBox& bbox,
+	const Ray& ray,
+	Hit& hit)
+{
+	float32x4_t t0, t1;
+	slabs(bbox, ray, t0, t1);
+
+	const uint32x4_t min_mask = vcleq_f32(t0, t1);
+	const float32x4_t axial_min = vminq_f32(t0, t1);
+	const float32x4_t axial_max = vmaxq_f32(t0, t1);
+	const float min_x = vgetq_lane_f32(axial_min, 0);
+	const float min_y = vgetq_lane_f32(axial_min, 1);
+	const float min_z = vgetq_lane_f32(axial_min, 2);
+
+	hit.min_mask[0] = vgetq_lane_u32(min_mask, 0);
+	hit.min_mask[1] = vgetq_lane_u32(min_mask, 1);
+	hit.min_mask[2] = vgetq_lane_u32(min_mask, 2);
+	hit.a_mask = min_x >= min_y;
+	hit.b_mask = std::max(min_x, min_y) >= min_z;
+
+	const float min = std::max(std::max(min_x, min_y), min_z);
+	const float max = std::min(std::min(vgetq_lane_f32(axial_max, 0), vgetq_lane_f32(axial_max, 1)), vgetq_lane_f32(axial_max, 2));
+
+#if INFINITE_RAY
+	return 0.f < min && min < max ? min : INFINITY;
+#else
+	return 0.f < min && min < max && min < ray.dist ? min : INFINITY;
+#endif
+}
+
+inline bool occluded(
+	const BBox& bbox,
+	const Ray& ray)
+{
+	float32x4_t t0, t1;
+	slabs(bbox, ray, t0, t1);
+
+	// lane 3 of the slabs is of no bbox: neutralize it in the reductions
+	const float32x4_t axial_min = vsetq_lane_f32(-INFINITY, vminq_f32(t0, t1), 3);
+	const float32x4_t axial_max = vsetq_lane_f32(INFINITY, vmaxq_f32(t0, t1), 3);
+
+	const float min = vmaxvq_f32(axial_min);
+	const float max = vminvq_f32(axial_max);
+
+#if INFINITE_RAY
+	return 0.f < min && min < max;
+#else
+	return 0.f < min && min < max && min < ray.dist;
+#endif
+}
+
+#else
+inline float intersect(
+	const BBox& bbox,
+	const Ray& ray,
+	Hit& hit)
+{
+	float axial_min[3];
+	float axial_max[3];
+
+	for (size_t i = 0; i < 3; ++i) {
+		const float t0 = (bbox.min[i] - ray.origin[i]) * ray.rcpdir[i];
+		const float t1 = (bbox.max[i] - ray.origin[i]) * ray.rcpdir[i];
+
+		hit.min_mask[i] = t0 <= t1;
+		axial_min[i] = std::min(t0, t1);
+		axial_max[i] = std::max(t0, t1);
+	}
+
+	hit.a_mask = axial_min[0] >= axial_min[1];
+	hit.b_mask = std::max(axial_min[0], axial_min[1]) >= axial_min[2];
+
+	const float min = std::max(std::max(axial_min[0], axial_min[1]), axial_min[2]);
+	const float max = std::min(std::min(axial_max[0], axial_max[1]), axial_max[2]);
+
+#if INFINITE_RAY
+	return 0.f < min && min < max ? min : INFINITY;
+#else
+	return 0.f < min && min < max && min < ray.dist ? min : INFINITY;
+#endif
+}
+
+inline bool occluded(
+	const BBox& bbox,
+	const Ray& ray)
+{
+	float min = -INFINITY;
+	float max = INFINITY;
+
+	for (size_t i = 0; i < 3; ++i) {
+		const float t0 = (bbox.min[i] - ray.origin[i]) * ray.rcpdir[i];
+		const float t1 = (bbox.max[i] - ray.origin[i]) * ray.rcpdir[i];
+
+		min = std::max(min, std::min(t0, t1));
+		max = std::min(max, std::max(t0, t1));
+	}
+
+#if INFINITE_RAY
+	return 0.f < min && min < max;
+#else
+	return 0.f < min && min < max && min < ray.dist;
+#endif
+}
+
+#endif
+
+// get bbox of child i of the given octet bbox
+inline BBox get_child_bbox(
+	const BBox& bbox,
+	const uint32_t i)
+{
+	const float3 mid = (bbox.min + bbox.max) * .5f;
+
+	return BBox{
+		float3(i & 1 ? mid.x : bbox.min.x, i & 2 ? mid.y : bbox.min.y, i & 4 ? mid.z : bbox.min.z),
+		float3(i & 1 ? bbox.max.x : mid.x, i & 2 ? bbox.max.y : mid.y, i & 4 ? bbox.max.z : mid.z)
+	};
+}
+
+#if CPUPRIM_AVX2 || CPUPRIM_AVX512 || CPUPRIM_NEON
+// slab distances of the 8 children of the given octet bbox, from the min, mid and max planes of the octet per
+// axis, children taking theirs by their index bits; same arithmetic as of get_child_bbox
+inline void child_planes(
+	const BBox& bbox,
+	const Ray& ray,
+	float (& plane)[3][3])
+{
+	const float3 mid = (bbox.min + bbox.max) * .5f;
+
+	for (size_t j = 0; j < 3; ++j) {
+		plane[j][0] = (bbox.min[j] - ray.origin[j]) * ray.rcpdir[j];
+		plane[j][1] = (mid[j] - ray.origin[j]) * ray.rcpdir[j];
+		plane[j][2] = (bbox.max[j] - ray.origin[j]) * ray.rcpdir[j];
+	}
+}
+
+#endif
+#if CPUPRIM_AVX2 || CPUPRIM_AVX512
+// intersect the 8 children of the given octet bbox; return mask of hit children, and their exit distances in t
+inline uint32_t intersect8(
+	const BBox& bbox,
+	const Ray& ray,
+	float (& t)[8])
+{
+	float p[3][3];
+	child_planes(bbox, ray, p);
+
+	// children of the upper halves along x, y and z are in lanes of bits 0, 1 and 2 set
+	const __m256 x0 = _mm256_blend_ps(_mm256_set1_ps(p[0][0]), _mm256_set1_ps(p[0][1]), 0xaa);
+	const __m256 x1 = _mm256_blend_ps(_mm256_set1_ps(p[0][1]), _mm256_set1_ps(p[0][2]), 0xaa);
+	const __m256 y0 = _mm256_blend_ps(_mm256_set1_ps(p[1][0]), _mm256_set1_ps(p[1][1]), 0xcc);
+	const __m256 y1 = _mm256_blend_ps(_mm256_set1_ps(p[1][1]), _mm256_set1_ps(p[1][2]), 0xcc);
+	const __m256 z0 = _mm256_blend_ps(_mm256_set1_ps(p[2][0]), _mm256_set1_ps(p[2][1]), 0xf0);
+	const __m256 z1 = _mm256_blend_ps(_mm256_set1_ps(p[2][1]), _mm256_set1_ps(p[2][2]), 0xf0);
+
+	const __m256 min = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(x0, x1), _mm256_min_ps(y0, y1)), _mm256_min_ps(z0, z1));
+	const __m256 max = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(x0, x1), _mm256_max_ps(y0, y1)), _mm256_max_ps(z0, z1));
+	_mm256_storeu_ps(t, max);
+
+	__m256 msk = _mm256_and_ps(_mm256_cmp_ps(min, max, _CMP_LT_OQ), _mm256_cmp_ps(_mm256_setzero_ps(), max, _CMP_LT_OQ));
+#if INFINITE_RAY == 0
+	msk = _mm256_and_ps(msk, _mm256_cmp_ps(min, _mm256_set1_ps(ray.dist), _CMP_LT_OQ));
+#endif
+	return _mm256_movemask_ps(msk);
+}
+
+#elif CPUPRIM_NEON
+// intersect the 8 children of the given octet bbox; return mask of hit children, and their exit distances in t
+inline uint32_t intersect8(
+	const BBox& bbox,
+	const Ray& ray,
+	float (& t)[8])
+{
+	float p[3][3];
+	child_planes(bbox, ray, p);
+
+	// children 0-3 and 4-7 in the low and high halves, of the low and high z
+	const float x0_[4] = { p[0][0], p[0][1], p[0][0], p[0][1] };
+	const float x1_[4] = { p[0][1], p[0][2], p[0][1], p[0][2] };
+	const float y0_[4] = { p[1][0], p[1][0], p[1][1], p[1][1] };
+	const float y1_[4] = { p[1][1], p[1][1], p[1][2], p[1][2] };
+	const float32x4_t x_min = vminq_f32(vld1q_f32(x0_), vld1q_f32(x1_));
+	const float32x4_t x_max = vmaxq_f32(vld1q_f32(x0_), vld1q_f32(x1_));
+	const float32x4_t y_min = vminq_f32(vld1q_f32(y0_), vld1q_f32(y1_));
+	const float32x4_t y_max = vmaxq_f32(vld1q_f32(y0_), vld1q_f32(y1_));
+	const float32x4_t xy_min = vmaxq_f32(x_min, y_min);
+	const float32x4_t xy_max = vminq_f32(x_max, y_max);
+
+	const uint32_t bit_[4] = { 1, 2, 4, 8 };
+	const uint32x4_t bit = vld1q_u32(bit_);
+	uint32_t mask = 0;
+
+	for (size_t k = 0; k < 2; ++k) {
+		const float32x4_t min = vmaxq_f32(xy_min, vdupq_n_f32(std::min(p[2][k], p[2][k + 1])));
+		const float32x4_t max = vminq_f32(xy_max, vdupq_n_f32(std::max(p[2][k], p[2][k + 1])));
+		vst1q_f32(t + k * 4, max);
+
+		uint32x4_t msk = vandq_u32(vcltq_f32(min, max), vcltq_f32(vdupq_n_f32(0.f), max));
+#if INFINITE_RAY == 0
+		msk = vandq_u32(msk, vcltq_f32(min, vdupq_n_f32(ray.dist)));
+#endif
+		mask |= vaddvq_u32(vandq_u32(msk, bit)) << k * 4;
+	}
+
+	return mask;
+}
+
+#else
+// intersect the 8 children of the given octet bbox; return mask of hit children, and their exit distances in t
+inline uint32_t intersect8(
+	const BBox& bbox,
+	const Ray& ray,
+	float (& t)[8])
+{
+	uint32_t mask = 0;
+
+	for (uint32_t i = 0; i < 8; ++i) {
+		const BBox child = get_child_bbox(bbox, i);
+		float min = -INFINITY;
+		float max = INFINITY;
+
+		for (size_t j = 0; j < 3; ++j) {
+			const float t0 = (child.min[j] - ray.origin[j]) * ray.rcpdir[j];
+			const float t1 = (child.max[j] - ray.origin[j]) * ray.rcpdir[j];
+
+			min = std::max(min, std::min(t0, t1));
+			max = std::min(max, std::max(t0, t1));
+		}
+
+		t[i] = max;
+#if INFINITE_RAY
+		mask |= uint32_t(min < max && 0.f < max) << i;
+#else
+		mask |= uint32_t(min < max && 0.f < max && min < ray.dist) << i;
+#endif
+	}
+
+	return mask;
+}
+
+#endif
+#if CPUPRIM_AVX512
+const bool leaf_pairs = true;
+
+// broadcast a to the lower 8 lanes, b to the upper 8
+inline __m512 bcast2(
+	const float a,
+	const float b)
+{
+	return _mm512_mask_blend_ps(0xff00, _mm512_set1_ps(a), _mm512_set1_ps(b));
+}
+
+// intersect8 of 2 octets at once, a and b; return their masks in mask
+inline void intersect8x2(
+	const BBox& bbox_a,
+	const BBox& bbox_b,
+	const Ray& ray,
+	float (& t_a)[8],
+	float (& t_b)[8],
+	uint32_t (& mask)[2])
+{
+	float a[3][3];
+	float b[3][3];
+	child_planes(bbox_a, ray, a);
+	child_planes(bbox_b, ray, b);
+
+	// a in the lower 8 lanes, b in the upper 8; children of the upper halves along x, y and z are in lanes of bits 0,
+	// 1 and 2 set
+	const __m512 x0 = _mm512_mask_blend_ps(0xaaaa, bcast2(a[0][0], b[0][0]), bcast2(a[0][1], b[0][1]));
+	const __m512 x1 = _mm512_mask_blend_ps(0xaaaa, bcast2(a[0][1], b[0][1]), bcast2(a[0][2], b[0][2]));
+	const __m512 y0 = _mm512_mask_blend_ps(0xcccc, bcast2(a[1][0], b[1][0]), bcast2(a[1][1], b[1][1]));
+	const __m512 y1 = _mm512_mask_blend_ps(0xcccc, bcast2(a[1][1], b[1][1]), bcast2(a[1][2], b[1][2]));
+	const __m512 z0 = _mm512_mask_blend_ps(0xf0f0, bcast2(a[2][0], b[2][0]), bcast2(a[2][1], b[2][1]));
+	const __m512 z1 = _mm512_mask_blend_ps(0xf0f0, bcast2(a[2][1], b[2][1]), bcast2(a[2][2], b[2][2]));
+
+	const __m512 min = _mm512_max_ps(_mm512_max_ps(_mm512_min_ps(x0, x1), _mm512_min_ps(y0, y1)), _mm512_min_ps(z0, z1));
+	const __m512 max = _mm512_min_ps(_mm512_min_ps(_mm512_max_ps(x0, x1), _mm512_max_ps(y0, y1)), _mm512_max_ps(z0, z1));
+	_mm256_storeu_ps(t_a, _mm512_castps512_ps256(max));
+	_mm256_storeu_ps(t_b, _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(max), 1)));
+
+	__mmask16 msk = _mm512_cmp_ps_mask(min, max, _CMP_LT_OQ) & _mm512_cmp_ps_mask(_mm512_setzero_ps(), max, _CMP_LT_OQ);
+#if INFINITE_RAY == 0
+	msk &= _mm512_cmp_ps_mask(min, _mm512_set1_ps(ray.dist), _CMP_LT_OQ);
+#endif
+	mask[0] = msk & 0xff;
+	mask[1] = msk >> 8;
+}
+
+#else
+const bool leaf_pairs = false;
+
+// intersect8 of 2 octets at once, a and b; return their masks in mask
+inline void intersect8x2(
+	const BBox& bbox_a,
+	const BBox& bbox_b,
+	const Ray& ray,
+	float (& t_a)[8],
+	float (& t_b)[8],
+	uint32_t (& mask)[2])
+{
+	mask[0] = intersect8(bbox_a, ray, t_a);
+	mask[1] = intersect8(bbox_b, ray, t_b);
+}
+
+#endif
+
+// closest hit: order the hit children (mask) front to back, by the octant of the ray; return their count
+inline uint32_t order_children_octant(
+	const uint32_t mask,
+	const Ray& ray,
+	uint8_t (& index)[8])
+{
+	const uint32_t octant = uint32_t(ray.rcpdir.x < 0.f) | uint32_t(ray.rcpdir.y < 0.f) << 1 | uint32_t(ray.rcpdir.z < 0.f) << 2;
+	uint32_t count = 0;
+
+	for (uint32_t k = 0; k < 8; ++k)
+		if (mask >> (k ^ octant) & 1)
+			index[count++] = uint8_t(k ^ octant);
+
+	return count;
+}
+
+// closest hit: order the hit children (mask) front to back, by sorting their exit distances; return their count
+inline uint32_t order_children_distance(
+	const uint32_t mask,
+	const float (& t)[8],
+	uint8_t (& index)[8])
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < 8; ++i) {
+		if (0 == (mask >> i & 1))
+			continue;
+
+		uint32_t j = count++;
+
+		for (; j > 0 && t[index[j - 1]] > t[i]; --j)
+			index[j] = index[j - 1];
+
+		index[j] = uint8_t(i);
+	}
+
+	return count;
+}
+
+// closest hit: order the hit children (mask) front to back; return their count
+inline uint32_t order_children(
+	const uint32_t flags,
+	const uint32_t mask,
+	const float (& t)[8],
+	const Ray& ray,
+	uint8_t (& index)[8])
+{
+	if (flags & FLAG_OCTANT_ORDER)
+		return order_children_octant(mask, ray, index);
+
+	return order_children_distance(mask, t, index);
+}
+
+inline uint32_t leaf_occupancy(const Leaf& leaf) {
+	uint32_t mask = 0;
+
+	for (uint32_t i = 0; i < 8; ++i)
+		mask |= uint32_t(0 != leaf.count[i]) << i;
+
+	return mask;
+}
+
+inline uint32_t octet_occupancy(const Octet& octet) {
+	uint32_t mask = 0;
+
+	for (uint32_t i = 0; i < 8; ++i)
+		mask |= uint32_t(uint16_t(-1) != octet.child[i]) << i;
+
+	return mask;
+}
+
+inline uint32_t octet_occupancy(const LinearOctet& octet) {
+	uint32_t mask = 0;
+
+	for (uint32_t i = 0; i < 8; ++i)
+		mask |= uint32_t(-1U != octet.child[i]) << i;
+
+	return mask;
+}
+
+// source buffers
+inline Octet get_octet(
+	const Octet* const octet,
+	const uint32_t idx)
+{
+	return octet[idx];
+}
+
+inline Leaf get_leaf(
+	const Leaf* const leaf,
+	const uint32_t idx)
+{
+	return leaf[idx];
+}
+
+inline Voxel get_voxel(
+	const Voxel* const voxel,
+	const uint32_t idx)
+{
+	return voxel[idx];
+}
+
+// closest hit in the leaf of the given bbox, of the given intersect8 of its children (cells)
+inline uint32_t traverself(
+	const Leaf& leaf,
+	const Voxel* const voxel,
+	const BBox& bbox,
+	const uint32_t cell_mask,
+	const float (& distance)[8],
+	const uint32_t flags,
+	Ray& ray,
+	Hit& hit,
+	Mailbox& mailbox,
+	Tally& tally)
+{
+	const bool mailboxing = flags & FLAG_MAILBOX;
+	uint8_t index[8];
+
+	const uint32_t hit_count = order_children(flags, cell_mask & leaf_occupancy(leaf), distance, ray, index);
+
+	for (uint32_t i = 0; i < hit_count; ++i) {
+		const uint32_t payload_start = leaf.start[index[i]];
+		const uint32_t payload_count = leaf.count[index[i]];
+		const BBox cell_bbox = get_child_bbox(bbox, index[i]);
+		float nearest_dist = distance[index[i]];
+
+		uint32_t voxel_id = -1U;
+		Hit maybe_hit;
+
+		for (uint32_t j = payload_start; j < payload_start + payload_count; ++j) {
+			const Voxel payload = get_voxel(voxel, j);
+			const uint32_t id = payload.min_cookie;
+			const uint32_t slot = Mailbox::slot(id);
+			float dist;
+
+			if (mailboxing && mailbox.id[slot] == id) {
+				dist = mailbox.dist[slot];
+				maybe_hit = mailbox.hit[slot];
+				tally.skip_count++;
+			}
+			else {
+				const BBox payload_bbox = {
+					float3(payload.min[0], payload.min[1], payload.min[2]),
+					float3(payload.max[0], payload.max[1], payload.max[2])
+				};
+				dist = intersect(payload_bbox, ray, maybe_hit);
+				tally.test_count++;
+
+				if (mailboxing && !contains(cell_bbox, payload)) {
+					mailbox.id[slot] = id;
+					mailbox.dist[slot] = dist;
+					mailbox.hit[slot] = maybe_hit;
+				}
+			}
+
+			if (id != ray.prior_id && dist < nearest_dist) {
+				nearest_dist = dist;
+				voxel_id = id;
+				hit = maybe_hit;
+			}
+		}
+
+		if (-1U != voxel_id) {
+			ray.dist = nearest_dist;
+			return voxel_id;
+		}
+	}
+	return -1U;
+}
+
+// any hit in the leaf of the given bbox, of the given intersect8 of its children (cells)
+inline bool occludelf(
+	const Leaf& leaf,
+	const Voxel* const voxel,
+	const BBox& bbox,
+	const uint32_t cell_mask,
+	const uint32_t flags,
+	const Ray& ray,
+	Mailbox& mailbox,
+	Tally& tally)
+{
+	const bool mailboxing = flags & FLAG_MAILBOX;
+
+	for (uint32_t mask = cell_mask & leaf_occupancy(leaf); mask; mask &= mask - 1) {
+		const uint32_t i = __builtin_ctz(mask);
+		const uint32_t payload_start = leaf.start[i];
+		const uint32_t payload_count = leaf.count[i];
+		const BBox cell_bbox = get_child_bbox(bbox, i);
+
+		for (uint32_t j = payload_start; j < payload_start + payload_count; ++j) {
+			const Voxel payload = get_voxel(voxel, j);
+			const uint32_t id = payload.min_cookie;
+			const uint32_t slot = Mailbox::slot(id);
+
+			if (mailboxing && mailbox.id[slot] == id) {
+				tally.skip_count++;
+				continue;
+			}
+
+			const BBox payload_bbox = {
+				float3(payload.min[0], payload.min[1], payload.min[2]),
+				float3(payload.max[0], payload.max[1], payload.max[2])
+			};
+			tally.test_count++;
+
+			if (id != ray.prior_id && occluded(payload_bbox, ray))
+				return true;
+
+			if (mailboxing && !contains(cell_bbox, payload))
+				mailbox.id[slot] = id;
+		}
+	}
+	return false;
+}
+
+// tree layouts of traverse and occlude: where the root octet, the leaves, and the payload of a leaf are
+struct ImageLayout { // that of the source buffers: octet, leaf and voxel maps apart
+	typedef Octet Root;
+
+	const Octet* octet;
+	const Leaf* leaf;
+	const Voxel* voxel;
+
+	Octet get_root() const {
+		return get_octet(octet, 0);
+	}
+
+	Leaf get_child(const uint32_t child) const {
+		return get_leaf(leaf, child);
+	}
+
+	const Voxel* get_payload(const uint32_t) const {
+		return voxel;
+	}
+};
+
+struct LinearLayout { // that of the linearized tree, see Line
+	typedef LinearOctet Root;
+
+	const Line* line;
+
+	LinearOctet get_root() const {
+		return *reinterpret_cast< const LinearOctet* >(line);
+	}
+
+	Leaf get_child(const uint32_t child) const {
+		return *reinterpret_cast< const Leaf* >(line + child);
+	}
+
+	const Voxel* get_payload(const uint32_t child) const {
+		return reinterpret_cast< const Voxel* >(line + child);
+	}
+};
+
+inline float dot(const float3 a, const float3 b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline float3 cross(const float3 a, const float3 b) {
+	return float3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+// frustum of the rays from the given origin through the given corner directions, in winding order
+inline Frustum get_frustum(
+	const float3 origin,
+	const float3 (& corner)[4])
+{
+	const float3 axis = corner[0] + corner[1] + corner[2] + corner[3];
+	Frustum frustum;
+	frustum.origin = origin;
+
+	for (uint32_t i = 0; i < 4; ++i) {
+		const float3 normal = cross(corner[i], corner[(i + 1) & 3]);
+		frustum.normal[i] = dot(normal, axis) < 0.f ? normal * -1.f : normal;
+	}
+
+	return frustum;
+}
+
+// does the frustum meet the bbox; conservative: a bbox outside the frustum but near its edges may pass
+inline bool meets(
+	const Frustum& frustum,
+	const BBox& bbox)
+{
+	for (uint32_t i = 0; i < 4; ++i) {
+		const float3 normal = frustum.normal[i];
+		const float3 farthest(
+			normal.x < 0.f ? bbox.min.x : bbox.max.x,
+			normal.y < 0.f ? bbox.min.y : bbox.max.y,
+			normal.z < 0.f ? bbox.min.z : bbox.max.z);
+
+		if (dot(normal, farthest - frustum.origin) < 0.f)
+			return false;
+	}
+	return true;
+}
+
+// candidates of the given frustum: occupied children of the root octet, and occupied cells of their leaves, that
+// the frustum meets; a child of no such cells is no candidate
+template < typename Layout >
+inline Candidates get_candidates(
+	const Source& src,
+	const Layout& layout,
+	const Frustum& frustum)
+{
+	const typename Layout::Root octet = layout.get_root();
+	Candidates candidates = { 0, { 0, 0, 0, 0, 0, 0, 0, 0 } };
+
+	for (uint32_t mask = octet_occupancy(octet); mask; mask &= mask - 1) {
+		const uint32_t i = __builtin_ctz(mask);
+		const BBox child_bbox = get_child_bbox(src.root_bbox, i);
+
+		if (!meets(frustum, child_bbox))
+			continue;
+
+		uint32_t cell_mask = 0;
+
+		for (uint32_t cells = leaf_occupancy(layout.get_child(octet.child[i])); cells; cells &= cells - 1) {
+			const uint32_t j = __builtin_ctz(cells);
+
+			if (meets(frustum, get_child_bbox(child_bbox, j)))
+				cell_mask |= 1U << j;
+		}
+
+		candidates.cell_mask[i] = uint8_t(cell_mask);
+		candidates.child_mask |= uint32_t(0 != cell_mask) << i;
+	}
+
+	return candidates;
+}
+
+// closest hit among the given candidates; a single candidate child is entered without the test of the root octet
+// children, as the cell tests of its leaf tell the ray misses
+template < typename Layout >
+inline uint32_t traverse(
+	const Source& src,
+	const Layout& layout,
+	const Candidates& candidates,
+	Ray& ray,
+	Hit& hit)
+{
+	const typename Layout::Root octet = layout.get_root();
+	float distance[8];
+	uint8_t index[8];
+	Mailbox mailbox;
+	uint32_t hit_count;
+
+	if (1 == __builtin_popcount(candidates.child_mask)) {
+		index[0] = uint8_t(__builtin_ctz(candidates.child_mask));
+		hit_count = 1;
+	}
+	else {
+		const uint32_t mask = intersect8(src.root_bbox, ray, distance) & octet_occupancy(octet) & candidates.child_mask;
+		hit_count = order_children(src.flags, mask, distance, ray, index);
+		src.tally->node_count++;
+	}
+
+	// cell tests of the leaves, of 2 leaves in order at once where leaf_pairs; exact as the ray is not shortened
+	// but by a hit, which ends the traversal
+	float cell_distance[2][8];
+	uint32_t cell_mask[2];
+
+	for (uint32_t i = 0; i < hit_count; ++i) {
+		const uint32_t child = octet.child[index[i]];
+		const BBox child_bbox = get_child_bbox(src.root_bbox, index[i]);
+		const uint32_t pair = leaf_pairs ? i & 1 : 0;
+
+		if (0 == pair) {
+			if (leaf_pairs && i + 1 < hit_count) {
+				intersect8x2(child_bbox, get_child_bbox(src.root_bbox, index[i + 1]), ray, cell_distance[0], cell_distance[1], cell_mask);
+				src.tally->node_count += 2;
+			}
+			else {
+				cell_mask[0] = intersect8(child_bbox, ray, cell_distance[0]);
+				src.tally->node_count++;
+			}
+		}
+
+		const uint32_t hitId = traverself(layout.get_child(child), layout.get_payload(child), child_bbox, cell_mask[pair] & candidates.cell_mask[index[i]],
+			cell_distance[pair], src.flags, ray, hit, mailbox, *src.tally);
+
+		if (-1U != hitId)
+			return hitId;
+	}
+	return -1U;
+}
+
+template < typename Layout >
+inline uint32_t traverse(
+	const Source& src,
+	const Layout& layout,
+	Ray& ray,
+	Hit& hit)
+{
+	return traverse(src, layout, Candidates::all(), ray, hit);
+}
+
+inline uint32_t traverse(
+	const Source& src,
+	Ray& ray,
+	Hit& hit)
+{
+	return traverse(src, ImageLayout{ src.octet, src.leaf, src.voxel }, ray, hit);
+}
+
+template < typename Layout >
+inline bool occlude(
+	const Source& src,
+	const Layout& layout,
+	const Ray& ray)
+{
+	const typename Layout::Root octet = layout.get_root();
+	float distance[8];
+	Mailbox mailbox;
+
+	// cell tests of the leaves, of 2 leaves at once where leaf_pairs
+	float cell_distance[2][8];
+	uint32_t cell_mask[2];
+	uint32_t pair = 0;
+
+	src.tally->node_count++;
+
+	for (uint32_t mask = intersect8(src.root_bbox, ray, distance) & octet_occupancy(octet); mask; mask &= mask - 1, pair ^= leaf_pairs) {
+		const uint32_t i = __builtin_ctz(mask);
+		const uint32_t child = octet.child[i];
+		const BBox child_bbox = get_child_bbox(src.root_bbox, i);
+
+		if (0 == pair) {
+			const uint32_t next = mask & (mask - 1);
+
+			if (leaf_pairs && next) {
+				intersect8x2(child_bbox, get_child_bbox(src.root_bbox, __builtin_ctz(next)), ray, cell_distance[0], cell_distance[1], cell_mask);
+				src.tally->node_count += 2;
+			}
+			else {
+				cell_mask[0] = intersect8(child_bbox, ray, cell_distance[0]);
+				src.tally->node_count++;
+			}
+		}
+
+		if (occludelf(layout.get_child(child), layout.get_payload(child), child_bbox, cell_mask[pair], src.flags, ray, mailbox, *src.tally))
+			return true;
+	}
+	return false;
+}
+
+inline bool occlude(
+	const Source& src,
+	const Ray& ray)
+{
+	return occlude(src, ImageLayout{ src.octet, src.leaf, src.voxel }, ray);
+}
+
+// heightfield map: see struct Heightfield in param.cpp
+inline uint32_t hf_traverse(
+	const uint32_t* const hf,
+	Ray& ray,
+	Hit& hit)
+{
+	const float origin[2] = { as_float(hf[0]), as_float(hf[1]) };
+	const float cell = as_float(hf[2]);
+	const uint32_t levels = hf[3];
+	const uint32_t dim[2] = { hf[4], hf[5] };
+	const float top = as_float(hf[6]);
+	const float* const height = reinterpret_cast< const float* >(hf + 16);
+
+	// ray in grid space: xy in cells, z as in world; distances along the ray remain as in world
+	const float o[3] = { (ray.origin.x - origin[0]) / cell, (ray.origin.y - origin[1]) / cell, ray.origin.z };
+	const float rcpdir[3] = { ray.rcpdir.x * cell, ray.rcpdir.y * cell, ray.rcpdir.z };
+	const float dir[3] = { 1.f / rcpdir[0], 1.f / rcpdir[1], 1.f / rcpdir[2] };
+	const bool neg[2] = { rcpdir[0] < 0.f, rcpdir[1] < 0.f };
+	const int32_t step[2] = { neg[0] ? -1 : 1, neg[1] ? -1 : 1 };
+
+	// clip ray to grid bbox; past that z stays within [0, top]
+	const float bound[3] = { float(dim[0]), float(dim[1]), top };
+	float axial_min[3];
+	float axial_max[3];
+
+	for (size_t i = 0; i < 3; ++i) {
+		const float t0 = (0.f - o[i]) * rcpdir[i];
+		const float t1 = (bound[i] - o[i]) * rcpdir[i];
+
+		axial_min[i] = std::min(t0, t1);
+		axial_max[i] = std::max(t0, t1);
+	}
+
+	float t = std::max(std::max(std::max(axial_min[0], axial_min[1]), axial_min[2]), 0.f);
+#if INFINITE_RAY
+	const float t_leave = std::min(std::min(axial_max[0], axial_max[1]), axial_max[2]);
+#else
+	const float t_leave = std::min(std::min(std::min(axial_max[0], axial_max[1]), axial_max[2]), ray.dist);
+#endif
+
+	// axis of entry into the current cell: 0 - x, 1 - y, 2 - z
+	uint32_t axis = axial_min[0] >= axial_min[1] ? (axial_min[0] >= axial_min[2] ? 0 : 2) : (axial_min[1] >= axial_min[2] ? 1 : 2);
+
+	// start at the top level, whose single cell covers the grid
+	uint32_t level = levels - 1;
+	int32_t c[2] = { 0, 0 };
+
+	for (uint32_t i = 0; i < 256 && t < t_leave; ++i) {
+		const uint32_t dim_l[2] = { (dim[0] + (1U << level) - 1) >> level, (dim[1] + (1U << level) - 1) >> level };
+
+		if (c[0] < 0 || c[1] < 0 || c[0] >= int32_t(dim_l[0]) || c[1] >= int32_t(dim_l[1]))
+			break;
+
+		const float h = height[hf[8 + level] + c[1] * dim_l[0] + c[0]];
+		const float t_xy[2] = {
+			(float((c[0] + int32_t(!neg[0])) << level) - o[0]) * rcpdir[0],
+			(float((c[1] + int32_t(!neg[1])) << level) - o[1]) * rcpdir[1]
+		};
+		const float t_exit = std::min(std::min(t_xy[0], t_xy[1]), t_leave);
+		const float z_min = std::min(o[2] + dir[2] * t, o[2] + dir[2] * t_exit);
+
+		if (z_min <= h) {
+			if (level) {
+				// descend into the child cell the ray is in at t
+				const float scale = 1.f / (1U << (level - 1));
+
+				for (size_t k = 0; k < 2; ++k) {
+					const float p = (o[k] + dir[k] * t) * scale;
+					const int32_t child = int32_t(neg[k] ? std::ceil(p) - 1.f : std::floor(p));
+
+					c[k] = std::min(std::max(child, c[k] * 2), c[k] * 2 + 1);
+				}
+
+				--level;
+				continue;
+			}
+
+			// entering the column from its side, or through its top
+			const float z = o[2] + dir[2] * t;
+			const float t_hit = z <= h ? t : (h - o[2]) * rcpdir[2];
+			const uint32_t id = c[1] * dim[0] + c[0];
+
+			if (id != ray.prior_id && t_hit > 0.f) {
+				for (size_t k = 0; k < 3; ++k)
+					hit.min_mask[k] = 0.f <= ray.rcpdir[k];
+
+				hit.a_mask = z <= h && axis == 0;
+				hit.b_mask = z <= h && axis != 2;
+				ray.dist = t_hit;
+				return id;
+			}
+		}
+
+		// step to the next cell at this level, then continue from its parent
+		axis = t_xy[0] <= t_xy[1] ? 0 : 1;
+		c[axis] += step[axis];
+		t = std::max(t, t_exit);
+
+		if (level < levels - 1) {
+			c[0] >>= 1;
+			c[1] >>= 1;
+			++level;
+		}
+	}
+	return -1U;
+}
+
+inline bool hf_occlude(
+	const uint32_t* const hf,
+	const Ray& ray)
+{
+	Ray occl_ray = ray;
+	Hit hit;
+
+	return -1U != hf_traverse(hf, occl_ray, hit);
+}
+
+inline uint32_t traverse_scene(
+	const Source& src,
+	const Candidates& candidates,
+	Ray& ray,
+	Hit& hit)
+{
+	if (src.height[3])
+		return hf_traverse(src.height, ray, hit);
+
+	return traverse(src, ImageLayout{ src.octet, src.leaf, src.voxel }, candidates, ray, hit);
+}
+
+inline bool occlude_scene(
+	const Source& src,
+	const Ray& ray)
+{
+	if (src.height[3])
+		return hf_occlude(src.height, ray);
+
+	return occlude(src, ray);
+}
+
+// see George Marsaglia http://www.jstatsoft.org/v08/i14/paper
+inline uint32_t xorshift(uint32_t value) {
+	value ^= value << 13;
+	value ^= value >> 17;
+	value ^= value << 5;
+	return value;
+}
+
+// sample the AO hemisphere of a pixel: decl (cos^2) in r0, azim in r1
+inline void sample_ao(
+	const Source& src,
+	const float (& sampler)[4],
+	const uint32_t x,
+	const uint32_t y,
+	const uint32_t dimx,
+	const uint32_t dimy,
+	const uint32_t frame,
+	float& r0,
+	float& r1)
+{
+	if (as_uint(sampler[3])) {
+		const uint16_t (& value)[2] = src.noise[(y & 63) * 64 + (x & 63)];
+
+		r0 = fract(value[0] * (1.f / 65536) + sampler[0]);
+		r1 = fract(value[1] * (1.f / 65536) + sampler[1]) * (2.f * pi);
+		return;
+	}
+
+	const uint32_t seed = x + y * dimx + frame * dimy * dimx;
+	const uint32_t ri0 = xorshift(seed) * 0xa47f >> 8;
+	const uint32_t ri1 = xorshift(seed) * 0xa175 >> 8;
+	const uint32_t max_rand = (1U << 24) - 1;
+
+	r0 = ri0 * (1.f / max_rand);
+	r1 = ri1 * (pi / (1U << 23));
+}
+
+// get the AO ray direction of a hit, from its hemisphere sample: decl (cos^2) in r0, azim in r1
+inline float3 ao_direction(
+	const Hit& hit,
+	const float r0,
+	const float r1)
+{
+	// cosine-weighted distribution
+	const float sin_decl = std::sqrt(1.f - r0);
+	const float cos_decl = std::sqrt(r0);
+	const float sin_azim = std::sin(r1);
+	const float cos_azim = std::cos(r1);
+
+	// compute a bounce vector in some TBN space, in this case of an assumed normal along x-axis
+	const float3 hemi(cos_decl, cos_azim * sin_decl, sin_azim * sin_decl);
+
+	const float3 normal = hit.b_mask ? (hit.a_mask ? hemi : float3(hemi.z, hemi.x, hemi.y)) : float3(hemi.y, hemi.z, hemi.x);
+
+	return float3(
+		hit.min_mask[0] ? -normal.x : normal.x,
+		hit.min_mask[1] ? -normal.y : normal.y,
+		hit.min_mask[2] ? -normal.z : normal.z);
+}
+
+inline uint32_t shade(
+	const Source& src,
+	const float3 hit_origin,
+	const uint32_t hit_id,
+	const Hit& hit,
+	const float r0,
+	const float r1)
+{
+	const Ray ray = { hit_origin, hit_id, rcp(ao_direction(hit, r0, r1)), FLT_MAX };
+	src.tally->ray_count++;
+	return occlude_scene(src, ray) ? 16 : 255;
+}
+
+// texel of the AO cache of a primary hit of the given voxel, at the given hit position; null if the voxel has no record
+inline std::atomic< uint32_t >* get_texel(
+	cpukernel_aocache& cache,
+	const uint32_t hit_id,
+	const float3 hit_origin,
+	const Hit& hit)
+{
+	cpukernel_aocache::Record& record = cache.record[hit_id & (cache.capacity - 1)];
+
+	if (record.cookie != hit_id)
+		return nullptr;
+
+	// face of the hit, as of the normal of ao_direction
+	const uint32_t axis = hit.b_mask ? (hit.a_mask ? 0 : 1) : 2;
+	const uint32_t face = axis * 2 + !hit.min_mask[axis];
+	uint32_t coord[2];
+
+	for (uint32_t i = 0; i < 2; ++i) {
+		const uint32_t k = (axis + 1 + i) % 3;
+		const float t = (hit_origin[k] - record.min[k]) / (record.max[k] - record.min[k]) * cpukernel_aocache::texel_side;
+
+		// NaN of a flat voxel goes to texel 0
+		coord[i] = t > 0.f ? uint32_t(std::min(t, cpukernel_aocache::texel_side - 1.f)) : 0;
+	}
+
+	return &record.texel[face][coord[1] * cpukernel_aocache::texel_side + coord[0]];
+}
+
+// output luma of the mean of the samples of a texel
+inline uint32_t texel_luma(const uint32_t counts) {
+	const uint32_t samples = counts & 0xffff;
+	const uint32_t open = counts >> 16;
+
+	return 16 + (239 * open + samples / 2) / samples;
+}
+
+// shade a primary hit through the AO cache: a hit of a texel of enough samples shades from the texel, and only its
+// refresh share is traced; samples traced go to the texel; hits of voxels of no record are traced as by shade
+inline uint32_t shade_cached(
+	const Source& src,
+	cpukernel_aocache& cache,
+	const float3 hit_origin,
+	const uint32_t hit_id,
+	const Hit& hit,
+	const uint32_t seed,
+	const float r0,
+	const float r1,
+	uint64_t& ao_cache_count)
+{
+	std::atomic< uint32_t >* const texel = get_texel(cache, hit_id, hit_origin, hit);
+
+	if (nullptr == texel)
+		return shade(src, hit_origin, hit_id, hit, r0, r1);
+
+	uint32_t counts = texel->load(std::memory_order_relaxed);
+
+	if ((counts & 0xffff) >= cpukernel_aocache::min_samples && (xorshift(seed * 0x9e3779b9U + 1) >> 8) >= cache.refresh) {
+		ao_cache_count++;
+		return texel_luma(counts);
+	}
+
+	const uint32_t result = shade(src, hit_origin, hit_id, hit, r0, r1);
+	const uint32_t sample = 1 | uint32_t(255 == result) << 16;
+	uint32_t next;
+
+	do {
+		next = counts + sample;
+
+		// halve both counts; the lo bit of the hi count shifted into the lo count is masked off
+		if ((next & 0xffff) > cpukernel_aocache::max_samples)
+			next = next >> 1 & 0x7fff7fff;
+	}
+	while (!texel->compare_exchange_weak(counts, next, std::memory_order_relaxed));
+
+	return (next & 0xffff) >= cpukernel_aocache::min_samples ? texel_luma(next) : result;
+}
+
+// pixels [first, last) of a frame dimension of the given count whose primary rays fall within [min, max] of the
+// screen coords, with a pixel of margin for rounding; none if max < min
+inline void pixel_span(
+	const float min,
+	const float max,
+	const uint32_t count,
+	uint32_t& first,
+	uint32_t& last)
+{
+	if (max < min) {
+		first = last = 0;
+		return;
+	}
+
+	last = uint32_t(std::min(std::max(std::ceil((max + 1.f) * .5f * count) + 2.f, 0.f), float(count)));
+	first = std::min(uint32_t(std::max(std::floor((min + 1.f) * .5f * count) - 1.f, 0.f)), last);
+}
+
+// direction of the primary ray of the given pixel; pixels off the frame make those of the frustums of tiles
+inline float3 primary_direction(
+	const float3 (& cam)[3],
+	const int32_t x,
+	const int32_t y,
+	const uint32_t dimx,
+	const uint32_t dimy)
+{
+	return
+		cam[0] * ((x * 2 - int32_t(dimx)) * (1.f / dimx)) +
+		cam[1] * ((y * 2 - int32_t(dimy)) * (1.f / dimy)) +
+		cam[2];
+}
+
+// render rows as cpukernel does, in tiles of the rows by tile_w columns, through the AO cache, if any; add the counts
+// of the rows to stats
+inline void render_rows(
+	const content_frame_arg* const arg,
+	uint8_t* const dst,
+	const uint32_t dimx,
+	const uint32_t dimy,
+	const uint32_t row_start,
+	const uint32_t row_end,
+	const uint32_t tile_w,
+	cpukernel_aocache* const cache,
+	cpukernel_stats& stats)
+{
+	const float (* const carb)[4] = reinterpret_cast< const float (*)[4] >(arg->buffer[buffer_carb]);
+
+	const float3 cam[3] = {
+		float3(carb[0][0], carb[0][1], carb[0][2]),
+		float3(carb[1][0], carb[1][1], carb[1][2]),
+		float3(carb[2][0], carb[2][1], carb[2][2])
+	};
+	const float3 ray_origin(carb[3][0], carb[3][1], carb[3][2]);
+	const uint32_t frame = as_uint(carb[5][3]);
+	const float (& sampler)[4] = carb[6];
+	const uint32_t flags = as_uint(carb[6][2]);
+
+	// pixels outside the screen rect of the scene miss it; clear them untraced
+	uint32_t x_first, x_last, y_first, y_last;
+	pixel_span(carb[7][0], carb[7][2], dimx, x_first, x_last);
+	pixel_span(carb[7][1], carb[7][3], dimy, y_first, y_last);
+	uint64_t cull_count = 0;
+	uint64_t tile_cull_count = 0;
+	uint64_t ao_cache_count = 0;
+
+	Tally tally = { 0, 0, 0, 0 };
+
+	const Source src = {
+		reinterpret_cast< const Octet* >(arg->buffer[buffer_octet]),
+		reinterpret_cast< const Leaf* >(arg->buffer[buffer_leaf]),
+		reinterpret_cast< const Voxel* >(arg->buffer[buffer_voxel]),
+		reinterpret_cast< const uint32_t* >(arg->buffer[buffer_height]),
+		reinterpret_cast< const uint16_t (*)[2] >(arg->buffer[buffer_noise]),
+		{
+			float3(carb[4][0], carb[4][1], carb[4][2]),
+			float3(carb[5][0], carb[5][1], carb[5][2])
+		},
+		&tally,
+		flags
+	};
+
+	for (uint32_t y = row_start; y < row_end; ++y) {
+		uint8_t* const row = dst + y * dimx;
+
+		if (y < y_first || y >= y_last) {
+			std::memset(row, 0, dimx);
+			cull_count += dimx;
+			continue;
+		}
+
+		std::memset(row, 0, x_first);
+		std::memset(row + x_last, 0, dimx - x_last);
+		cull_count += dimx - (x_last - x_first);
+	}
+
+	// the rest by tiles, of the candidates of their frustums where tile culling; tiles of no candidates miss the
+	// scene, and are cleared untraced
+	const bool tile_culling = (flags & FLAG_TILE_CULL) && 0 == src.height[3];
+	cpukernel_aocache* const aocache = 0 == src.height[3] ? cache : nullptr;
+	const uint32_t y0 = std::max(row_start, y_first);
+	const uint32_t y1 = std::min(row_end, y_last);
+
+	for (uint32_t x0 = x_first; x0 < x_last && y0 < y1; x0 = (x0 / tile_w + 1) * tile_w) {
+		const uint32_t x1 = std::min((x0 / tile_w + 1) * tile_w, x_last);
+		Candidates candidates = Candidates::all();
+
+		if (tile_culling) {
+			// frustum through the pixels surrounding the tile, for a pixel of margin for rounding
+			const float3 corner[4] = {
+				primary_direction(cam, int32_t(x0) - 1, int32_t(y0) - 1, dimx, dimy),
+				primary_direction(cam, int32_t(x1),     int32_t(y0) - 1, dimx, dimy),
+				primary_direction(cam, int32_t(x1),     int32_t(y1),     dimx, dimy),
+				primary_direction(cam, int32_t(x0) - 1, int32_t(y1),     dimx, dimy)
+			};
+			candidates = get_candidates(src, ImageLayout{ src.octet, src.leaf, src.voxel }, get_frustum(ray_origin, corner));
+
+			if (0 == candidates.child_mask) {
+				for (uint32_t y = y0; y < y1; ++y)
+					std::memset(dst + y * dimx + x0, 0, x1 - x0);
+
+				tile_cull_count += (y1 - y0) * (x1 - x0);
+				continue;
+			}
+		}
+
+		for (uint32_t y = y0; y < y1; ++y)
+			for (uint32_t x = x0; x < x1; ++x) {
+				const float3 ray_direction = primary_direction(cam, int32_t(x), int32_t(y), dimx, dimy);
+
+				Ray ray = { ray_origin, -1U, rcp(ray_direction), FLT_MAX };
+				Hit hit;
+				uint32_t result = traverse_scene(src, candidates, ray, hit);
+				tally.ray_count++;
+
+				if (-1U != result) {
+					float r0, r1;
+					sample_ao(src, sampler, x, y, dimx, dimy, frame, r0, r1);
+
+					if (aocache)
+						result = shade_cached(src, *aocache, ray_origin + ray_direction * ray.dist, result, hit,
+							x + y * dimx + aocache->frame * dimy * dimx, r0, r1, ao_cache_count);
+					else
+						result = shade(src, ray_origin + ray_direction * ray.dist, result, hit, r0, r1);
+				}
+				else
+					result = 0;
+
+				dst[y * dimx + x] = uint8_t(result);
+			}
+	}
+
+	stats.ray_count += tally.ray_count;
+	stats.test_count += tally.test_count;
+	stats.skip_count += tally.skip_count;
+	stats.node_count += tally.node_count;
+	stats.cull_count += cull_count;
+	stats.tile_cull_count += tile_cull_count;
+	stats.ao_cache_count += ao_cache_count;
+}
+
+} // namespace CPUPRIM_NAMESPACE
+} // namespace cpuprim
+
+#endif // cpuprim_H__
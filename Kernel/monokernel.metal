@@ -114,6 +114,9 @@ f32x8 fmax(f32x8 a, f32x8 b)
 
 #define M_PI 3.1415926535897932f
 
+// closest-hit child order: from ray octant (true) vs from sorting by distance (false)
+constant bool child_order_octant [[function_constant(0)]];
+
 // source_prologue
 struct BBox {
 	float3 min;
@@ -150,11 +153,27 @@ struct Voxel {
 	float4 max;
 };
 
-struct ChildIndex {
+// kind of ray query served by a traversal
+enum QueryKind {
+	closest_hit, // nearest hit; children visited front to back
+	any_hit      // first hit found; children visited in any order
+};
+
+// children of a node hit by a ray, in order of visiting
+template < enum QueryKind kind >
+struct ChildIndex;
+
+template <>
+struct ChildIndex< closest_hit > {
 	f32x8 distance;
 	u16x8 index;
 };
 
+template <>
+struct ChildIndex< any_hit > {
+	uint mask; // one bit per hit child
+};
+
 inline float intersect(
 	thread const struct BBox* const bbox,
 	thread const struct Ray* const ray,
@@ -243,29 +262,74 @@ inline void intersect8(
 	*r = msk;
 }
 
-ushort octlf_intersect_wide(
-	thread const struct Leaf octet,
-	thread const struct BBox* const bbox,
+// front-to-back visiting order of the 8 children of an octet, per ray octant (bit 0: -x, bit 1: -y, bit 2: -z);
+// child k of the order in nibble k; as children are of equal size, order is k ^ octant for any ray in the octant
+constant uint octant_order[8] = {
+	0x76543210,
+	0x67452301,
+	0x54761032,
+	0x45670123,
+	0x32107654,
+	0x23016745,
+	0x10325476,
+	0x01234567
+};
+
+// order the children hit by a ray (mask r) for visiting, given their exit distances t; return count of hit children
+template < enum QueryKind kind >
+ushort order_children(
+	f32x8 t,
+	const s16x8 r,
 	thread const struct Ray* const ray,
-	thread struct ChildIndex* const child_index)
-{
-	const float3 par_min = bbox->min;
-	const float3 par_max = bbox->max;
-	const float3 par_mid = (par_min + par_max) * 0.5f;
+	thread struct ChildIndex< kind >* const child_index);
 
-	const f32x8 bbox_min_x = f32x8( par_min.x, par_mid.x, par_min.x, par_mid.x, par_min.x, par_mid.x, par_min.x, par_mid.x );
-	const f32x8 bbox_min_y = f32x8( par_min.yy, par_mid.yy, par_min.yy, par_mid.yy );
-	const f32x8 bbox_min_z = f32x8( par_min.zzzz, par_mid.zzzz );
-	const f32x8 bbox_max_x = f32x8( par_mid.x, par_max.x, par_mid.x, par_max.x, par_mid.x, par_max.x, par_mid.x, par_max.x );
-	const f32x8 bbox_max_y = f32x8( par_mid.yy, par_max.yy, par_mid.yy, par_max.yy );
-	const f32x8 bbox_max_z = f32x8( par_mid.zzzz, par_max.zzzz );
+// closest hit: order hit children front to back
+template <>
+ushort order_children< closest_hit >(
+	f32x8 t,
+	const s16x8 r,
+	thread const struct Ray* const ray,
+	thread struct ChildIndex< closest_hit >* const child_index)
+{
+	if (child_order_octant) {
+		const uint3 neg = uint3(ray->rcpdir.xyz < 0.f);
+		const uint order = octant_order[neg.x | neg.y << 1 | neg.z << 2];
+
+		// compact the order down to the hit children
+		uint hit_order = 0;
+		uint count = 0;
+
+		for (uint i = 0; i < 32; i += 4) {
+			const uint child = order >> i & 7;
+			const uint hit = uint(r[child]) & 1;
+			hit_order |= child << count * 4 & -hit;
+			count += hit;
+		}
 
-	f32x8 t;
-	s16x8 r;
-	intersect8(bbox_min_x, bbox_min_y, bbox_min_z, bbox_max_x, bbox_max_y, bbox_max_z, ray, &t, &r);
-	const s16x8 occupancy = convert_short8(u16x8(0) != octet.count);
-	r &= occupancy;
+		const u16x8 index = u16x8(
+			hit_order       & 7,
+			hit_order >>  4 & 7,
+			hit_order >>  8 & 7,
+			hit_order >> 12 & 7,
+			hit_order >> 16 & 7,
+			hit_order >> 20 & 7,
+			hit_order >> 24 & 7,
+			hit_order >> 28 & 7);
+
+		child_index->distance = f32x8(
+			t[index[0]],
+			t[index[1]],
+			t[index[2]],
+			t[index[3]],
+			t[index[4]],
+			t[index[5]],
+			t[index[6]],
+			t[index[7]]);
+		child_index->index = index;
+		return ushort(count);
+	}
 
+	// sort hit children by distance
 	short count = 0;
 	count -= r[0];
 	count -= r[1];
@@ -343,12 +407,40 @@ ushort octlf_intersect_wide(
 	return ushort(count);
 }
 
-ushort octet_intersect_wide(
-	const struct Octet octet,
+// any hit: order is of no consequence -- collect hit children in a mask
+template <>
+ushort order_children< any_hit >(
+	f32x8,
+	const s16x8 r,
+	thread const struct Ray* const,
+	thread struct ChildIndex< any_hit >* const child_index)
+{
+	const u16x8 bit = u16x8(r) & u16x8(1, 2, 4, 8, 16, 32, 64, 128);
+	const uint mask = (bit[0] | bit[1]) | (bit[2] | bit[3]) | (bit[4] | bit[5]) | (bit[6] | bit[7]);
+
+	child_index->mask = mask;
+	return ushort(popcount(mask));
+}
+
+// get bbox of child i of the given octet bbox
+inline struct BBox get_child_bbox(
+	thread const struct BBox* const bbox,
+	const ushort i)
+{
+	const float3 par_min = bbox->min;
+	const float3 par_max = bbox->max;
+	const float3 par_mid = (par_min + par_max) * 0.5f;
+	const bool3 upper = bool3(i & 1, i & 2, i & 4);
+
+	return (struct BBox){ select(par_min, par_mid, upper), select(par_mid, par_max, upper) };
+}
+
+template < enum QueryKind kind >
+ushort octlf_intersect_wide(
+	thread const struct Leaf octet,
 	thread const struct BBox* const bbox,
 	thread const struct Ray* const ray,
-	thread struct ChildIndex* const child_index,
-	struct BBox child_bbox[8])
+	thread struct ChildIndex< kind >* const child_index)
 {
 	const float3 par_min = bbox->min;
 	const float3 par_max = bbox->max;
@@ -361,96 +453,40 @@ ushort octet_intersect_wide(
 	const f32x8 bbox_max_y = f32x8( par_mid.yy, par_max.yy, par_mid.yy, par_max.yy );
 	const f32x8 bbox_max_z = f32x8( par_mid.zzzz, par_max.zzzz );
 
-	child_bbox[0] = (struct BBox){ float3( bbox_min_x[0], bbox_min_y[0], bbox_min_z[0] ), float3( bbox_max_x[0], bbox_max_y[0], bbox_max_z[0] ) };
-	child_bbox[1] = (struct BBox){ float3( bbox_min_x[1], bbox_min_y[1], bbox_min_z[1] ), float3( bbox_max_x[1], bbox_max_y[1], bbox_max_z[1] ) };
-	child_bbox[2] = (struct BBox){ float3( bbox_min_x[2], bbox_min_y[2], bbox_min_z[2] ), float3( bbox_max_x[2], bbox_max_y[2], bbox_max_z[2] ) };
-	child_bbox[3] = (struct BBox){ float3( bbox_min_x[3], bbox_min_y[3], bbox_min_z[3] ), float3( bbox_max_x[3], bbox_max_y[3], bbox_max_z[3] ) };
-	child_bbox[4] = (struct BBox){ float3( bbox_min_x[4], bbox_min_y[4], bbox_min_z[4] ), float3( bbox_max_x[4], bbox_max_y[4], bbox_max_z[4] ) };
-	child_bbox[5] = (struct BBox){ float3( bbox_min_x[5], bbox_min_y[5], bbox_min_z[5] ), float3( bbox_max_x[5], bbox_max_y[5], bbox_max_z[5] ) };
-	child_bbox[6] = (struct BBox){ float3( bbox_min_x[6], bbox_min_y[6], bbox_min_z[6] ), float3( bbox_max_x[6], bbox_max_y[6], bbox_max_z[6] ) };
-	child_bbox[7] = (struct BBox){ float3( bbox_min_x[7], bbox_min_y[7], bbox_min_z[7] ), float3( bbox_max_x[7], bbox_max_y[7], bbox_max_z[7] ) };
-
 	f32x8 t;
 	s16x8 r;
 	intersect8(bbox_min_x, bbox_min_y, bbox_min_z, bbox_max_x, bbox_max_y, bbox_max_z, ray, &t, &r);
-	const s16x8 occupancy = convert_short8(u16x8(-1) != octet.child);
+	const s16x8 occupancy = convert_short8(u16x8(0) != octet.count);
 	r &= occupancy;
 
-	short count = 0;
-	count -= r[0];
-	count -= r[1];
-	count -= r[2];
-	count -= r[3];
-	count -= r[4];
-	count -= r[5];
-	count -= r[6];
-	count -= r[7];
-
-	t = select(f32x8(INFINITY), t, r);
-
-	const float4 r0_A = float4(t[0], t[3], t[4], t[7]);
-	const float4 r0_B = float4(t[1], t[2], t[5], t[6]);
-	const ushort4 r0x_A = ushort4(0, 3, 4, 7);
-	const ushort4 r0x_B = ushort4(1, 2, 5, 6);
-	const b4 m0 = islessequal(r0_A, r0_B);
-	const float4 r0_min = fmin(r0_A, r0_B);
-	const float4 r0_max = fmax(r0_A, r0_B);
-	const ushort4 r0x_min = select(r0x_B, r0x_A, m0);
-	const ushort4 r0x_max = select(r0x_A, r0x_B, m0);
-
-	const float4 r1_A = float4(r0_min[0], r0_max[0], r0_max[3], r0_min[3]);
-	const float4 r1_B = float4(r0_max[1], r0_min[1], r0_min[2], r0_max[2]);
-	const ushort4 r1x_A = ushort4(r0x_min[0], r0x_max[0], r0x_max[3], r0x_min[3]);
-	const ushort4 r1x_B = ushort4(r0x_max[1], r0x_min[1], r0x_min[2], r0x_max[2]);
-	const b4 m1 = islessequal(r1_A, r1_B);
-	const float4 r1_min = fmin(r1_A, r1_B);
-	const float4 r1_max = fmax(r1_A, r1_B);
-	const ushort4 r1x_min = select(r1x_B, r1x_A, m1);
-	const ushort4 r1x_max = select(r1x_A, r1x_B, m1);
-
-	const float4 r2_A = float4(r1_min[0], r1_max[0], r1_max[3], r1_min[3]);
-	const float4 r2_B = float4(r1_min[1], r1_max[1], r1_max[2], r1_min[2]);
-	const ushort4 r2x_A = ushort4(r1x_min[0], r1x_max[0], r1x_max[3], r1x_min[3]);
-	const ushort4 r2x_B = ushort4(r1x_min[1], r1x_max[1], r1x_max[2], r1x_min[2]);
-	const b4 m2 = islessequal(r2_A, r2_B);
-	const float4 r2_min = fmin(r2_A, r2_B);
-	const float4 r2_max = fmax(r2_A, r2_B);
-	const ushort4 r2x_min = select(r2x_B, r2x_A, m2);
-	const ushort4 r2x_max = select(r2x_A, r2x_B, m2);
+	return order_children< kind >(t, r, ray, child_index);
+}
 
-	const float4 r3_A = float4(r2_min[0], r2_max[0], r2_min[1], r2_max[1]);
-	const float4 r3_B = float4(r2_max[2], r2_min[2], r2_max[3], r2_min[3]);
-	const ushort4 r3x_A = ushort4(r2x_min[0], r2x_max[0], r2x_min[1], r2x_max[1]);
-	const ushort4 r3x_B = ushort4(r2x_max[2], r2x_min[2], r2x_max[3], r2x_min[3]);
-	const b4 m3 = islessequal(r3_A, r3_B);
-	const float4 r3_min = fmin(r3_A, r3_B);
-	const float4 r3_max = fmax(r3_A, r3_B);
-	const ushort4 r3x_min = select(r3x_B, r3x_A, m3);
-	const ushort4 r3x_max = select(r3x_A, r3x_B, m3);
+template < enum QueryKind kind >
+ushort octet_intersect_wide(
+	const struct Octet octet,
+	thread const struct BBox* const bbox,
+	thread const struct Ray* const ray,
+	thread struct ChildIndex< kind >* const child_index)
+{
+	const float3 par_min = bbox->min;
+	const float3 par_max = bbox->max;
+	const float3 par_mid = (par_min + par_max) * 0.5f;
 
-	const float4 r4_A = float4(r3_min[0], r3_min[1], r3_max[0], r3_max[1]);
-	const float4 r4_B = float4(r3_min[2], r3_min[3], r3_max[2], r3_max[3]);
-	const ushort4 r4x_A = ushort4(r3x_min[0], r3x_min[1], r3x_max[0], r3x_max[1]);
-	const ushort4 r4x_B = ushort4(r3x_min[2], r3x_min[3], r3x_max[2], r3x_max[3]);
-	const b4 m4 = islessequal(r4_A, r4_B);
-	const float4 r4_min = fmin(r4_A, r4_B);
-	const float4 r4_max = fmax(r4_A, r4_B);
-	const ushort4 r4x_min = select(r4x_B, r4x_A, m4);
-	const ushort4 r4x_max = select(r4x_A, r4x_B, m4);
+	const f32x8 bbox_min_x = f32x8( par_min.x, par_mid.x, par_min.x, par_mid.x, par_min.x, par_mid.x, par_min.x, par_mid.x );
+	const f32x8 bbox_min_y = f32x8( par_min.yy, par_mid.yy, par_min.yy, par_mid.yy );
+	const f32x8 bbox_min_z = f32x8( par_min.zzzz, par_mid.zzzz );
+	const f32x8 bbox_max_x = f32x8( par_mid.x, par_max.x, par_mid.x, par_max.x, par_mid.x, par_max.x, par_mid.x, par_max.x );
+	const f32x8 bbox_max_y = f32x8( par_mid.yy, par_max.yy, par_mid.yy, par_max.yy );
+	const f32x8 bbox_max_z = f32x8( par_mid.zzzz, par_max.zzzz );
 
-	const float4 r5_A = float4(r4_min[0], r4_max[0], r4_min[2], r4_max[2]);
-	const float4 r5_B = float4(r4_min[1], r4_max[1], r4_min[3], r4_max[3]);
-	const ushort4 r5x_A = ushort4(r4x_min[0], r4x_max[0], r4x_min[2], r4x_max[2]);
-	const ushort4 r5x_B = ushort4(r4x_min[1], r4x_max[1], r4x_min[3], r4x_max[3]);
-	const b4 m5 = islessequal(r5_A, r5_B);
-	const float4 r5_min = fmin(r5_A, r5_B);
-	const float4 r5_max = fmax(r5_A, r5_B);
-	const ushort4 r5x_min = select(r5x_B, r5x_A, m5);
-	const ushort4 r5x_max = select(r5x_A, r5x_B, m5);
+	f32x8 t;
+	s16x8 r;
+	intersect8(bbox_min_x, bbox_min_y, bbox_min_z, bbox_max_x, bbox_max_y, bbox_max_z, ray, &t, &r);
+	const s16x8 occupancy = convert_short8(u16x8(-1) != octet.child);
+	r &= occupancy;
 
-	child_index->distance = f32x8(r5_min[0], r5_max[0], r5_min[1], r5_max[1], r5_min[2], r5_max[2], r5_min[3], r5_max[3]);
-	child_index->index = u16x8(r5x_min[0], r5x_max[0], r5x_min[1], r5x_max[1], r5x_min[2], r5x_max[2], r5x_min[3], r5x_max[3]);
-	return ushort(count);
+	return order_children< kind >(t, r, ray, child_index);
 }
 
 // see George Marsaglia http://www.jstatsoft.org/v08/i14/paper
@@ -505,7 +541,7 @@ uint traverself(
 	thread struct Ray* const ray,
 	thread struct Hit* const hit)
 {
-	struct ChildIndex child_index;
+	struct ChildIndex< closest_hit > child_index;
 
 	const ushort hit_count = octlf_intersect_wide(
 		leaf,
@@ -554,22 +590,22 @@ bool occludelf(
 	thread const struct BBox* const bbox,
 	thread const struct Ray* const ray)
 {
-	struct ChildIndex child_index;
+	struct ChildIndex< any_hit > child_index;
 
-	const ushort hit_count = octlf_intersect_wide(
+	octlf_intersect_wide(
 		leaf,
 		bbox,
 		ray,
 		&child_index);
 
-	const u16x8 index = child_index.index;
 	const u16x8 leaf_start = leaf.start;
 	const u16x8 leaf_count = leaf.count;
 	const uint prior_id = as_uint(ray->origin.w);
 
-	for (ushort i = 0; i < hit_count; ++i) {
-		const ushort payload_start = leaf_start[index[i]];
-		const ushort payload_count = leaf_count[index[i]];
+	for (uint mask = child_index.mask; mask; mask &= mask - 1) {
+		const ushort i = ctz(mask);
+		const ushort payload_start = leaf_start[i];
+		const ushort payload_count = leaf_count[i];
 
 		for (ushort j = payload_start; j < payload_start + payload_count; ++j) {
 			const struct Voxel payload = get_voxel(voxel, j);
@@ -591,22 +627,21 @@ uint traverse(
 	thread struct Ray* const ray,
 	thread struct Hit* const hit)
 {
-	struct ChildIndex child_index;
-	struct BBox child_bbox[8];
+	struct ChildIndex< closest_hit > child_index;
 
 	const ushort hit_count = octet_intersect_wide(
 		octet,
 		bbox,
 		ray,
-		&child_index,
-		child_bbox);
+		&child_index);
 
 	const u16x8 index = child_index.index;
 	const u16x8 octet_child = octet.child;
 
 	for (ushort i = 0; i < hit_count; ++i) {
 		const uint child = octet_child[index[i]];
-		const uint hitId = traverself(get_leaf(leaf, child), voxel, child_bbox + index[i], ray, hit);
+		const struct BBox child_bbox = get_child_bbox(bbox, index[i]);
+		const uint hitId = traverself(get_leaf(leaf, child), voxel, &child_bbox, ray, hit);
 
 		if (-1U != hitId)
 			return hitId;
@@ -621,47 +656,245 @@ bool occlude(
 	thread const struct BBox* const bbox,
 	thread const struct Ray* const ray)
 {
-	struct ChildIndex child_index;
-	struct BBox child_bbox[8];
+	struct ChildIndex< any_hit > child_index;
 
-	const ushort hit_count = octet_intersect_wide(
+	octet_intersect_wide(
 		octet,
 		bbox,
 		ray,
-		&child_index,
-		child_bbox);
+		&child_index);
 
-	const u16x8 index = child_index.index;
 	const u16x8 octet_child = octet.child;
 
-	for (ushort i = 0; i < hit_count; ++i) {
-		const uint child = octet_child[index[i]];
+	for (uint mask = child_index.mask; mask; mask &= mask - 1) {
+		const ushort i = ctz(mask);
+		const uint child = octet_child[i];
+		const struct BBox child_bbox = get_child_bbox(bbox, i);
 
-		if (occludelf(get_leaf(leaf, child), voxel, child_bbox + index[i], ray))
+		if (occludelf(get_leaf(leaf, child), voxel, &child_bbox, ray))
 			return true;
 	}
 	return false;
 }
 
+// heightfield map: see struct Heightfield in param.cpp
+uint hf_traverse(
+	device const uint* const hf,
+	thread struct Ray* const ray,
+	thread struct Hit* const hit)
+{
+	const float2 origin = float2(as_float(hf[0]), as_float(hf[1]));
+	const float cell = as_float(hf[2]);
+	const uint levels = hf[3];
+	const uint2 dim = uint2(hf[4], hf[5]);
+	const float top = as_float(hf[6]);
+	device const float* const height = reinterpret_cast< device const float* >(hf + 16);
+
+	// ray in grid space: xy in cells, z as in world; distances along the ray remain as in world
+	const float3 o = float3((ray->origin.xy - origin) / cell, ray->origin.z);
+	const float3 rcpdir = ray->rcpdir.xyz * float3(cell, cell, 1.f);
+	const float3 dir = 1.f / rcpdir;
+	const bool2 neg = rcpdir.xy < 0.f;
+	const int2 step = select(int2(1), int2(-1), neg);
+	const uint prior_id = as_uint(ray->origin.w);
+
+	// clip ray to grid bbox; past that z stays within [0, top]
+	const float3 t0 = (float3(0.f) - o) * rcpdir;
+	const float3 t1 = (float3(float2(dim), top) - o) * rcpdir;
+	const float3 axial_min = fmin(t0, t1);
+	const float3 axial_max = fmax(t0, t1);
+
+	float t = fmax(fmax(fmax(axial_min.x, axial_min.y), axial_min.z), 0.f);
+#if INFINITE_RAY
+	const float t_leave = fmin(fmin(axial_max.x, axial_max.y), axial_max.z);
+#else
+	const float t_leave = fmin(fmin(fmin(axial_max.x, axial_max.y), axial_max.z), ray->rcpdir.w);
+#endif
+
+	// axis of entry into the current cell: 0 - x, 1 - y, 2 - z
+	uint axis = axial_min.x >= axial_min.y ? (axial_min.x >= axial_min.z ? 0 : 2) : (axial_min.y >= axial_min.z ? 1 : 2);
+
+	// start at the top level, whose single cell covers the grid
+	uint level = levels - 1;
+	int2 c = int2(0);
+
+	// max-mip traversal: skip cells the ray passes above, descend into the rest
+	for (uint i = 0; i < 256 && t < t_leave; ++i) {
+		const uint2 dim_l = (dim + (1U << level) - 1) >> level;
+
+		if (any(c < 0) || any(c >= int2(dim_l)))
+			break;
+
+		const float h = height[hf[8 + level] + c.y * dim_l.x + c.x];
+		const float2 t_xy = (float2((c + int2(!neg)) << level) - o.xy) * rcpdir.xy;
+		const float t_exit = fmin(fmin(t_xy.x, t_xy.y), t_leave);
+		const float z_min = fmin(o.z + dir.z * t, o.z + dir.z * t_exit);
+
+		if (z_min <= h) {
+			if (level) {
+				// descend into the child cell the ray is in at t
+				const float2 p = (o.xy + dir.xy * t) * (1.f / (1U << (level - 1)));
+				const int2 child = int2(select(floor(p), ceil(p) - 1.f, neg));
+
+				c = clamp(child, c * 2, c * 2 + 1);
+				--level;
+				continue;
+			}
+
+			// entering the column from its side, or through its top
+			const float z = o.z + dir.z * t;
+			const float t_hit = z <= h ? t : (h - o.z) * rcpdir.z;
+			const uint id = c.y * dim.x + c.x;
+
+			if (id != prior_id & t_hit > 0.f) {
+				hit->min_mask = islessequal(float3(0.f), ray->rcpdir.xyz);
+				hit->a_mask = z <= h & axis == 0;
+				hit->b_mask = z <= h & axis != 2;
+				ray->rcpdir.w = t_hit;
+				return id;
+			}
+		}
+
+		// step to the next cell at this level, then continue from its parent
+		axis = t_xy.x <= t_xy.y ? 0 : 1;
+		c[axis] += step[axis];
+		t = fmax(t, t_exit);
+
+		if (level < levels - 1) {
+			c >>= 1;
+			++level;
+		}
+	}
+	return -1U;
+}
+
+bool hf_occlude(
+	device const uint* const hf,
+	thread const struct Ray* const ray)
+{
+	struct Ray occl_ray = *ray;
+	struct Hit hit;
+
+	return -1U != hf_traverse(hf, &occl_ray, &hit);
+}
+
+// trace to the closest hit in the scene, be that a heightfield or a tree
+uint traverse_scene(
+	device const ushort4* const src_a,
+	device const ushort4* const src_b,
+	device const float4* const src_c,
+	device const uint* const src_e,
+	thread const struct BBox* const root_bbox,
+	thread struct Ray* const ray,
+	thread struct Hit* const hit)
+{
+	if (src_e[3])
+		return hf_traverse(src_e, ray, hit);
+
+	return traverse(get_octet(src_a, 0), src_b, src_c, root_bbox, ray, hit);
+}
+
+// trace to any hit in the scene, be that a heightfield or a tree
+bool occlude_scene(
+	device const ushort4* const src_a,
+	device const ushort4* const src_b,
+	device const float4* const src_c,
+	device const uint* const src_e,
+	thread const struct BBox* const root_bbox,
+	thread const struct Ray* const ray)
+{
+	if (src_e[3])
+		return hf_occlude(src_e, ray);
+
+	return occlude(get_octet(src_a, 0), src_b, src_c, root_bbox, ray);
+}
+
+// sample the AO hemisphere of a pixel; return decl (cos^2) in .x, azim in .y
+float2 sample_ao(
+	device const ushort2* const noise,
+	const float4 sampler, // .xy = per-frame rotation of the blue-noise tile, .z = as_float(flags) for the CPU kernels, .w = as_float(sampler)
+	const uint2 pixel,
+	const uint2 grid,
+	const uint frame)
+{
+	// spatio-temporal blue noise: blue-noise tile (see struct Noise in param.cpp), rotated per frame
+	if (as_uint(sampler.w)) {
+		const float2 value = float2(noise[(pixel.y & 63) * 64 + (pixel.x & 63)]) * (1.f / 65536);
+		const float2 r = fract(value + sampler.xy);
+		return float2(r.x, r.y * (2.f * M_PI));
+	}
+
+	// white noise: hash of pixel and frame
+	const unsigned seed = pixel.x + pixel.y * grid.x + frame * grid.y * grid.x;
+#if 0
+	const unsigned ri0 = xorshift(seed) * 0x5557 >> 8;
+	const unsigned ri1 = xorshift(seed) * 0x7175 >> 8;
+#else
+	const unsigned ri0 = xorshift(seed) * 0xa47f >> 8;
+	const unsigned ri1 = xorshift(seed) * 0xa175 >> 8;
+#endif
+	const unsigned max_rand = (1U << 24) - 1;
+
+	return float2(ri0 * (1.f / max_rand), ri1 * (M_PI / (1U << 23)));
+}
+
+// compute the AO of a primary hit; return the output luma of the hit
+uint shade(
+	device const ushort4* const src_a,
+	device const ushort4* const src_b,
+	device const float4* const src_c,
+	device const uint* const src_e,
+	thread const struct BBox* const root_bbox,
+	const float3 hit_origin,
+	const uint hit_id,
+	thread const struct Hit* const hit,
+	const float2 sample)
+{
+	// cosine-weighted distribution
+	const float r0 = sample.x; // decl (cos^2)
+	const float r1 = sample.y; // azim
+	const float sin_decl = sqrt(1.f - r0);
+	const float cos_decl = sqrt(r0);
+	float sin_azim;
+	float cos_azim;
+	sin_azim = sincos(r1, cos_azim);
+
+	// compute a bounce vector in some TBN space, in this case of an assumed normal along x-axis
+	const float3 hemi = float3(cos_decl, cos_azim * sin_decl, sin_azim * sin_decl);
+
+	const uint a_mask = hit->a_mask;
+	const uint b_mask = hit->b_mask;
+	const float3 normal = b_mask ? (a_mask ? hemi.xyz : hemi.zxy) : hemi.yzx;
+
+	const int3 axis_sign = int3(0x80000000) & hit->min_mask;
+	const float3 ray_rcpdir = clamp(1.f / as_float3(as_int3(normal) ^ axis_sign), -MAXFLOAT, MAXFLOAT);
+	const struct Ray ray = { float4(hit_origin, as_float(hit_id)), float4(ray_rcpdir, MAXFLOAT) };
+	return select(255, 16, occlude_scene(src_a, src_b, src_c, src_e, root_bbox, &ray));
+}
+
 [[ kernel ]]
 void monokernel(
 	device const ushort4* const src_a [[buffer(0)]],
 	device const ushort4* const src_b [[buffer(1)]],
 	device const float4* const src_c [[buffer(2)]],
 	constant     float4* const src_d [[buffer(3)]],
+	device const uint* const src_e [[buffer(4)]],
+	device const ushort2* const src_f [[buffer(5)]],
 #if USE_DST_BUFFER
-	device       uchar* const dst [[buffer(4)]],
+	device       uchar* const dst [[buffer(6)]],
 #else
 	texture2d< half, access::write > dst [[texture(0)]],
 #endif
-	uint2 gid [[thread_position_in_grid]],
-	uint2 gdim [[threads_per_grid]])
+	constant uint4& rect [[buffer(10)]], // .xy = origin of the grid in the frame, .zw = frame dims
+	uint2 gid [[thread_position_in_grid]])
 {
 // source_main
-	const int idx = int(gid.x);
-	const int idy = int(gid.y);
-	const int dimx = int(gdim.x);
-	const int dimy = int(gdim.y);
+	// the grid covers the screen rect of the scene; pixels outside it are cleared ahead of the dispatch
+	const uint2 pixel = gid + rect.xy;
+	const int idx = int(pixel.x);
+	const int idy = int(pixel.y);
+	const int dimx = int(rect.z);
+	const int dimy = int(rect.w);
 
 	const float3 cam0 = src_d[0].xyz;
 	const float3 cam1 = src_d[1].xyz;
@@ -670,6 +903,7 @@ void monokernel(
 	const float3 bbox_min   = src_d[4].xyz;
 	const float3 bbox_max   = src_d[5].xyz;
 	const uint frame        = as_uint(src_d[5].w);
+	const float4 sampler    = src_d[6];
 
 	const struct BBox root_bbox = { bbox_min, bbox_max };
 	const float3 ray_direction =
@@ -678,49 +912,191 @@ void monokernel(
 		cam2;
 	const float3 ray_rcpdir = clamp(1.f / ray_direction, -MAXFLOAT, MAXFLOAT);
 	struct RayHit ray = { { float4(ray_origin, as_float(-1U)), float4(ray_rcpdir, MAXFLOAT) } };
-	uint result = traverse(get_octet(src_a, 0), src_b, src_c, &root_bbox, &ray.ray, &ray.hit);
+	uint result = traverse_scene(src_a, src_b, src_c, src_e, &root_bbox, &ray.ray, &ray.hit);
 
 	if (-1U != result) {
-		const unsigned seed = idx + idy * dimx + frame * dimy * dimx;
-#if 0
-		const unsigned ri0 = xorshift(seed) * 0x5557 >> 8;
-		const unsigned ri1 = xorshift(seed) * 0x7175 >> 8;
+		const float2 sample = sample_ao(src_f, sampler, pixel, rect.zw, frame);
+		const float dist = ray.ray.rcpdir.w;
+		result = shade(src_a, src_b, src_c, src_e, &root_bbox, ray_origin + ray_direction * dist, result, &ray.hit, sample);
+	}
+	else
+		result = 0;
+
+// source_epilogue
+#if USE_DST_BUFFER
+	dst[pixel.x + pixel.y * rect.z] = result;
 #else
-		const unsigned ri0 = xorshift(seed) * 0xa47f >> 8;
-		const unsigned ri1 = xorshift(seed) * 0xa175 >> 8;
+	dst.write(result * half(1.0 / 255.0), pixel);
 #endif
-		const unsigned max_rand = (1U << 24) - 1;
+}
 
-		// cosine-weighted distribution
-		const float r0 = ri0 * (1.f / max_rand); // decl (cos^2)
-		const float r1 = ri1 * (M_PI / (1U << 23)); // azim
-		const float sin_decl = sqrt(1.f - r0);
-		const float cos_decl = sqrt(r0);
-		float sin_azim;
-		float cos_azim;
-		sin_azim = sincos(r1, cos_azim);
+////////////////////////////////////////////////////////////////////////////////
+// wavefront pipeline: primary pass -> compact hit list -> AO pass over hits
+////////////////////////////////////////////////////////////////////////////////
 
-		// compute a bounce vector in some TBN space, in this case of an assumed normal along x-axis
-		const float3 hemi = float3(cos_decl, cos_azim * sin_decl, sin_azim * sin_decl);
+// primary hit, as passed from the primary pass to the AO pass
+struct Hitpoint {
+	float4 origin; // .xyz = hit position, .w = as_float(voxel_id)
+	uint pixel;    // .x = lo 16 bits, .y = hi 16 bits
+	uint axis;     // bits 0-2 = min_mask, bit 3 = a_mask, bit 4 = b_mask
+};
 
-		const uint a_mask = ray.hit.a_mask;
-		const uint b_mask = ray.hit.b_mask;
-		const float3 normal = b_mask ? (a_mask ? hemi.xyz : hemi.zxy) : hemi.yzx;
+[[ kernel ]]
+void primary(
+	device const ushort4* const src_a [[buffer(0)]],
+	device const ushort4* const src_b [[buffer(1)]],
+	device const float4* const src_c [[buffer(2)]],
+	constant     float4* const src_d [[buffer(3)]],
+	device const uint* const src_e [[buffer(4)]],
+	device const ushort2* const src_f [[buffer(5)]],
+#if USE_DST_BUFFER
+	device       uchar* const dst [[buffer(6)]],
+#else
+	texture2d< half, access::write > dst [[texture(0)]],
+#endif
+	device struct Hitpoint* const hitpoint [[buffer(7)]],
+	device atomic_uint* const hit_count [[buffer(8)]],
+	constant uint4& rect [[buffer(10)]], // .xy = origin of the grid in the frame, .zw = frame dims
+	uint2 gid [[thread_position_in_grid]])
+{
+	// the grid covers the screen rect of the scene; pixels outside it are cleared ahead of the dispatch
+	const uint2 pixel = gid + rect.xy;
+	const int idx = int(pixel.x);
+	const int idy = int(pixel.y);
+	const int dimx = int(rect.z);
+	const int dimy = int(rect.w);
 
-		const int3 axis_sign = int3(0x80000000) & ray.hit.min_mask;
-		const float dist = ray.ray.rcpdir.w;
-		const float3 ray_rcpdir = clamp(1.f / as_float3(as_int3(normal) ^ axis_sign), -MAXFLOAT, MAXFLOAT);
-		const struct Ray ray = { float4(ray_origin + ray_direction * dist, as_float(result)), float4(ray_rcpdir, MAXFLOAT) };
-		result = select(255, 16, occlude(get_octet(src_a, 0), src_b, src_c, &root_bbox, &ray));
+	const float3 cam0 = src_d[0].xyz;
+	const float3 cam1 = src_d[1].xyz;
+	const float3 cam2 = src_d[2].xyz;
+	const float3 ray_origin = src_d[3].xyz;
+	const float3 bbox_min   = src_d[4].xyz;
+	const float3 bbox_max   = src_d[5].xyz;
+
+	const struct BBox root_bbox = { bbox_min, bbox_max };
+	const float3 ray_direction =
+		cam0 * ((idx * 2 - dimx) * (1.0f / dimx)) +
+		cam1 * ((idy * 2 - dimy) * (1.0f / dimy)) +
+		cam2;
+	const float3 ray_rcpdir = clamp(1.f / ray_direction, -MAXFLOAT, MAXFLOAT);
+	struct RayHit ray = { { float4(ray_origin, as_float(-1U)), float4(ray_rcpdir, MAXFLOAT) } };
+	const uint result = traverse_scene(src_a, src_b, src_c, src_e, &root_bbox, &ray.ray, &ray.hit);
+
+	// background pixels are final as of this pass
+	if (-1U == result) {
+#if USE_DST_BUFFER
+		dst[pixel.x + pixel.y * rect.z] = 0;
+#else
+		dst.write(half(0), pixel);
+#endif
+		return;
 	}
-	else
-		result = 0;
 
-// source_epilogue
+	const uint3 min_mask = uint3(ray.hit.min_mask) & 1;
+	const uint i = atomic_fetch_add_explicit(hit_count, 1, memory_order_relaxed);
+
+	hitpoint[i].origin = float4(ray_origin + ray_direction * ray.ray.rcpdir.w, as_float(result));
+	hitpoint[i].pixel = pixel.x | pixel.y << 16;
+	hitpoint[i].axis = min_mask.x | min_mask.y << 1 | min_mask.z << 2 | uint(ray.hit.a_mask) << 3 | uint(ray.hit.b_mask) << 4;
+}
+
+// turn the hit count from the primary pass into the threadgroup count of the AO pass
+[[ kernel ]]
+void wavefront_args(
+	device const atomic_uint* const hit_count [[buffer(0)]],
+	device uint* const dispatch_args [[buffer(1)]],
+	constant uint& group_size [[buffer(2)]])
+{
+	const uint count = atomic_load_explicit(hit_count, memory_order_relaxed);
+
+	dispatch_args[0] = (count + group_size - 1) / group_size;
+	dispatch_args[1] = 1;
+	dispatch_args[2] = 1;
+}
+
+[[ kernel ]]
+void occlusion(
+	device const ushort4* const src_a [[buffer(0)]],
+	device const ushort4* const src_b [[buffer(1)]],
+	device const float4* const src_c [[buffer(2)]],
+	constant     float4* const src_d [[buffer(3)]],
+	device const uint* const src_e [[buffer(4)]],
+	device const ushort2* const src_f [[buffer(5)]],
+#if USE_DST_BUFFER
+	device       uchar* const dst [[buffer(6)]],
+#else
+	texture2d< half, access::write > dst [[texture(0)]],
+#endif
+	device const struct Hitpoint* const hitpoint [[buffer(7)]],
+	device const atomic_uint* const hit_count [[buffer(8)]],
+	constant uint2& grid [[buffer(9)]],
+	uint tid [[thread_position_in_grid]])
+{
+	if (tid >= atomic_load_explicit(hit_count, memory_order_relaxed))
+		return;
+
+	const float3 bbox_min = src_d[4].xyz;
+	const float3 bbox_max = src_d[5].xyz;
+	const uint frame      = as_uint(src_d[5].w);
+	const float4 sampler  = src_d[6];
+
+	const struct BBox root_bbox = { bbox_min, bbox_max };
+	const struct Hitpoint hp = hitpoint[tid];
+	const uint2 pixel = uint2(hp.pixel & 0xffff, hp.pixel >> 16);
+
+	struct Hit hit;
+	hit.min_mask = -int3((uint3(hp.axis) >> uint3(0, 1, 2)) & 1);
+	hit.a_mask = (hp.axis >> 3) & 1;
+	hit.b_mask = (hp.axis >> 4) & 1;
+
+	const float2 sample = sample_ao(src_f, sampler, pixel, grid, frame);
+	const uint result = shade(src_a, src_b, src_c, src_e, &root_bbox, hp.origin.xyz, as_uint(hp.origin.w), &hit, sample);
+
 #if USE_DST_BUFFER
-	dst[gid.x + gid.y * gdim.x] = result;
+	dst[pixel.x + pixel.y * grid.x] = result;
 #else
-	dst.write(result * half(1.0 / 255.0), gid);
+	dst.write(result * half(1.0 / 255.0), pixel);
 #endif
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// dynamic resolution: frame rendered at a fraction of the screen -> screen
+////////////////////////////////////////////////////////////////////////////////
+
+// bilinear upsample of a frame of dim.xy to the screen of dim.zw, over whole groups covering the screen
+[[ kernel ]]
+void upsample(
+#if USE_DST_BUFFER
+	device const uchar* const src [[buffer(0)]],
+#else
+	texture2d< half, access::read > src [[texture(1)]],
+#endif
+	constant uint4& dim [[buffer(1)]],
+	texture2d< half, access::write > dst [[texture(0)]],
+	uint2 gid [[thread_position_in_grid]])
+{
+	if (gid.x >= dim.z || gid.y >= dim.w)
+		return;
+
+	// screen pixel centre in the frame, clamped to the frame edge pixel centres
+	const float2 pos = clamp((float2(gid) + .5f) * float2(dim.xy) / float2(dim.zw) - .5f, float2(0), float2(dim.xy - 1));
+	const uint2 p0 = uint2(pos);
+	const uint2 p1 = min(p0 + 1, dim.xy - 1);
+	const half2 w = half2(pos - float2(p0));
+
+#if USE_DST_BUFFER
+	const half4 v = half4(
+		half(src[p0.x + p0.y * dim.x]),
+		half(src[p1.x + p0.y * dim.x]),
+		half(src[p0.x + p1.y * dim.x]),
+		half(src[p1.x + p1.y * dim.x])) * half(1.0 / 255.0);
+#else
+	const half4 v = half4(
+		src.read(uint2(p0.x, p0.y)).x,
+		src.read(uint2(p1.x, p0.y)).x,
+		src.read(uint2(p0.x, p1.y)).x,
+		src.read(uint2(p1.x, p1.y)).x);
+#endif
+	const half2 row = mix(v.xz, v.yw, w.x);
+	dst.write(mix(row.x, row.y, w.y), gid);
+}
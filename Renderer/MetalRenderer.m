@@ -1,8 +1,15 @@
 @import MetalKit;
 
 #import <stdatomic.h>
+#import <math.h>
+#import <stdio.h>
+#import <stdlib.h>
+#import <time.h>
 #import "MetalRenderer.h"
 #import "param.h"
+#import "trace.h"
+#import "tune.h"
+#import "cpupost.h"
 
 enum { n_buffering = 16 };
 
@@ -10,14 +17,27 @@ enum { n_buffering = 16 };
 // loop to mask frame-pacing issues like momentary frame-time spikes; this
 // does not help against unachievable framerate targets, though, which will
 // manifest as constant tearing and/or frame glitches, no matter the size of
-// n-buffering
+// n-buffering; n_buffering is the most slots we allocate, while the depth in
+// use adapts to the measured frame latency, so that a steady workload runs at
+// low latency, and a spiky one gets the buffering to absorb its spikes
 
 static_assert(n_buffering > 1, "n-buffering must be greater than 1");
 
+enum {
+	min_buffering = 2,
+	initial_buffering = 3
+};
+
+static_assert(min_buffering <= initial_buffering && initial_buffering <= n_buffering, "initial buffering out of range");
+
 @implementation MetalRenderer
 {
 	id<MTLDevice> _device;
 	id<MTLComputePipelineState> _fnMonoPSO;
+	id<MTLComputePipelineState> _fnPrimaryPSO;
+	id<MTLComputePipelineState> _fnWavefrontArgsPSO;
+	id<MTLComputePipelineState> _fnOcclusionPSO;
+	id<MTLComputePipelineState> _fnUpsamplePSO;
 	id<MTLCommandQueue> _commandQueue;
 
 	id<MTLBuffer> _src_buffer[n_buffering][buffer_designation_count];
@@ -25,11 +45,556 @@ static_assert(n_buffering > 1, "n-buffering must be greater than 1");
 #if USE_DST_BUFFER
 	id<MTLBuffer> _dst_buffer[n_buffering];
 
+	// post-process stage: output of the frame of each slot, the latest of them the history of the temporal blur of
+	// the next; per slot, so that the CPU never writes an output the GPU may still upsample -- the last upsample of
+	// a slot's output precedes on the queue the frame of its next use, done by the time the slot is presented again
+	id<MTLBuffer> _post_buffer[n_buffering];
+
+#endif
+	// wavefront pipeline: hit list, hit count and AO-pass dispatch args; as command
+	// buffers run in order, these are shared by all frames in flight
+	id<MTLBuffer> _hit_buffer;
+	id<MTLBuffer> _hit_count;
+	id<MTLBuffer> _dispatch_args;
+
+#if USE_DST_BUFFER == 0
+	// dynamic resolution: frame rendered at a fraction of the screen, ahead of its upsample to the drawable; as
+	// command buffers run in order, this is shared by all frames in flight
+	id<MTLTexture> _scaled_texture;
+
 #endif
 }
 
+// per-pass GPU times of the wavefront pipeline, ns
+static atomic_ullong primary_time;
+static atomic_ullong occlusion_time;
+static atomic_uint timed_frames;
+
+// per-scene GPU times of whole frames, ns
+static atomic_ullong scene_time[content_scene_count];
+static atomic_uint scene_frames[content_scene_count];
+
+// size of struct Hitpoint in monokernel.metal
+enum { hitpoint_size = 8 * sizeof(float) };
+
+// wavefront kernel args past the frame source buffers and destination
+enum {
+	wavefront_hitpoint = buffer_designation_count + 1,
+	wavefront_hit_count,
+	wavefront_grid
+};
+
+// arg of the monokernel and primary kernels past the above: dispatch rect, i.e. origin of the grid in the frame, and
+// frame dims
+enum { kernel_rect = wavefront_grid + 1 };
+
+// carb entry of the screen rect of the scene, as of content_frame: u_min, v_min, u_max, v_max in the screen coords
+// of the primary rays
+enum { carb_rect = 7 };
+
+// pixels culled by the screen rect of the scene, and pixels of all frames, over the whole session
+static uint64_t cull_pixels;
+static uint64_t frame_pixels;
+
 struct content_init_arg cont_init_arg;
 
+// frame id within the current run
+static uint32_t frame_id;
+
+// frame slot ring: the frame loop acquires the slot at the ring head, builds and commits its frame; the completion
+// handler of the last command buffer of the frame marks the slot done; the frame loop then releases done slots
+// from the ring tail, in order -- with destination buffers, it presents the latest done frame of them, and skips
+// any older ones; as the frame loop is the only producer, and the completion handlers the only consumer, of each
+// slot, the slot state is the only shared datum; a slot is never rebuilt before its frame is done with
+enum slot_state {
+	SLOT_FREE,
+	SLOT_BUILDING,
+	SLOT_IN_FLIGHT,
+	SLOT_DONE,
+};
+
+struct frame_slot {
+	atomic_uint state;
+	uint32_t frame;
+	uint64_t start_ns;  // frame loop start of the frame
+	uint64_t commit_ns; // commit of the last command buffer of the frame
+	uint64_t done_ns;   // completion of the frame; published by the state
+	uint32_t render_w;  // render geometry of the frame, short of the screen geometry at dynamic resolution
+	uint32_t render_h;
+	atomic_ullong gpu_ns; // GPU time of the frame, accumulated by its command buffers
+};
+
+static struct frame_slot frame_slot[n_buffering];
+static uint32_t slot_head;  // count of slots acquired
+static uint32_t slot_tail;  // count of slots released
+static uint32_t slot_depth; // admission limit of slots in use
+static uint32_t slot_depth_max;
+static uint32_t slot_calm;  // consecutive frames of lesser need than the depth
+
+#if USE_DST_BUFFER
+// post-process stage: slot of the latest output, and its geometry, zero for no output to blur with
+static uint32_t post_slot;
+static uint32_t post_w;
+static uint32_t post_h;
+
+#endif
+
+// running mean and variance of frame latency, ns: the time of the frame itself -- from frame loop start to commit,
+// plus its GPU execution -- not that queued behind other frames in flight, which the depth itself drives; running
+// mean of the GPU execution, ns
+static float latency_mean;
+static float latency_var;
+static float gpu_mean;
+
+static void
+reset_buffering(void)
+{
+	slot_depth = initial_buffering;
+	slot_depth_max = MAX(slot_depth_max, slot_depth);
+	slot_calm = 0;
+	latency_mean = 0.f;
+	latency_var = 0.f;
+	gpu_mean = 0.f;
+}
+
+// Adapt the buffering depth to the latency of a frame just done, of its CPU time to commit and its GPU execution
+// time: grow at once to the slots in flight needed to cover all but the rare frame latency, shrink one slot at a time
+// after a second's worth of lesser need
+static void
+adapt_buffering(
+	const uint64_t cpu_ns,
+	const uint64_t gpu_ns)
+{
+	const float alpha = 1.f / 32.f;
+	const float x = cpu_ns + gpu_ns;
+
+	if (latency_mean == 0.f) {
+		latency_mean = x;
+		gpu_mean = gpu_ns;
+	}
+	else {
+		const float d = x - latency_mean;
+		latency_mean += alpha * d;
+		latency_var = (1.f - alpha) * (latency_var + alpha * d * d);
+		gpu_mean += alpha * (gpu_ns - gpu_mean);
+	}
+
+	// slots to cover the latency of the frame, plus the one of the frame being built
+	const float period = 1e9f / param.image_hz;
+	const uint32_t need = MIN(MAX((uint32_t) ceilf((latency_mean + 3.f * sqrtf(latency_var)) / period) + 1,
+		(uint32_t) min_buffering), (uint32_t) n_buffering);
+
+	if (need > slot_depth) {
+		slot_depth = need;
+		slot_depth_max = MAX(slot_depth_max, slot_depth);
+		slot_calm = 0;
+	}
+	else
+	if (need < slot_depth && ++slot_calm >= param.image_hz) {
+		slot_depth--;
+		slot_calm = 0;
+	}
+	else
+	if (need == slot_depth) {
+		slot_calm = 0;
+	}
+}
+
+// dynamic resolution: the render scale of the screen geometry takes steps of 1/16 from param.res_max down to
+// param.res_min; the step follows the GPU time of the frames, as the running mean of GPU time per pixel times the
+// pixels of a step, to keep it within a share of the frame period
+enum { res_steps_per_unit = 16 };
+
+static const float res_budget = .8f; // share of the frame period a frame may take on the GPU
+
+static uint32_t res_step;      // current step, 0 being the most scale
+static uint32_t res_step_max;  // step of the least scale
+static uint32_t res_step_peak; // deepest step taken
+static uint32_t res_calm;      // consecutive frames of room for a lesser step than the current
+
+// running mean of GPU time per rendered pixel, ns
+static float pixel_cost;
+
+// count and scale sum of the frames done at dynamic resolution
+static uint32_t res_frames;
+static double res_scale_sum;
+
+// dispatch of partial threadgroups at the grid edges, for group sizes not dividing the grid size
+static bool nonuniform_groups;
+
+// dynamic resolution applies to all modes but autotune, which times its shapes at the screen geometry
+static bool
+dynamic_resolution(void)
+{
+	return param.res_min < 1.f && MODE_AUTOTUNE != param.mode;
+}
+
+static float
+get_render_scale(const uint32_t step)
+{
+	return MAX(param.res_max - (float) step / res_steps_per_unit, param.res_min);
+}
+
+// Render geometry of a step of scale: the screen geometry scaled, in whole groups where the GPU takes no partial ones
+static void
+get_render_size(
+	const uint32_t step,
+	uint32_t *const render_w,
+	uint32_t *const render_h)
+{
+	const float scale = get_render_scale(step);
+	uint32_t w = MAX((uint32_t) (param.image_w * scale + .5f), 1U);
+	uint32_t h = MAX((uint32_t) (param.image_h * scale + .5f), 1U);
+
+	if (!nonuniform_groups && w < param.image_w) {
+		w = MAX(w / param.group_w, 1U) * param.group_w;
+	}
+
+	if (!nonuniform_groups && h < param.image_h) {
+		h = MAX(h / param.group_h, 1U) * param.group_h;
+	}
+
+	*render_w = MIN(w, param.image_w);
+	*render_h = MIN(h, param.image_h);
+}
+
+static void
+reset_resolution(void)
+{
+	res_step = 0;
+	res_step_max = (uint32_t) ceilf((param.res_max - param.res_min) * res_steps_per_unit - 1e-3f);
+	res_calm = 0;
+	pixel_cost = 0.f;
+}
+
+// Adapt the render scale to the GPU time of a frame just done: drop at once to the most scale whose GPU time would
+// fit the budget, rise one step at a time after a second's worth of room for the step above
+static void
+adapt_resolution(
+	const uint64_t gpu_ns,
+	const uint32_t pixels)
+{
+	if (!dynamic_resolution() || gpu_ns == 0)
+		return;
+
+	const float alpha = 1.f / 8.f;
+	const float x = (float) gpu_ns / pixels;
+
+	if (pixel_cost == 0.f) {
+		pixel_cost = x;
+	}
+	else {
+		pixel_cost += alpha * (x - pixel_cost);
+	}
+
+	// a frame costlier than the mean counts at once
+	const float cost = MAX(pixel_cost, x);
+	const float budget = res_budget * 1e9f / param.image_hz;
+	uint32_t fit = 0;
+
+	for (; fit < res_step_max; fit++) {
+		uint32_t w, h;
+		get_render_size(fit, &w, &h);
+
+		if (cost * w * h <= budget)
+			break;
+	}
+
+	if (fit > res_step) {
+		res_step = fit;
+		res_step_peak = MAX(res_step_peak, res_step);
+		res_calm = 0;
+	}
+	else
+	if (fit < res_step && ++res_calm >= param.image_hz) {
+		res_step--;
+		res_calm = 0;
+	}
+	else
+	if (fit == res_step) {
+		res_calm = 0;
+	}
+}
+
+// one run of the sweep matrix; outside of sweep mode there is a single run, as per CLI
+struct sweep_run {
+	uint32_t image_w;
+	uint32_t image_h;
+	uint32_t image_hz;
+	uint32_t group_w;
+	uint32_t group_h;
+	uint32_t frame_msk;
+	uint32_t frames;
+
+	// sweep mode stats: content setup time, counts of frames not drawn for GPU overload and of drawn frames
+	// that missed their vsync, render scale sum of the drawn frames, pixels of the drawn frames and those of them
+	// culled by the screen rect of the scene, and per-frame times of the drawn frames: interval since the prior
+	// drawn frame, content_frame time and GPU time
+	uint64_t setup_ns;
+	uint32_t overloads;
+	uint32_t late_frames;
+	double scale_sum;
+	uint64_t pixels;
+	uint64_t cull_pixels;
+	uint32_t drawn;
+	uint32_t intervals;
+	uint64_t last_draw;
+	uint64_t *interval_ns;
+	uint64_t *build_ns;
+	atomic_ullong *gpu_ns;
+};
+
+enum { max_sweep_runs = max_sweep_values * max_sweep_values * 2 * max_sweep_values };
+
+static struct sweep_run sweep_run[max_sweep_runs];
+static uint32_t sweep_run_count;
+static uint32_t sweep_run_idx;
+
+// modes of several runs, each from the timeline start: sweep, and the GPU part of autotune
+static bool
+multi_run(void)
+{
+	return MODE_SWEEP == param.mode || MODE_AUTOTUNE == param.mode;
+}
+
+static uint64_t
+time_ns(void)
+{
+	return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+// Fit the requested group size (-1U for default) to a grid and the kernel limits; false if no fit
+static bool
+fit_group(
+	const uint32_t draw_w,
+	const uint32_t draw_h,
+	const uint32_t group_max,
+	const uint32_t exec_w,
+	uint32_t *const group_w,
+	uint32_t *const group_h)
+{
+	const uint32_t drawSize = draw_w * draw_h;
+
+	uint32_t threadgroupSize = *group_w != -1U ? *group_w * *group_h : group_max;
+	if (threadgroupSize > drawSize) {
+		threadgroupSize = drawSize;
+	}
+
+	if (threadgroupSize > group_max) {
+		NSLog(@"error: group size exceeds limit (%u)", group_max);
+		return false;
+	}
+
+	uint32_t threadgroupWidth = *group_w != -1U ? *group_w : exec_w;
+	if (threadgroupWidth > draw_w) {
+		threadgroupWidth = draw_w;
+	}
+
+	*group_w = threadgroupWidth;
+	*group_h = threadgroupSize / threadgroupWidth;
+
+	NSLog(@"grid size (%u, %u), group size (%u, %u)", draw_w, draw_h, *group_w, *group_h);
+
+	if (!nonuniform_groups && (draw_w % *group_w || draw_h % *group_h)) {
+		NSLog(@"error: grid size not a multiple of group size, and the GPU takes no partial groups");
+		return false;
+	}
+
+	return true;
+}
+
+// Pixels [first, last) of a frame dimension of the given count whose primary rays fall within [min, max] of the screen
+// coords, with a pixel of margin for rounding, as pixel_span of the CPU kernels; in whole groups of the given size
+// where the GPU takes no partial groups, the count being of whole groups then; none if max < min
+static void
+get_pixel_span(
+	const float min,
+	const float max,
+	const uint32_t count,
+	const uint32_t group,
+	uint32_t *const first,
+	uint32_t *const last)
+{
+	if (max < min) {
+		*first = 0;
+		*last = 0;
+		return;
+	}
+
+	*last = (uint32_t) MIN(MAX(ceilf((max + 1.f) * .5f * count) + 2.f, 0.f), (float) count);
+	*first = MIN((uint32_t) MAX(floorf((min + 1.f) * .5f * count) - 1.f, 0.f), *last);
+
+	if (!nonuniform_groups) {
+		*first = *first / group * group;
+		*last = MIN((*last + group - 1) / group * group, count);
+	}
+}
+
+static void
+apply_run(const struct sweep_run *const run)
+{
+	param.image_w = run->image_w;
+	param.image_h = run->image_h;
+	param.image_hz = run->image_hz;
+	param.group_w = run->group_w;
+	param.group_h = run->group_h;
+	param.frame_msk = run->frame_msk;
+}
+
+static int
+cmp_u64(const void *a, const void *b)
+{
+	const uint64_t x = *(const uint64_t *) a;
+	const uint64_t y = *(const uint64_t *) b;
+	return (x > y) - (x < y);
+}
+
+// Percentiles of a sample set, ms; sorts the set in place
+static void
+percentiles_ms(
+	uint64_t *const sample,
+	const uint32_t count,
+	const double pct[4],
+	double res[4])
+{
+	qsort(sample, count, sizeof(*sample), cmp_u64);
+
+	for (size_t i = 0; i < 4; i++) {
+		res[i] = count ? sample[(size_t) ((count - 1) * pct[i] + .5)] * 1e-6 : 0.0;
+	}
+}
+
+static void
+fprint_ms(FILE *f, const char *name, const uint64_t *sample, const uint32_t count)
+{
+	fprintf(f, "\"%s\": [", name);
+
+	for (size_t i = 0; i < count; i++) {
+		fprintf(f, i ? ", %.4f" : "%.4f", sample[i] * 1e-6);
+	}
+
+	fprintf(f, "]");
+}
+
+// Write the sweep reports: per-run summaries to <prefix>.csv, per-run frame times to <prefix>.json
+static bool
+write_sweep_report(void)
+{
+	char path[1024];
+
+	snprintf(path, sizeof(path), "%s.json", param.sweep_out);
+	FILE *json = fopen(path, "w");
+
+	snprintf(path, sizeof(path), "%s.csv", param.sweep_out);
+	FILE *csv = fopen(path, "w");
+
+	if (json == NULL || csv == NULL) {
+		NSLog(@"error: cannot write sweep reports at %s", param.sweep_out);
+
+		if (json)
+			fclose(json);
+
+		if (csv)
+			fclose(csv);
+
+		return false;
+	}
+
+	fprintf(csv, "run,width,height,hz,group_w,group_h,rng,frames,setup_ms,overloads,late_frames,"
+		"interval_p50_ms,interval_p90_ms,interval_p99_ms,interval_max_ms,"
+		"gpu_p50_ms,gpu_p90_ms,gpu_p99_ms,gpu_max_ms,"
+		"build_mean_ms,build_p50_ms,build_p99_ms,build_max_ms,scale_mean,cull_rate\n");
+	fprintf(json, "{\n\"runs\": [\n");
+
+	const double pct[4] = { .5, .9, .99, 1. };
+
+	for (size_t ri = 0; ri < sweep_run_count; ri++) {
+		struct sweep_run *const run = sweep_run + ri;
+		uint64_t *const gpu_ns = (uint64_t *) malloc(run->drawn * sizeof(uint64_t));
+		const double scale_mean = run->drawn ? run->scale_sum / run->drawn : 0.0;
+		const double cull_rate = run->pixels ? (double) run->cull_pixels / run->pixels : 0.0;
+		uint64_t build_sum = 0;
+
+		for (size_t i = 0; i < run->drawn; i++) {
+			gpu_ns[i] = atomic_load(&run->gpu_ns[i]);
+			build_sum += run->build_ns[i];
+		}
+
+		fprintf(json, "%s{ \"run\": %zu, \"width\": %u, \"height\": %u, \"hz\": %u, \"group_w\": %u, \"group_h\": %u, "
+			"\"rng\": \"%s\", \"frames\": %u, \"setup_ms\": %.4f, \"overloads\": %u, \"late_frames\": %u, \"scale_mean\": %.4f, "
+			"\"cull_rate\": %.4f,\n  ",
+			ri ? ",\n" : "", ri, run->image_w, run->image_h, run->image_hz, run->group_w, run->group_h,
+			run->frame_msk ? "var" : "invar", run->frames, run->setup_ns * 1e-6, run->overloads, run->late_frames, scale_mean, cull_rate);
+		fprint_ms(json, "interval_ms", run->interval_ns, run->intervals);
+		fprintf(json, ",\n  ");
+		fprint_ms(json, "build_ms", run->build_ns, run->drawn);
+		fprintf(json, ",\n  ");
+		fprint_ms(json, "gpu_ms", gpu_ns, run->drawn);
+		fprintf(json, " }");
+
+		double interval[4], gpu[4], build[4];
+		percentiles_ms(run->interval_ns, run->intervals, pct, interval);
+		percentiles_ms(gpu_ns, run->drawn, pct, gpu);
+		percentiles_ms(run->build_ns, run->drawn, pct, build);
+
+		fprintf(csv, "%zu,%u,%u,%u,%u,%u,%s,%u,%.4f,%u,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+			ri, run->image_w, run->image_h, run->image_hz, run->group_w, run->group_h,
+			run->frame_msk ? "var" : "invar", run->frames, run->setup_ns * 1e-6, run->overloads, run->late_frames,
+			interval[0], interval[1], interval[2], interval[3],
+			gpu[0], gpu[1], gpu[2], gpu[3],
+			run->drawn ? build_sum * 1e-6 / run->drawn : 0.0, build[0], build[2], build[3], scale_mean, cull_rate);
+
+		free(gpu_ns);
+	}
+
+	fprintf(json, "\n]\n}\n");
+
+	fclose(json);
+	fclose(csv);
+
+	NSLog(@"sweep reports written to %s.csv and %s.json", param.sweep_out, param.sweep_out);
+	return true;
+}
+
+// Store the group size of the autotune run of the least median GPU time in the tuning cache
+static bool
+store_autotune(const char *const device)
+{
+	const double pct[4] = { .5, .9, .99, 1. };
+	size_t best = 0;
+	double best_ms = INFINITY;
+
+	for (size_t ri = 0; ri < sweep_run_count; ri++) {
+		struct sweep_run *const run = sweep_run + ri;
+		uint64_t *const gpu_ns = (uint64_t *) malloc(run->drawn * sizeof(uint64_t));
+
+		for (size_t i = 0; i < run->drawn; i++) {
+			gpu_ns[i] = atomic_load(&run->gpu_ns[i]);
+		}
+
+		double gpu[4];
+		percentiles_ms(gpu_ns, run->drawn, pct, gpu);
+		free(gpu_ns);
+
+		NSLog(@"autotune: group size (%u, %u), GPU time %.4f ms median, %.4f ms p90, over %u frames",
+			run->group_w, run->group_h, gpu[0], gpu[1], run->drawn);
+
+		if (run->drawn && gpu[0] < best_ms) {
+			best_ms = gpu[0];
+			best = ri;
+		}
+	}
+
+	const struct sweep_run *const run = sweep_run + best;
+	const uint32_t shape[2] = { run->group_w, run->group_h };
+
+	if (isinf(best_ms) || tune_cache_put(TUNE_GPU, device, run->image_w, run->image_h, shape))
+		return false;
+
+	NSLog(@"autotune: group size (%u, %u) stored for %s at %ux%u", shape[0], shape[1], device, run->image_w, run->image_h);
+	return true;
+}
+
 - (nonnull instancetype)initWithMTLDevice:(nonnull id<MTLDevice>)device
 {
 	self = [super init];
@@ -39,10 +604,18 @@ struct content_init_arg cont_init_arg;
 
 		_device = device;
 
+		// specialize kernels as per CLI
+		const bool child_order_octant = param.flags & FLAG_OCTANT_ORDER;
+		MTLFunctionConstantValues *constants = [[MTLFunctionConstantValues alloc] init];
+		[constants setConstantValue:&child_order_octant type:MTLDataTypeBool atIndex:0];
+
 		id<MTLLibrary> defaultLibrary = [_device newDefaultLibrary];
-		id<MTLFunction> fnMono = [defaultLibrary newFunctionWithName:@"monokernel"];
+		id<MTLFunction> fnMono = [defaultLibrary newFunctionWithName:@"monokernel" constantValues:constants error:&error];
+		id<MTLFunction> fnPrimary = [defaultLibrary newFunctionWithName:@"primary" constantValues:constants error:&error];
+		id<MTLFunction> fnWavefrontArgs = [defaultLibrary newFunctionWithName:@"wavefront_args" constantValues:constants error:&error];
+		id<MTLFunction> fnOcclusion = [defaultLibrary newFunctionWithName:@"occlusion" constantValues:constants error:&error];
 
-		if (fnMono == nil) {
+		if (fnMono == nil || fnPrimary == nil || fnWavefrontArgs == nil || fnOcclusion == nil) {
 			NSLog(@"error: Failed to find kernel function.");
 			return nil;
 		}
@@ -54,44 +627,149 @@ struct content_init_arg cont_init_arg;
 			return nil;
 		}
 
-		const unsigned draw_w = param.image_w;
-		const unsigned draw_h = param.image_h;
-		const unsigned drawSize = draw_w * draw_h;
-		const unsigned threadgroupSizeMax = (unsigned) _fnMonoPSO.maxTotalThreadsPerThreadgroup;
+		if (param.flags & FLAG_WAVEFRONT) {
+			_fnPrimaryPSO = [_device newComputePipelineStateWithFunction:fnPrimary error:&error];
+			_fnWavefrontArgsPSO = [_device newComputePipelineStateWithFunction:fnWavefrontArgs error:&error];
+			_fnOcclusionPSO = [_device newComputePipelineStateWithFunction:fnOcclusion error:&error];
 
-		unsigned threadgroupSize = param.group_w != -1U ? param.group_w * param.group_h : threadgroupSizeMax;
-		if (threadgroupSize > drawSize) {
-			threadgroupSize = drawSize;
+			if (_fnPrimaryPSO == nil || _fnWavefrontArgsPSO == nil || _fnOcclusionPSO == nil) {
+				NSLog(@"error: Failed to created pipeline state object, error %@.", error);
+				return nil;
+			}
 		}
 
-		if (threadgroupSize > threadgroupSizeMax) {
-			NSLog(@"error: group size exceeds limit (%u)", threadgroupSizeMax);
-			[[NSApplication sharedApplication] terminate:nil];
-			return nil;
+		if (dynamic_resolution()) {
+			id<MTLFunction> fnUpsample = [defaultLibrary newFunctionWithName:@"upsample"];
+			_fnUpsamplePSO = fnUpsample ? [_device newComputePipelineStateWithFunction:fnUpsample error:&error] : nil;
+
+			if (_fnUpsamplePSO == nil) {
+				NSLog(@"error: Failed to created pipeline state object, error %@.", error);
+				return nil;
+			}
 		}
 
-		unsigned threadgroupWidth = param.group_w != -1U ? param.group_w : (unsigned) _fnMonoPSO.threadExecutionWidth;
-		if (threadgroupWidth > draw_w) {
-			threadgroupWidth = draw_w;
+		nonuniform_groups = [_device supportsFamily:MTLGPUFamilyMac2] || [_device supportsFamily:MTLGPUFamilyApple4];
+
+		// enumerate the runs of the sweep matrix; a dimension of no values takes its single value from the CLI
+		const bool sweeping = MODE_SWEEP == param.mode;
+		const struct sweep_param *const sweep = &param.sweep;
+		const uint32_t threadgroupSizeMax = (uint32_t) _fnMonoPSO.maxTotalThreadsPerThreadgroup;
+		const uint32_t threadgroupWidth = (uint32_t) _fnMonoPSO.threadExecutionWidth;
+		const char *const device_name = _device.name.UTF8String;
+		unsigned drawSize = 0;
+		unsigned drawWidth = 0;
+		unsigned drawHeight = 0;
+
+		// autotune: a run per candidate group size of the screen, of whole SIMD groups, over the timeline slice
+		if (MODE_AUTOTUNE == param.mode) {
+			const uint32_t frames = MAX((uint32_t) (param.tune_span * param.image_hz + .5f), 1U);
+
+			for (uint32_t gw = 4; gw <= 64; gw *= 2) {
+				for (uint32_t gh = 1; gh <= 32; gh *= 2) {
+					uint32_t group_w = gw;
+					uint32_t group_h = gh;
+
+					if (gw * gh > threadgroupSizeMax || gw * gh % threadgroupWidth || sweep_run_count == max_sweep_runs ||
+						!fit_group(param.image_w, param.image_h, threadgroupSizeMax, threadgroupWidth, &group_w, &group_h)) {
+						continue;
+					}
+
+					struct sweep_run *const run = sweep_run + sweep_run_count++;
+
+					run->image_w = param.image_w;
+					run->image_h = param.image_h;
+					run->image_hz = param.image_hz;
+					run->group_w = group_w;
+					run->group_h = group_h;
+					run->frame_msk = param.frame_msk;
+					run->frames = frames;
+					run->interval_ns = (uint64_t *) malloc(run->frames * sizeof(uint64_t));
+					run->build_ns = (uint64_t *) malloc(run->frames * sizeof(uint64_t));
+					run->gpu_ns = (atomic_ullong *) calloc(run->frames, sizeof(atomic_ullong));
+				}
+			}
+
+			drawSize = param.image_w * param.image_h;
+			drawWidth = param.image_w;
+			drawHeight = param.image_h;
 		}
+		else {
+			for (uint32_t si = 0; si < MAX(sweep->screen_count, 1U); si++) {
+				for (uint32_t gi = 0; gi < MAX(sweep->group_count, 1U); gi++) {
+					for (uint32_t ri = 0; ri < MAX(sweep->rng_count, 1U); ri++) {
+						for (uint32_t fi = 0; fi < MAX(sweep->frames_count, 1U); fi++) {
+							struct sweep_run *const run = sweep_run + sweep_run_count;
+
+							run->image_w = sweep->screen_count ? sweep->screen[si][0] : param.image_w;
+							run->image_h = sweep->screen_count ? sweep->screen[si][1] : param.image_h;
+							run->image_hz = sweep->screen_count ? sweep->screen[si][2] : param.image_hz;
+							run->group_w = sweep->group_count ? sweep->group[gi][0] : param.group_w;
+							run->group_h = sweep->group_count ? sweep->group[gi][1] : param.group_h;
+							run->frame_msk = sweep->rng_count ? sweep->frame_msk[ri] : param.frame_msk;
+							run->frames = sweep->frames_count ? (sweep->frames[fi] ? sweep->frames[fi] :
+								(uint32_t) (sweep->seconds[fi] * run->image_hz + .5f)) : param.frames;
 
-		param.group_w = threadgroupWidth;
-		param.group_h = threadgroupSize / threadgroupWidth;
+							// a default group size is that of the tuning cache for the GPU and screen, if any
+							uint32_t shape[2];
 
-		NSLog(@"grid size (%u, %u), group size (%u, %u)", param.image_w, param.image_h, param.group_w, param.group_h);
+							if (run->group_w == -1U && 0 == tune_cache_get(TUNE_GPU, device_name, run->image_w, run->image_h, shape)) {
+								run->group_w = shape[0];
+								run->group_h = shape[1];
+							}
 
-		if (draw_w % param.group_w || draw_h % param.group_h) {
-			NSLog(@"error: grid size not a multiple of group size");
+							// skip runs of no fitting group size, unless this is the only run
+							if (!fit_group(run->image_w, run->image_h, threadgroupSizeMax, threadgroupWidth, &run->group_w, &run->group_h)) {
+								if (!sweeping) {
+									[[NSApplication sharedApplication] terminate:nil];
+									return nil;
+								}
+
+								NSLog(@"warning: skipping sweep run of screen %ux%u@%u", run->image_w, run->image_h, run->image_hz);
+								continue;
+							}
+
+							if (sweeping && (run->frames == -1U || run->frames == 0)) {
+								NSLog(@"error: sweep runs need a frame count");
+								[[NSApplication sharedApplication] terminate:nil];
+								return nil;
+							}
+
+							if (sweeping) {
+								run->interval_ns = (uint64_t *) malloc(run->frames * sizeof(uint64_t));
+								run->build_ns = (uint64_t *) malloc(run->frames * sizeof(uint64_t));
+								run->gpu_ns = (atomic_ullong *) calloc(run->frames, sizeof(atomic_ullong));
+							}
+
+							drawSize = MAX(drawSize, run->image_w * run->image_h);
+							drawWidth = MAX(drawWidth, run->image_w);
+							drawHeight = MAX(drawHeight, run->image_h);
+							sweep_run_count++;
+						}
+					}
+				}
+			}
+		}
+
+		if (sweep_run_count == 0) {
+			NSLog(@"error: no sweep run to do");
 			[[NSApplication sharedApplication] terminate:nil];
 			return nil;
 		}
 
+		apply_run(sweep_run);
+		reset_buffering();
+		reset_resolution();
+
 		_commandQueue = [_device newCommandQueue];
 
+		const uint64_t setup_start = time_ns();
+
 		if (content_init(&cont_init_arg)) {
 			[[NSApplication sharedApplication] terminate:nil];
 		}
 
+		sweep_run[0].setup_ns = time_ns() - setup_start;
+
 		for (size_t bi = 0; bi < n_buffering; bi++) {
 			for (size_t di = 0; di < buffer_designation_count; di++) {
 				_src_buffer[bi][di] = [_device newBufferWithLength:cont_init_arg.buffer_size[di]
@@ -99,129 +777,611 @@ struct content_init_arg cont_init_arg;
 			}
 		}
 
+		// destination and hit buffers, and the scaled frame of dynamic resolution, fit the largest grid of all runs
 #if USE_DST_BUFFER
 		const NSUInteger bufferLen = drawSize * sizeof(uint8_t);
 
 		for (size_t bi = 0; bi < n_buffering; bi++) {
 			_dst_buffer[bi] = [_device newBufferWithLength:bufferLen
 												   options:MTLResourceStorageModeShared];
+			_post_buffer[bi] = [_device newBufferWithLength:bufferLen
+													options:MTLResourceStorageModeShared];
+		}
+
+#else
+		if (dynamic_resolution()) {
+			MTLTextureDescriptor *desc = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:MTLPixelFormatR8Unorm
+																							width:drawWidth
+																						   height:drawHeight
+																						mipmapped:NO];
+			desc.usage = MTLTextureUsageShaderRead | MTLTextureUsageShaderWrite | MTLTextureUsageRenderTarget;
+			desc.storageMode = MTLStorageModePrivate;
+			_scaled_texture = [_device newTextureWithDescriptor:desc];
 		}
 
 #endif
+		if (param.flags & FLAG_WAVEFRONT) {
+			_hit_buffer = [_device newBufferWithLength:drawSize * hitpoint_size
+											   options:MTLResourceStorageModePrivate];
+			_hit_count = [_device newBufferWithLength:sizeof(uint32_t)
+											  options:MTLResourceStorageModePrivate];
+			_dispatch_args = [_device newBufferWithLength:sizeof(MTLDispatchThreadgroupsIndirectArguments)
+												  options:MTLResourceStorageModePrivate];
+		}
 	}
 
 	return self;
 }
 
+// Encode a dispatch of a thread per pixel; partial groups at the edges where the group size does not divide the grid
+- (void)dispatchGrid:(nonnull id<MTLComputeCommandEncoder>)computeEncoder
+			   width:(size_t)draw_w
+			  height:(size_t)draw_h
+		  groupWidth:(size_t)group_w
+		 groupHeight:(size_t)group_h
+{
+	if (draw_w % group_w || draw_h % group_h) {
+		[computeEncoder dispatchThreads:MTLSizeMake(draw_w, draw_h, 1)
+				  threadsPerThreadgroup:MTLSizeMake(group_w, group_h, 1)];
+		return;
+	}
+
+	[computeEncoder dispatchThreadgroups:MTLSizeMake(draw_w / group_w, draw_h / group_h, 1)
+				   threadsPerThreadgroup:MTLSizeMake(group_w, group_h, 1)];
+}
+
+// Encode the clear of the pixels of a frame outside the given span of the dispatch, i.e. x_first, y_first, x_last,
+// y_last: with destination buffers, a fill of the rows above and below the span, or of the whole frame if the span is
+// short of the frame width, as the pixels left and right of it are not contiguous -- a fill costs a fraction of the
+// tracing it saves; without, a clear of the whole texture
+- (void)encodeClear:(nonnull id<MTLCommandBuffer>)commandBuffer
+			   slot:(uint32_t)slot
+			texture:(nullable id<MTLTexture>)texture
+			   span:(const uint32_t *)span
+			  width:(size_t)draw_w
+			 height:(size_t)draw_h
+{
+#if USE_DST_BUFFER
+	id<MTLBlitCommandEncoder> blitEncoder = [commandBuffer blitCommandEncoder];
+
+	if (span[0] == 0 && span[2] == draw_w && span[1] < span[3]) {
+		[blitEncoder fillBuffer:_dst_buffer[slot] range:NSMakeRange(0, span[1] * draw_w) value:0];
+		[blitEncoder fillBuffer:_dst_buffer[slot] range:NSMakeRange(span[3] * draw_w, (draw_h - span[3]) * draw_w) value:0];
+	}
+	else {
+		[blitEncoder fillBuffer:_dst_buffer[slot] range:NSMakeRange(0, draw_h * draw_w) value:0];
+	}
+
+	[blitEncoder endEncoding];
+
+#else
+	MTLRenderPassDescriptor *pass = [MTLRenderPassDescriptor renderPassDescriptor];
+	pass.colorAttachments[0].texture = texture;
+	pass.colorAttachments[0].loadAction = MTLLoadActionClear;
+	pass.colorAttachments[0].storeAction = MTLStoreActionStore;
+	pass.colorAttachments[0].clearColor = MTLClearColorMake(0.0, 0.0, 0.0, 1.0);
+
+	[[commandBuffer renderCommandEncoderWithDescriptor:pass] endEncoding];
+
+#endif
+}
+
+// Encode the upsample of a frame rendered at a fraction of the screen to a drawable of the screen; with destination
+// buffers, the frame is that of the given buffer
+- (void)encodeUpsample:(nonnull id<MTLCommandBuffer>)commandBuffer
+				  slot:(uint32_t)slot
+				source:(nullable id<MTLBuffer>)source
+			   texture:(nonnull id<MTLTexture>)texture
+{
+	const uint32_t dim[4] = { frame_slot[slot].render_w, frame_slot[slot].render_h, param.image_w, param.image_h };
+	const size_t group_w = _fnUpsamplePSO.threadExecutionWidth;
+	const size_t group_h = _fnUpsamplePSO.maxTotalThreadsPerThreadgroup / group_w;
+
+	id<MTLComputeCommandEncoder> computeEncoder = [commandBuffer computeCommandEncoder];
+
+	[computeEncoder setComputePipelineState:_fnUpsamplePSO];
+
+#if USE_DST_BUFFER
+	[computeEncoder setBuffer:source
+					   offset:0
+					  atIndex:0];
+
+#else
+	[computeEncoder setTexture:_scaled_texture
+					   atIndex:1];
+
+#endif
+	[computeEncoder setBytes:dim length:sizeof(dim) atIndex:1];
+	[computeEncoder setTexture:texture
+					   atIndex:0];
+
+	// whole groups over the screen, the kernel skipping pixels past the edges
+	[computeEncoder dispatchThreadgroups:MTLSizeMake((dim[2] + group_w - 1) / group_w, (dim[3] + group_h - 1) / group_h, 1)
+				   threadsPerThreadgroup:MTLSizeMake(group_w, group_h, 1)];
+
+	[computeEncoder endEncoding];
+}
+
+// Encode the source and destination buffers of a frame slot
+- (void)setFrameBuffers:(nonnull id<MTLComputeCommandEncoder>)computeEncoder
+				   slot:(uint32_t)slot
+				texture:(nullable id<MTLTexture>)texture
+{
+	uint32_t b_idx = 0;
+	uint32_t t_idx = 0;
+
+	for (size_t di = 0; di < buffer_designation_count; di++) {
+		[computeEncoder setBuffer:_src_buffer[slot][di]
+						   offset:0
+						  atIndex:b_idx++];
+	}
+
+#if USE_DST_BUFFER
+	[computeEncoder setBuffer:_dst_buffer[slot]
+					   offset:0
+					  atIndex:b_idx++];
+
+#else
+	[computeEncoder setTexture:texture
+					   atIndex:t_idx++];
+
+#endif
+}
+
+// Release the done slots at the ring tail; with destination buffers, present the latest of them
+- (void)retireSlots:(nonnull MTKView *)view
+{
+	uint32_t latest = -1U;
+
+	for (; slot_tail != slot_head; slot_tail++) {
+		const uint32_t slot = slot_tail % n_buffering;
+
+		if (atomic_load_explicit(&frame_slot[slot].state, memory_order_acquire) != SLOT_DONE)
+			break;
+
+		const uint64_t gpu_ns = atomic_load_explicit(&frame_slot[slot].gpu_ns, memory_order_relaxed);
+
+		adapt_buffering(frame_slot[slot].commit_ns - frame_slot[slot].start_ns, gpu_ns);
+		adapt_resolution(gpu_ns, frame_slot[slot].render_w * frame_slot[slot].render_h);
+
+#if USE_DST_BUFFER
+		// a later frame is done, too: skip this one
+		if (latest != -1U) {
+			trace_mark(TRACE_DROP, frame_slot[latest].frame, TRACE_DROP_SUPERSEDED);
+			atomic_store_explicit(&frame_slot[latest].state, SLOT_FREE, memory_order_relaxed);
+		}
+
+		latest = slot;
+
+#else
+		atomic_store_explicit(&frame_slot[slot].state, SLOT_FREE, memory_order_relaxed);
+
+#endif
+	}
+
+#if USE_DST_BUFFER
+	if (latest == -1U)
+		return;
+
+	const uint64_t present_start = trace_time();
+	const size_t draw_w = param.image_w;
+	const size_t draw_h = param.image_h;
+	const uint32_t render_w = frame_slot[latest].render_w;
+	const uint32_t render_h = frame_slot[latest].render_h;
+
+	// post-process the frame, as of its view state, to the post buffer of its slot, blurring with the latest output
+	// if of the same geometry -- that of this very slot, if so, post-processed in place; a neutral view presents the
+	// frame as rendered, and drops the output
+	struct content_frame_arg frame_arg;
+
+	for (size_t di = 0; di < buffer_designation_count; di++) {
+		frame_arg.buffer[di] = _src_buffer[latest][di].contents;
+	}
+
+	const bool history = post_w == render_w && post_h == render_h;
+	id<MTLBuffer> source = _dst_buffer[latest];
+
+	if (cpupost_frame(&frame_arg, _dst_buffer[latest].contents, history ? _post_buffer[post_slot].contents : NULL,
+			_post_buffer[latest].contents, render_w, render_h)) {
+		source = _post_buffer[latest];
+		post_slot = latest;
+		post_w = render_w;
+		post_h = render_h;
+	}
+	else {
+		post_w = 0;
+		post_h = 0;
+	}
+
+	id<CAMetalDrawable> drawable = view.currentDrawable;
+	id<MTLTexture> texture = drawable.texture;
+
+	// present drawable; a frame short of the screen is upsampled on the GPU, ahead of any later frame to the same
+	// destination buffer, as command buffers run in order
+	{
+		id<MTLCommandBuffer> commandBuffer = [_commandQueue commandBuffer];
+
+		if (render_w != draw_w || render_h != draw_h) {
+			[self encodeUpsample:commandBuffer slot:latest source:source texture:texture];
+		}
+		else {
+			const uint8_t *const buffer = source.contents;
+			[texture replaceRegion:MTLRegionMake2D(0, 0, draw_w, draw_h)
+					   mipmapLevel:0
+						 withBytes:buffer
+					   bytesPerRow:draw_w * sizeof(*buffer)];
+		}
+
+		[commandBuffer presentDrawable:drawable];
+		[commandBuffer commit];
+	}
+
+	atomic_store_explicit(&frame_slot[latest].state, SLOT_FREE, memory_order_relaxed);
+	trace_span(TRACE_PRESENT, frame_slot[latest].frame, present_start, trace_time(), 0);
+
+#endif
+}
+
 // Called whenever the view needs to render a frame.
 - (void)drawInMTKView:(nonnull MTKView *)view
 {
-	static uint32_t frame_id;
-	uint32_t frame = frame_id++;
+	struct sweep_run *const run = sweep_run + sweep_run_idx;
+
+	@autoreleasepool {
+		[self retireSlots:view];
+	}
 
 	// have we produced enough frames?
-	if (frame == param.frames) {
-		[[NSApplication sharedApplication] terminate:nil];
+	if (frame_id == run->frames) {
+		if (!multi_run()) {
+			[[NSApplication sharedApplication] terminate:nil];
+			return;
+		}
+
+		// let the frames of the run retire before the next run
+		if (slot_head != slot_tail)
+			return;
+
+		if (++sweep_run_idx == sweep_run_count) {
+			if (MODE_AUTOTUNE == param.mode)
+				store_autotune(_device.name.UTF8String);
+			else
+				write_sweep_report();
+
+			[[NSApplication sharedApplication] terminate:nil];
+			return;
+		}
+
+		[self startRun:sweep_run + sweep_run_idx view:view];
 		return;
 	}
 
-	static atomic_uint unprocessed;
+	// a window resize of the run is yet to reach the drawable
+	if (multi_run() && (view.drawableSize.width != param.image_w || view.drawableSize.height != param.image_h))
+		return;
+
+	const uint32_t frame = frame_id++;
+	const uint64_t frame_start = trace_time();
 
-	if (atomic_fetch_add(&unprocessed, 1) == n_buffering - 1) {
-		atomic_fetch_sub(&unprocessed, 1);
+	// no free slot within the depth: drop the frame, and deepen the buffering -- unless the GPU takes the frame
+	// period or more on average, as deeper buffering then only queues more frames, and adds to the latency
+	if (slot_head - slot_tail == slot_depth) {
 		NSLog(@"warning: GPU overload!");
+		trace_mark(TRACE_DROP, frame, TRACE_DROP_OVERLOAD);
+		run->overloads++;
+
+		if (slot_depth < n_buffering && gpu_mean < 1e9f / param.image_hz) {
+			slot_depth++;
+			slot_depth_max = MAX(slot_depth_max, slot_depth);
+			slot_calm = 0;
+		}
+
+		// at dynamic resolution, also drop the scale by a step
+		if (dynamic_resolution() && res_step < res_step_max) {
+			res_step++;
+			res_step_peak = MAX(res_step_peak, res_step);
+			res_calm = 0;
+		}
+
+		trace_mark(TRACE_BUFFERING, frame, slot_depth);
 		return;
 	}
 
+	const uint32_t slot = slot_head++ % n_buffering;
+	struct frame_slot *const fslot = frame_slot + slot;
+
+	assert(atomic_load_explicit(&fslot->state, memory_order_relaxed) == SLOT_FREE);
+	atomic_store_explicit(&fslot->state, SLOT_BUILDING, memory_order_relaxed);
+	fslot->frame = frame;
+	fslot->start_ns = frame_start;
+	get_render_size(res_step, &fslot->render_w, &fslot->render_h);
+	atomic_store_explicit(&fslot->gpu_ns, 0, memory_order_relaxed);
+
+	trace_mark(TRACE_QUEUE_DEPTH, frame, slot_head - slot_tail);
+	trace_mark(TRACE_BUFFERING, frame, slot_depth);
+
+	if (dynamic_resolution()) {
+		trace_mark(TRACE_RESOLUTION, frame, (uint32_t) (get_render_scale(res_step) * 100.f + .5f));
+	}
+
 	@autoreleasepool {
 
 		struct content_frame_arg frame_arg;
-		frame_arg.buffer[buffer_octet] = _src_buffer[frame % n_buffering][buffer_octet].contents;
-		frame_arg.buffer[buffer_leaf]  = _src_buffer[frame % n_buffering][buffer_leaf].contents;
-		frame_arg.buffer[buffer_voxel] = _src_buffer[frame % n_buffering][buffer_voxel].contents;
-		frame_arg.buffer[buffer_carb]  = _src_buffer[frame % n_buffering][buffer_carb].contents;
+
+		for (size_t di = 0; di < buffer_designation_count; di++) {
+			frame_arg.buffer[di] = _src_buffer[slot][di].contents;
+		}
+
+		const uint64_t build_start = time_ns();
 
 		if (content_frame(frame_arg, frame)) {
 			[[NSApplication sharedApplication] terminate:nil];
 		}
 
-		const size_t draw_w = param.image_w;
-		const size_t draw_h = param.image_h;
+		const uint32_t scene = content_scene();
+
+		// sweep mode stats of the drawn frame; GPU time is accumulated by the command buffers of the frame
+		atomic_ullong *const gpu_ns = run->gpu_ns ? run->gpu_ns + run->drawn : NULL;
+
+		if (run->gpu_ns) {
+			const uint64_t build_end = time_ns();
+			run->build_ns[run->drawn++] = build_end - build_start;
+
+			if (run->last_draw) {
+				const uint64_t interval = build_start - run->last_draw;
+				run->interval_ns[run->intervals++] = interval;
+
+				if (interval * run->image_hz > 1500000000ULL)
+					run->late_frames++;
+			}
+
+			run->last_draw = build_start;
+			run->scale_sum += get_render_scale(res_step);
+		}
+
+		if (dynamic_resolution()) {
+			res_frames++;
+			res_scale_sum += get_render_scale(res_step);
+		}
+
+		// at dynamic resolution, the kernels take their ray directions from a grid short of the screen
+		const size_t draw_w = fslot->render_w;
+		const size_t draw_h = fslot->render_h;
 		const size_t group_w = param.group_w;
 		const size_t group_h = param.group_h;
 
+		// the primary kernels dispatch over the screen rect of the scene; the pixels outside it miss the scene, and
+		// are cleared in bulk
+		const float *const scene_rect = (const float *) _src_buffer[slot][buffer_carb].contents + carb_rect * 4;
+		uint32_t span[4];
+
+		get_pixel_span(scene_rect[0], scene_rect[2], (uint32_t) draw_w, (uint32_t) group_w, span + 0, span + 2);
+		get_pixel_span(scene_rect[1], scene_rect[3], (uint32_t) draw_h, (uint32_t) group_h, span + 1, span + 3);
+
+		const uint32_t rect[4] = { span[0], span[1], (uint32_t) draw_w, (uint32_t) draw_h };
+		const size_t rect_w = span[2] - span[0];
+		const size_t rect_h = span[3] - span[1];
+		const uint64_t culled = draw_w * draw_h - rect_w * rect_h;
+
+		cull_pixels += culled;
+		frame_pixels += draw_w * draw_h;
+
+		if (run->gpu_ns) {
+			run->cull_pixels += culled;
+			run->pixels += draw_w * draw_h;
+		}
+
+		const uint64_t dispatch_start = trace_time();
+
+		// with destination buffers, the drawable is taken at present time
+#if USE_DST_BUFFER
+		id<MTLTexture> texture = nil;
+
+#else
 		id<CAMetalDrawable> drawable = view.currentDrawable;
 		id<MTLTexture> texture = drawable.texture;
+		const bool scaled = draw_w != param.image_w || draw_h != param.image_h;
+
+		if (scaled) {
+			texture = _scaled_texture;
+		}
 
+#endif
 		// execute compute kernel
-		{
+		if (param.flags & FLAG_WAVEFRONT) {
+			const uint32_t grid[2] = { (uint32_t) draw_w, (uint32_t) draw_h };
+			const uint32_t ao_group_size = (uint32_t) MIN(group_w * group_h, _fnOcclusionPSO.maxTotalThreadsPerThreadgroup);
+
+			// primary pass: shade background, emit compact list of hit pixels
 			id<MTLCommandBuffer> commandBuffer = [_commandQueue commandBuffer];
 
-			id<MTLComputeCommandEncoder> computeEncoder = [commandBuffer computeCommandEncoder];
+			id<MTLBlitCommandEncoder> blitEncoder = [commandBuffer blitCommandEncoder];
+			[blitEncoder fillBuffer:_hit_count range:NSMakeRange(0, sizeof(uint32_t)) value:0];
+			[blitEncoder endEncoding];
 
-			[computeEncoder setComputePipelineState:_fnMonoPSO];
+			if (culled) {
+				[self encodeClear:commandBuffer slot:slot texture:texture span:span width:draw_w height:draw_h];
+			}
 
-			uint32_t b_idx = 0;
-			uint32_t t_idx = 0;
+			id<MTLComputeCommandEncoder> computeEncoder = [commandBuffer computeCommandEncoder];
 
-			for (size_t di = 0; di < buffer_designation_count; di++) {
-				[computeEncoder setBuffer:_src_buffer[frame % n_buffering][di]
-								   offset:0
-								  atIndex:b_idx++];
+			[computeEncoder setComputePipelineState:_fnPrimaryPSO];
+			[self setFrameBuffers:computeEncoder slot:slot texture:texture];
+			[computeEncoder setBuffer:_hit_buffer offset:0 atIndex:wavefront_hitpoint];
+			[computeEncoder setBuffer:_hit_count offset:0 atIndex:wavefront_hit_count];
+			[computeEncoder setBytes:rect length:sizeof(rect) atIndex:kernel_rect];
+
+			if (rect_w && rect_h) {
+				[self dispatchGrid:computeEncoder
+							 width:rect_w
+							height:rect_h
+						groupWidth:group_w
+					   groupHeight:group_h];
 			}
 
-#if USE_DST_BUFFER
-			[computeEncoder setBuffer:_dst_buffer[frame % n_buffering]
-							   offset:0
-							  atIndex:b_idx++];
+			[computeEncoder setComputePipelineState:_fnWavefrontArgsPSO];
+			[computeEncoder setBuffer:_hit_count offset:0 atIndex:0];
+			[computeEncoder setBuffer:_dispatch_args offset:0 atIndex:1];
+			[computeEncoder setBytes:&ao_group_size length:sizeof(ao_group_size) atIndex:2];
 
-#else
-			[computeEncoder setTexture:texture
-							   atIndex:t_idx++];
+			[computeEncoder dispatchThreadgroups:MTLSizeMake(1, 1, 1)
+						   threadsPerThreadgroup:MTLSizeMake(1, 1, 1)];
 
-#endif
-			MTLSize gridSize = MTLSizeMake(draw_w / group_w, draw_h / group_h, 1);
-			MTLSize groupSize = MTLSizeMake(group_w, group_h, 1);
+			[computeEncoder endEncoding];
 
-			[computeEncoder dispatchThreadgroups:gridSize
-						   threadsPerThreadgroup:groupSize];
+			[commandBuffer addCompletedHandler:^(id<MTLCommandBuffer> commandBuffer) {
+				const unsigned long long dt = (commandBuffer.GPUEndTime - commandBuffer.GPUStartTime) * 1e9;
+				atomic_fetch_add(&primary_time, dt);
+				atomic_fetch_add(&scene_time[scene], dt);
+
+				if (gpu_ns)
+					atomic_fetch_add(gpu_ns, dt);
+
+				atomic_fetch_add_explicit(&fslot->gpu_ns, dt, memory_order_relaxed);
+
+				trace_span(TRACE_GPU, frame, commandBuffer.GPUStartTime * 1e9, commandBuffer.GPUEndTime * 1e9, TRACE_PASS_PRIMARY);
+				trace_mark(TRACE_COMPLETION, frame, TRACE_PASS_PRIMARY);
+			}];
+
+			[commandBuffer commit];
+
+			// AO pass: one thread per hit pixel
+			commandBuffer = [_commandQueue commandBuffer];
+			computeEncoder = [commandBuffer computeCommandEncoder];
+
+			[computeEncoder setComputePipelineState:_fnOcclusionPSO];
+			[self setFrameBuffers:computeEncoder slot:slot texture:texture];
+			[computeEncoder setBuffer:_hit_buffer offset:0 atIndex:wavefront_hitpoint];
+			[computeEncoder setBuffer:_hit_count offset:0 atIndex:wavefront_hit_count];
+			[computeEncoder setBytes:grid length:sizeof(grid) atIndex:wavefront_grid];
+
+			[computeEncoder dispatchThreadgroupsWithIndirectBuffer:_dispatch_args
+											  indirectBufferOffset:0
+											 threadsPerThreadgroup:MTLSizeMake(ao_group_size, 1, 1)];
 
 			[computeEncoder endEncoding];
 
 #if USE_DST_BUFFER == 0
+			if (scaled) {
+				[self encodeUpsample:commandBuffer slot:slot source:nil texture:drawable.texture];
+			}
+
 			[commandBuffer presentDrawable:drawable];
 
 #endif
 			[commandBuffer addCompletedHandler:^(id<MTLCommandBuffer> commandBuffer) {
-				atomic_fetch_sub(&unprocessed, 1);
+				const unsigned long long dt = (commandBuffer.GPUEndTime - commandBuffer.GPUStartTime) * 1e9;
+				atomic_fetch_add(&occlusion_time, dt);
+				atomic_fetch_add(&timed_frames, 1);
+				atomic_fetch_add(&scene_time[scene], dt);
+				atomic_fetch_add(&scene_frames[scene], 1);
+
+				if (gpu_ns)
+					atomic_fetch_add(gpu_ns, dt);
+
+				atomic_fetch_add_explicit(&fslot->gpu_ns, dt, memory_order_relaxed);
+
+				trace_span(TRACE_GPU, frame, commandBuffer.GPUStartTime * 1e9, commandBuffer.GPUEndTime * 1e9, TRACE_PASS_OCCLUSION);
+				trace_mark(TRACE_COMPLETION, frame, TRACE_PASS_OCCLUSION);
+
+				fslot->done_ns = time_ns();
+				atomic_store_explicit(&fslot->state, SLOT_DONE, memory_order_release);
 			}];
 
+			fslot->commit_ns = time_ns();
+			atomic_store_explicit(&fslot->state, SLOT_IN_FLIGHT, memory_order_relaxed);
 			[commandBuffer commit];
 
 		}
+		else {
+			id<MTLCommandBuffer> commandBuffer = [_commandQueue commandBuffer];
 
-#if USE_DST_BUFFER
-		if (frame < n_buffering - 1)
-			return;
+			if (culled) {
+				[self encodeClear:commandBuffer slot:slot texture:texture span:span width:draw_w height:draw_h];
+			}
 
-		frame -= n_buffering - 1;
+			id<MTLComputeCommandEncoder> computeEncoder = [commandBuffer computeCommandEncoder];
 
-		const uint8_t *const buffer = _dst_buffer[frame % n_buffering].contents;
-		[texture replaceRegion:MTLRegionMake2D(0, 0, draw_w, draw_h)
-				   mipmapLevel:0
-					 withBytes:buffer
-				   bytesPerRow:draw_w * sizeof(*buffer)];
+			[computeEncoder setComputePipelineState:_fnMonoPSO];
+			[self setFrameBuffers:computeEncoder slot:slot texture:texture];
+			[computeEncoder setBytes:rect length:sizeof(rect) atIndex:kernel_rect];
 
-		// present drawable
-		{
-			id<MTLCommandBuffer> commandBuffer = [_commandQueue commandBuffer];
+			if (rect_w && rect_h) {
+				[self dispatchGrid:computeEncoder
+							 width:rect_w
+							height:rect_h
+						groupWidth:group_w
+					   groupHeight:group_h];
+			}
+
+			[computeEncoder endEncoding];
+
+#if USE_DST_BUFFER == 0
+			if (scaled) {
+				[self encodeUpsample:commandBuffer slot:slot source:nil texture:drawable.texture];
+			}
 
 			[commandBuffer presentDrawable:drawable];
+
+#endif
+			[commandBuffer addCompletedHandler:^(id<MTLCommandBuffer> commandBuffer) {
+				const unsigned long long dt = (commandBuffer.GPUEndTime - commandBuffer.GPUStartTime) * 1e9;
+				atomic_fetch_add(&scene_time[scene], dt);
+				atomic_fetch_add(&scene_frames[scene], 1);
+
+				if (gpu_ns)
+					atomic_fetch_add(gpu_ns, dt);
+
+				atomic_fetch_add_explicit(&fslot->gpu_ns, dt, memory_order_relaxed);
+
+				trace_span(TRACE_GPU, frame, commandBuffer.GPUStartTime * 1e9, commandBuffer.GPUEndTime * 1e9, TRACE_PASS_MONO);
+				trace_mark(TRACE_COMPLETION, frame, TRACE_PASS_MONO);
+
+				fslot->done_ns = time_ns();
+				atomic_store_explicit(&fslot->state, SLOT_DONE, memory_order_release);
+			}];
+
+			fslot->commit_ns = time_ns();
+			atomic_store_explicit(&fslot->state, SLOT_IN_FLIGHT, memory_order_relaxed);
 			[commandBuffer commit];
+
 		}
 
+		const uint64_t dispatch_end = trace_time();
+
+		trace_span(TRACE_DISPATCH, frame, dispatch_start, dispatch_end, 0);
+		trace_span(TRACE_FRAME, frame, frame_start, dispatch_end, 0);
+	}
+}
+
+// Start a run of the sweep: reconfigure the view and rewind the content; the frames in flight must have retired
+- (void)startRun:(nonnull const struct sweep_run *)run
+			view:(nonnull MTKView *)view
+{
+	apply_run(run);
+	frame_id = 0;
+	reset_buffering();
+	reset_resolution();
+
+#if USE_DST_BUFFER
+	post_w = 0;
+	post_h = 0;
+
 #endif
+	const size_t retina = view.window.backingScaleFactor == 2.f ? 1 : 0;
+	[view.window setContentSize:NSMakeSize(param.image_w >> retina, param.image_h >> retina)];
+	view.preferredFramesPerSecond = param.image_hz;
+
+	const uint64_t setup_start = time_ns();
+
+	if (content_rewind()) {
+		[[NSApplication sharedApplication] terminate:nil];
 	}
+
+	sweep_run[sweep_run_idx].setup_ns = time_ns() - setup_start;
+
+	NSLog(@"sweep run %u of %u: screen %ux%u@%u, group size (%u, %u), rng %s, %u frames", sweep_run_idx + 1, sweep_run_count,
+		param.image_w, param.image_h, param.image_hz, param.group_w, param.group_h, param.frame_msk ? "var" : "invar", run->frames);
 }
 
 // Called whenever view changes orientation or is resized
@@ -233,6 +1393,43 @@ struct content_init_arg cont_init_arg;
 
 - (void) dealloc
 {
+	const unsigned frames = atomic_load(&timed_frames);
+
+	if (frames) {
+		NSLog(@"wavefront GPU time per frame: primary %.3f ms, AO %.3f ms",
+			atomic_load(&primary_time) * 1e-6 / frames,
+			atomic_load(&occlusion_time) * 1e-6 / frames);
+	}
+
+	for (size_t si = 0; si < content_scene_count; si++) {
+		const unsigned frames = atomic_load(&scene_frames[si]);
+
+		if (frames) {
+			NSLog(@"scene %zu GPU time per frame: %.3f ms over %u frames", si + 1, atomic_load(&scene_time[si]) * 1e-6 / frames, frames);
+		}
+	}
+
+	for (size_t ri = 0; ri < sweep_run_count; ri++) {
+		free(sweep_run[ri].interval_ns);
+		free(sweep_run[ri].build_ns);
+		free(sweep_run[ri].gpu_ns);
+	}
+
+	NSLog(@"buffering depth: %u at exit, %u at peak, of %u slots", slot_depth, slot_depth_max, (unsigned) n_buffering);
+
+	if (frame_pixels) {
+		NSLog(@"screen rect culling: %.4f of pixels cleared untraced", (double) cull_pixels / frame_pixels);
+	}
+
+	if (res_frames) {
+		NSLog(@"render scale: %.4f at exit, %.4f at least, %.4f mean over %u frames",
+			get_render_scale(res_step), get_render_scale(res_step_peak), res_scale_sum / res_frames, res_frames);
+	}
+
+	if (param.trace_out) {
+		trace_write(param.trace_out);
+	}
+
 	content_deinit();
 }
 
@@ -1,11 +1,11 @@
 #!/bin/bash
 
 # This script targets M2 Max (30-core GPU) level of performance on a 120Hz display
+# Hz = 120 / 4, 120 / 2 and 120 / 1, each with frame-invariant and frame-variant RNG, over the same time span;
+# per-run frame times, build times and dropped frames go to progressive_120.csv/.json
 
-cd "DerivedData/Build/Products/Release/problem_7.app/Contents/MacOS"
+out="$PWD/progressive_120"
 
-/usr/bin/time ./problem_7 -screen "3840 2160 30"  -frames 500 -frame_invar_rng
+cd "DerivedData/Build/Products/Release/problem_7.app/Contents/MacOS"
 
-/usr/bin/time ./problem_7 -screen "3840 2160 30"  -frames 500  # Hz = 120 / 4
-/usr/bin/time ./problem_7 -screen "3840 2160 60"  -frames 1000 # Hz = 120 / 2
-/usr/bin/time ./problem_7 -screen "3840 2160 120" -frames 2000 # Hz = 120 / 1
+./problem_7 -sweep "screen=3840x2160@30,3840x2160@60,3840x2160@120 rng=invar,var frames=16.67s" -sweep_out "$out"
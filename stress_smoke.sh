@@ -0,0 +1,18 @@
+#!/bin/bash
+
+# Smoke-test the stress scenes: build each kind over a few frames and render a short CPU convergence of it, at a
+# small voxel count and at the cap of -stress; any failure to build or render aborts the script with the exit code
+# of the run
+
+set -e
+
+cd "DerivedData/Build/Products/Release/problem_7.app/Contents/MacOS"
+
+for kind in uniform clustered heightfield shell; do
+	for voxels in 4096 16384; do
+		./problem_7 -stress "$kind $voxels 0.1" -build_bench "30 1 2" > /dev/null
+		./problem_7 -stress "$kind $voxels 0.1" -screen "640 360 60" -converge "4 100" -frames 8 > /dev/null
+	done
+done
+
+echo "stress smoke test passed"
@@ -1,8 +1,11 @@
 #!/bin/bash
 
 # This script targets M1 (8-core GPU) level of performance on a 60Hz display
+# Hz = 60 / 2 and 60 / 1, over the same time span; per-run frame times, build times and dropped frames go to
+# versus_030_060.csv/.json
+
+out="$PWD/versus_030_060"
 
 cd "DerivedData/Build/Products/Release/problem_7.app/Contents/MacOS"
 
-/usr/bin/time ./problem_7 -screen "2560 1712 30"  -frames 500  # Hz = 60 / 2
-/usr/bin/time ./problem_7 -screen "2560 1712 60"  -frames 1000 # Hz = 60 / 1
+./problem_7 -sweep "screen=2560x1712@30,2560x1712@60 frames=16.67s" -sweep_out "$out"
@@ -0,0 +1,10 @@
+#!/bin/bash
+
+# This script targets M2 Max (30-core GPU) level of performance on a 120Hz display
+# Compare closest-hit child ordering by distance sort vs by ray octant over the full timeline;
+# per-scene GPU times are logged at exit
+
+cd "DerivedData/Build/Products/Release/problem_7.app/Contents/MacOS"
+
+/usr/bin/time ./problem_7 -screen "3840 2160 120" -frames 24000
+/usr/bin/time ./problem_7 -screen "3840 2160 120" -frames 24000 -octant_order
@@ -1,8 +1,11 @@
 #!/bin/bash
 
 # This script targets M2 Max (30-core GPU) level of performance on a 120Hz display
+# Frame-invariant vs frame-variant RNG; per-run frame times, build times and dropped frames go to
+# versus_invar_120.csv/.json
+
+out="$PWD/versus_invar_120"
 
 cd "DerivedData/Build/Products/Release/problem_7.app/Contents/MacOS"
 
-/usr/bin/time ./problem_7 -screen "3840 2160 120" -frames 2000 -frame_invar_rng
-/usr/bin/time ./problem_7 -screen "3840 2160 120" -frames 2000
+./problem_7 -sweep "screen=3840x2160@120 rng=invar,var frames=2000" -sweep_out "$out"